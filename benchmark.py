@@ -2,13 +2,16 @@
 
 import sys
 import os
+import json
 import signal
+import tempfile
 from subprocess import Popen, PIPE, TimeoutExpired
 from time import monotonic as timer
 
 
 TIMEOUT = 60*60*12 # in seconds
-TIMEOUT_GIST = "#gist=to:t/o;to:t/o;to:t/o"
+WORKERS = 1 # more than one runs all tasks in a single batch of parallel seal workers
+TIMEOUT_GIST = "#gist=to:t/o:-;to:t/o:-;to:t/o:-"
 EXAMPLES_DIR = "examples/"
 
 HP = 1
@@ -88,42 +91,82 @@ def run_test(name, smr):
 		get_linearizability_info(gist_linea)
 	), flush=True)
 
+def run_batch(tests):
+	# one batch job per task; the report lists them in manifest order
+	tasks = [(name, smr, flag) for (name, smr) in tests for flag in ['-t', '-a', '-l']]
+	with tempfile.TemporaryDirectory() as tmp:
+		manifest = os.path.join(tmp, "manifest.txt")
+		report = os.path.join(tmp, "report.json")
+		with open(manifest, 'w') as file:
+			for (name, smr, flag) in tasks:
+				path_program = os.path.abspath(EXAMPLES_DIR + SMR_PROGRAM_FOLDER[smr] + "/" + name + ".cola")
+				path_smr = os.path.abspath(EXAMPLES_DIR + SMR_FILE[smr])
+				file.write(" ".join([path_program, path_smr, flag] + ADDITIONAL_ARGS[smr]) + "\n")
+		args = ['./seal', '--batch', manifest, '--batchworkers', str(WORKERS), '--batchtimeout', str(TIMEOUT), '--batchreport', report]
+		with Popen(args, stderr=PIPE, stdout=PIPE, preexec_fn=os.setsid, universal_newlines=True) as process:
+			process.communicate()
+		with open(report) as file:
+			jobs = json.load(file)["jobs"]
+
+	def to_gist(job):
+		if job["verdict"] == "timeout": return TIMEOUT_GIST
+		if job["verdict"] == "aborted": return "#gist=?:-;?:-;?:-"
+		return "#gist=" + job["gist"]
+
+	for index, (name, smr) in enumerate(tests):
+		if index == 0 or tests[index-1][1] != smr:
+			print_head(SMR_NAME[smr])
+		gist_types, gist_annot, gist_linea = [to_gist(job) for job in jobs[3*index:3*index+3]]
+		print("{:<48}   |   {:>15}   |   {:>15}   |   {:>15} ".format(
+			SMR_PROGRAM_FOLDER[smr] + "/" + name,
+			get_type_info(gist_types),
+			get_annotation_info(gist_annot),
+			get_linearizability_info(gist_linea)
+		), flush=True)
+
 def print_head(smr):
 	print()
 	print()
 	print("{:<48}   |   {:>15}   |   {:>15}   |   {:>15} ".format(smr, "Types", "Annotations", "Linearizability"), flush=True)
 	print("---------------------------------------------------+---------------------+---------------------+----------------------", flush=True)
 
+TESTS = [
+	("TreiberStack_transformed", HP),
+	("TreiberOptimizedStack_transformed", HP),
+	("MichaelScottQueue_transformed", HP),
+	("DGLM_transformed", HP),
+	("VechevDCasSet_transformed", HP),
+	("VechevCasSet_transformed", HP),
+	("OHearnSet_transformed", HP),
+	("MichaelSet_transformed", HP),
+	("TreiberStack", EBR),
+	("MichaelScottQueue", EBR),
+	("DGLM", EBR),
+	("VechevDCasSet", EBR),
+	("VechevCasSet", EBR),
+	("OHearnSet", EBR),
+	("MichaelSet", EBR),
+]
+
 def main():
 	print("(Timeout per task/cell is set to: " + str(TIMEOUT) + "s.)", flush=True)
 
-	# HP
-	print_head(SMR_NAME[HP])
-	run_test("TreiberStack_transformed", HP)
-	run_test("TreiberOptimizedStack_transformed", HP)
-	run_test("MichaelScottQueue_transformed", HP)
-	run_test("DGLM_transformed", HP)
-	run_test("VechevDCasSet_transformed", HP)
-	run_test("VechevCasSet_transformed", HP)
-	run_test("OHearnSet_transformed", HP)
-	run_test("MichaelSet_transformed", HP)
-
-	# EBR
-	print_head(SMR_NAME[EBR])
-	run_test("TreiberStack", EBR)
-	run_test("MichaelScottQueue", EBR)
-	run_test("DGLM", EBR)
-	run_test("VechevDCasSet", EBR)
-	run_test("VechevCasSet", EBR)
-	run_test("OHearnSet", EBR)
-	run_test("MichaelSet", EBR)
+	if WORKERS > 1:
+		run_batch(TESTS)
+		return
 
+	for index, (name, smr) in enumerate(TESTS):
+		if index == 0 or TESTS[index-1][1] != smr:
+			print_head(SMR_NAME[smr])
+		run_test(name, smr)
 
 if __name__ == '__main__':
 	if len(sys.argv) > 1:
-		if len(sys.argv) != 2:
+		if len(sys.argv) > 3:
 			raise Exception("Wrong number of arguments!")
 		TIMEOUT = int(sys.argv[1])
+		if len(sys.argv) == 3:
+			WORKERS = int(sys.argv[2])
 
 	try:
 		main()
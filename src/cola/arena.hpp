@@ -0,0 +1,89 @@
+#pragma once
+#ifndef COLA_ARENA
+#define COLA_ARENA
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace cola {
+
+	/** Pooled bump allocator for AST and observer nodes.
+	  * Memory is carved from large chunks; freed nodes go to per-size free lists and are reused by later allocations.
+	  * Chunks are returned to the system in bulk once the arena is released (see 'make') and all of its nodes are gone.
+	  * Nodes allocated while no 'ArenaScope' is active come from a process-wide arena that is never released.
+	  */
+	class NodeArena {
+		private:
+			static constexpr std::size_t ALIGNMENT = alignof(std::max_align_t);
+			static constexpr std::size_t NUM_SIZE_CLASSES = 32; // nodes up to 512 bytes (including header)
+			static constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+			const bool _synchronized;
+			std::mutex _mutex; // taken only if '_synchronized'
+			std::vector<void*> _chunks;
+			char* _cursor = nullptr;
+			char* _end = nullptr;
+			std::array<void*, NUM_SIZE_CLASSES> _free_lists{};
+			std::size_t _live = 0;
+			bool _released = false;
+
+			NodeArena(bool synchronized) : _synchronized(synchronized) {}
+			~NodeArena();
+			std::unique_lock<std::mutex> lock();
+			void* allocate_block(std::size_t size_class);
+			void release();
+
+		public:
+			NodeArena(const NodeArena& other) = delete;
+			NodeArena& operator=(const NodeArena& other) = delete;
+
+			/** Creates a new arena. Dropping the last reference releases it; its chunks are freed as soon as no nodes are live.
+			  * An arena that is not 'synchronized' saves a lock per allocation and deallocation, but must not be used by
+			  * several threads concurrently: allocating nodes in it, freeing them, and dropping references to it.
+			  * Handing it to another thread that otherwise synchronizes with the current one (e.g. via a future) is fine.
+			  */
+			static std::shared_ptr<NodeArena> make(bool synchronized=true);
+
+			/** Process-wide arena; never released. Used for nodes with static storage duration.
+			  */
+			static NodeArena& global();
+
+			/** Arena used by the calling thread: the innermost active 'ArenaScope', or the process-wide arena.
+			  */
+			static NodeArena& current();
+
+			static void* allocate(std::size_t size);
+
+			static void deallocate(void* ptr) noexcept;
+
+		friend class ArenaScope;
+	};
+
+	/** Directs node allocations of the calling thread to the given arena for the lifetime of the scope object.
+	  * A null arena leaves the current one untouched.
+	  */
+	class ArenaScope {
+		private:
+			NodeArena* _previous;
+
+		public:
+			ArenaScope(NodeArena& arena);
+			ArenaScope(const std::shared_ptr<NodeArena>& arena);
+			ArenaScope(const ArenaScope& other) = delete;
+			~ArenaScope();
+	};
+
+	/** Base for AST and observer nodes; routes their (de)allocation through 'NodeArena'.
+	  */
+	struct ArenaAllocated {
+		static void* operator new(std::size_t size) { return NodeArena::allocate(size); }
+		static void operator delete(void* ptr) noexcept { NodeArena::deallocate(ptr); }
+	};
+
+} // namespace cola
+
+#endif
@@ -8,6 +8,8 @@
 #include <map>
 #include <string>
 #include <cassert>
+#include "cola/arena.hpp"
+#include "cola/symbol.hpp"
 
 
 namespace cola {
@@ -143,7 +145,7 @@ namespace cola {
 
 	/*--------------- base ---------------*/
 
-	struct AstNode {
+	struct AstNode : public ArenaAllocated {
 		static std::size_t make_id() {
 			static std::size_t MAX_ID = 0;
 			return MAX_ID++;
@@ -168,25 +170,36 @@ namespace cola {
 	};
 
 	struct Type {
-		std::string name;
+		const std::string name;
+		const SymbolId id; // interned name
 		Sort sort;
-		std::map<std::string, std::reference_wrapper<const Type>> fields;
-		Type(std::string name_, Sort sort_) : name(name_), sort(sort_) {}
-		const Type* field(std::string name) const {
-			auto it = fields.find(name);
-			if (it == fields.end()) {
-				return nullptr;
-			} else {
-				return &(it->second.get());
+		std::map<std::string, std::reference_wrapper<const Type>> fields; // read-only; use 'add_field' to extend
+		Type(std::string name_, Sort sort_) : name(name_), id(intern(name_)), sort(sort_) {}
+		bool add_field(std::string name, const Type& type) {
+			auto insertion = fields.insert({ name, std::cref(type) });
+			if (insertion.second) {
+				field_index.push_back({ intern(name), &type });
+			}
+			return insertion.second;
+		}
+		const Type* field(SymbolId field_id) const {
+			for (const auto& [id, type] : field_index) {
+				if (id == field_id) {
+					return type;
+				}
 			}
+			return nullptr;
 		}
+		const Type* field(std::string name) const { return field(intern(name)); }
 		bool has_field(std::string name) const { return field(name) != nullptr; }
-		bool operator==(const Type& other) const { return name == other.name; }
-		bool operator!=(const Type& other) const { return name != other.name; }
+		bool operator==(const Type& other) const { return id == other.id; }
+		bool operator!=(const Type& other) const { return id != other.id; }
 		static const Type& void_type() { static const Type type = Type("void", Sort::VOID); return type; }
 		static const Type& bool_type() { static const Type type = Type("bool", Sort::BOOL); return type; }
 		static const Type& data_type() { static const Type type = Type("data_t", Sort::DATA); return type; }
 		static const Type& null_type() { static const Type type = Type("nullptr", Sort::PTR); return type; }
+		private:
+			std::vector<std::pair<SymbolId, const Type*>> field_index; // few fields per type; linear scan beats hashing
 	};
 
 	inline bool assignable(const Type& to, const Type& from) { // TODO: remove static
@@ -303,13 +316,15 @@ namespace cola {
 
 	struct Dereference : public Expression {
 		std::unique_ptr<Expression> expr;
-		std::string fieldname;
-		Dereference(std::unique_ptr<Expression> expr_, std::string fieldname_) : expr(std::move(expr_)), fieldname(fieldname_) {
+		const std::string fieldname;
+		const SymbolId field_id; // interned 'fieldname'
+		Dereference(std::unique_ptr<Expression> expr_, std::string fieldname_) : Dereference(std::move(expr_), fieldname_, intern(fieldname_)) {}
+		Dereference(std::unique_ptr<Expression> expr_, std::string fieldname_, SymbolId field_id_) : expr(std::move(expr_)), fieldname(fieldname_), field_id(field_id_) {
 			assert(expr);
-			assert(expr->type().field(fieldname) != nullptr);
+			assert(expr->type().field(field_id) != nullptr);
 		}
 		const Type& type() const override {
-			const Type* type = expr->type().field(fieldname);
+			const Type* type = expr->type().field(field_id);
 			assert(type);
 			return *type;
 		}
@@ -544,6 +559,7 @@ namespace cola {
 	};
 
 	struct Program : public AstNode {
+		std::shared_ptr<NodeArena> arena; // optional; declared first such that nodes are destroyed before the arena is released
 		std::string name;
 		std::vector<std::unique_ptr<Type>> types;
 		std::vector<std::unique_ptr<VariableDeclaration>> variables;
@@ -0,0 +1,72 @@
+#pragma once
+#ifndef COLA_HASHCONS
+#define COLA_HASHCONS
+
+#include <cstddef>
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include "cola/ast.hpp"
+
+
+namespace cola {
+
+	/** Hash-consed representation of an expression. An 'ExpressionTable' holds one instance per structurally distinct
+	  * expression; children refer to the instances of their subexpressions, so common subexpressions are shared.
+	  * Attributes are computed once per instance from the attributes of the children.
+	  */
+	struct ExpressionInfo {
+		enum struct Kind { BOOL, NULLPTR, EMPTY, MAX, MIN, NDET, VARIABLE, NEGATION, BINARY, DEREFERENCE };
+
+		Kind kind;
+		std::size_t payload = 0; // value of 'BooleanValue', operator of 'BinaryExpression', field of 'Dereference'
+		const VariableDeclaration* decl = nullptr; // for 'VariableExpression'
+		const ExpressionInfo* lhs = nullptr; // operand of unary expressions
+		const ExpressionInfo* rhs = nullptr;
+		std::size_t hash = 0;
+
+		bool is_local = true; // neither dereferences memory nor reads shared variables
+		std::set<const VariableDeclaration*> variables; // variables occurring in the expression
+	};
+
+	/** Hash-consing table for expressions: structurally equal expressions (same shape, values, operators, variable
+	  * declarations and fields) map to the same 'ExpressionInfo'. Hence, equality is a pointer comparison and analyses
+	  * like locality are lookups. Results are memoized per expression node, so the table must not be used after the
+	  * expressions it has seen are modified or destroyed; create it for the duration of one analysis.
+	  */
+	class ExpressionTable {
+		private:
+			struct InfoHash {
+				std::size_t operator()(const ExpressionInfo* info) const { return info->hash; }
+			};
+			struct InfoEqual {
+				bool operator()(const ExpressionInfo* info, const ExpressionInfo* other) const;
+			};
+
+			std::deque<ExpressionInfo> _storage;
+			std::unordered_set<const ExpressionInfo*, InfoHash, InfoEqual> _infos;
+			std::unordered_map<const Expression*, const ExpressionInfo*> _nodes;
+
+		public:
+			const ExpressionInfo& operator[](const Expression& expr);
+
+			const ExpressionInfo& make(ExpressionInfo info);
+
+			bool equal(const Expression& expr, const Expression& other) { return &(*this)[expr] == &(*this)[other]; }
+
+			std::size_t size() const { return _storage.size(); }
+	};
+
+	/** Structural hash of an expression; structurally equal expressions have equal hashes.
+	  * Variables are hashed by their declaration, thus the hash is only stable within one process.
+	  */
+	std::size_t structural_hash(const Expression& expr);
+
+	/** Checks whether two expressions agree in shape, values, operators, variable declarations and fields.
+	  */
+	bool structurally_equal(const Expression& expr, const Expression& other);
+
+} // namespace cola
+
+#endif
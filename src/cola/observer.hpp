@@ -36,7 +36,7 @@ namespace cola {
 		virtual void visit(const Observer& obj) = 0;
 	};
 
-	struct State {
+	struct State : public ArenaAllocated {
 		std::string name;
 		bool initial = false;
 		bool final = false;
@@ -49,7 +49,7 @@ namespace cola {
 		virtual void accept(ObserverVisitor& visitor) const { visitor.visit(*this); }
 	};
 
-	struct ObserverVariable {
+	struct ObserverVariable : public ArenaAllocated {
 		virtual ~ObserverVariable() = default;
 		virtual void accept(ObserverVisitor& visitor) const = 0;
 	};
@@ -66,7 +66,7 @@ namespace cola {
 		virtual void accept(ObserverVisitor& visitor) const override { visitor.visit(*this); }
 	};
 
-	struct GuardVariable {
+	struct GuardVariable : public ArenaAllocated {
 		virtual ~GuardVariable() = default;
 		virtual void accept(ObserverVisitor& visitor) const = 0;
 	};
@@ -81,7 +81,7 @@ namespace cola {
 		virtual void accept(ObserverVisitor& visitor) const override { visitor.visit(*this); }
 	};
 
-	struct Guard {
+	struct Guard : public ArenaAllocated {
 		virtual ~Guard() = default;
 		virtual void accept(ObserverVisitor& visitor) const = 0;
 	};
@@ -113,7 +113,7 @@ namespace cola {
 		virtual void accept(ObserverVisitor& visitor) const override { visitor.visit(*this); }
 	};
 
-	struct Transition {
+	struct Transition : public ArenaAllocated {
 		enum Kind { INVOCATION, RESPONSE };
 		const State& src;
 		const State& dst;
@@ -125,7 +125,7 @@ namespace cola {
 		virtual void accept(ObserverVisitor& visitor) const { visitor.visit(*this); }
 	};
 
-	struct Observer {
+	struct Observer : public ArenaAllocated {
 		std::string name;
 		bool negative_specification = true; // negative specification accepts what is *not* in specification (classic notion)
 		std::vector<std::unique_ptr<ObserverVariable>> variables;
@@ -135,6 +135,7 @@ namespace cola {
 		virtual void accept(ObserverVisitor& visitor) const { visitor.visit(*this); }
 		static const Function& free_function() {
 			static auto mkfreefun = [](const Type& ptrtype) -> std::unique_ptr<Function> {
+				ArenaScope scope(NodeArena::global()); // must not pin the arena of the program currently being built
 				auto freefun = std::make_unique<Function>("free", Type::void_type(), Function::SMR);
 				freefun->args.push_back(std::make_unique<VariableDeclaration>("ptr", ptrtype, false));
 				return freefun;
@@ -0,0 +1,44 @@
+#pragma once
+#ifndef COLA_PARENTS
+#define COLA_PARENTS
+
+#include <memory>
+#include <unordered_map>
+#include "cola/ast.hpp"
+
+
+namespace cola {
+
+	/** Where a statement lives in the program: its enclosing function, its parent statement ('nullptr' for function
+	  * bodies), and the slot owning it ('nullptr' if the parent owns it through a 'std::unique_ptr<Scope>').
+	  */
+	struct StatementLocation {
+		Function* function = nullptr;
+		Statement* parent = nullptr;
+		std::unique_ptr<Statement>* owner = nullptr;
+	};
+
+	/** Parent/owner index over the statements of a program. Built with one traversal; afterwards, the location of
+	  * any statement is a lookup. Rewrites must report the slots they modify to 'update', which re-indexes only the
+	  * subtree in that slot. Entries of destroyed statements are not removed; they are overwritten once the address
+	  * is reused by a statement passed to 'update'.
+	  */
+	class ParentIndex {
+		private:
+			std::unordered_map<const Statement*, StatementLocation> _locations;
+
+			void index(Statement& stmt, StatementLocation location);
+
+		public:
+			ParentIndex(Program& program);
+
+			bool contains(const Statement& stmt) const { return _locations.count(&stmt) > 0; }
+
+			const StatementLocation& operator[](const Statement& stmt) const;
+
+			void update(std::unique_ptr<Statement>& slot, Statement* parent, Function& function);
+	};
+
+} // namespace cola
+
+#endif
@@ -11,13 +11,19 @@
 
 namespace cola {
 
-	std::shared_ptr<Program> parse_program(std::string filename);
+	/** Front end for parsing programs and observers.
+	  * ANTLR uses the parser generated from 'CoLa.g4'; NATIVE uses the hand-written 'NativeParser' which avoids
+	  * building a parse tree and the ANTLR runtime's start-up cost. Both yield the same AST.
+	  */
+	enum struct ParserFrontend { ANTLR, NATIVE };
 
-	std::shared_ptr<Program> parse_program(std::istream& input);
+	std::shared_ptr<Program> parse_program(std::string filename, ParserFrontend frontend=ParserFrontend::ANTLR);
 
-	std::vector<std::unique_ptr<Observer>> parse_observer(std::string filename, const Program& program);
+	std::shared_ptr<Program> parse_program(std::istream& input, ParserFrontend frontend=ParserFrontend::ANTLR);
 
-	std::vector<std::unique_ptr<Observer>> parse_observer(std::istream& input, const Program& program);
+	std::vector<std::unique_ptr<Observer>> parse_observer(std::string filename, const Program& program, ParserFrontend frontend=ParserFrontend::ANTLR);
+
+	std::vector<std::unique_ptr<Observer>> parse_observer(std::istream& input, const Program& program, ParserFrontend frontend=ParserFrontend::ANTLR);
 
 } // namespace cola
 
@@ -19,48 +19,37 @@ void AstBuilder::pushScope() {
 }
 
 std::vector<std::unique_ptr<VariableDeclaration>> AstBuilder::popScope() {
-	std::vector<std::unique_ptr<VariableDeclaration>> decls, tmp;
-	decls.reserve(_scope.back().size());
-	tmp.reserve(_scope.back().size());
-	for (auto& entry : _scope.back()) { // reverses variable order?
-		tmp.push_back(std::move(entry.second));
-	}
-	while (!tmp.empty()) {
-		decls.push_back(std::move(tmp.back()));
-		tmp.pop_back();
-	}
+	std::vector<std::unique_ptr<VariableDeclaration>> decls = std::move(_scope.back().decls);
 	_scope.pop_back();
 	return decls;
 }
 
-bool AstBuilder::isVariableDeclared(std::string variableName) {
-	for (auto it = _scope.crbegin(); it != _scope.rend(); it++) {
-		if (it->count(variableName)) {
-			return true;
+const VariableDeclaration* AstBuilder::findVariable(SymbolId variableId) {
+	for (auto it = _scope.crbegin(); it != _scope.crend(); it++) {
+		auto find = it->lookup.find(variableId);
+		if (find != it->lookup.end()) {
+			return find->second;
 		}
 	}
-
-	return false;
+	return nullptr;
 }
 
 const VariableDeclaration& AstBuilder::lookupVariable(std::string variableName) {
-	std::size_t counter = 0;
-	for (auto it = _scope.crbegin(); it != _scope.rend(); it++) {
-		if (it->count(variableName)) {
-			return *it->at(variableName);
-		}
-		counter++;
+	auto result = findVariable(intern(variableName));
+	if (!result) {
+		throw std::logic_error("Variable '" + variableName + "' not declared.");
 	}
-
-	throw std::logic_error("Variable '" + variableName + "' not declared.");
+	return *result;
 }
 
 void AstBuilder::addVariable(std::unique_ptr<VariableDeclaration> variable) {
-	if (isVariableDeclared(variable->name)) {
+	SymbolId variableId = intern(variable->name);
+	if (findVariable(variableId)) {
 		throw std::logic_error("CompilationError: variable '" + variable->name + "' already declared.");
 	}
 
-	_scope.back()[variable->name] = std::move(variable);
+	_scope.back().lookup[variableId] = variable.get();
+	_scope.back().decls.push_back(std::move(variable));
 }
 
 bool AstBuilder::isTypeDeclared(std::string typeName) {
@@ -134,8 +123,8 @@ antlrcpp::Any AstBuilder::visitProgram(cola::CoLaParser::ProgramContext* context
 	for (auto variableContext : context->var_decl()) {
 		variableContext->accept(this);
 	}
-	for (auto& kvpair : _scope.back()) {
-		kvpair.second->is_shared = true;
+	for (auto& decl : _scope.back().decls) {
+		decl->is_shared = true;
 	}
 
 	// functions
@@ -590,10 +579,11 @@ antlrcpp::Any AstBuilder::visitStmtAtomic(cola::CoLaParser::StmtAtomicContext* c
 }
 
 antlrcpp::Any AstBuilder::visitStmtCom(cola::CoLaParser::StmtComContext* context) {
-	auto result = context->command()->accept(this).as<Statement*>();
+	// annotation must be available before the command is built, see 'as_command'
 	if (context->annotation()) {
 		_cmdInvariant = std::unique_ptr<Invariant>(context->annotation()->accept(this).as<Invariant*>());
 	}
+	auto result = context->command()->accept(this).as<Statement*>();
 	return as_statement(result);
 }
 
@@ -26,7 +26,10 @@ namespace cola {
 				ExprTrans(ExprForm form, Expression* expr, std::size_t num_shared) : form(form), expr(expr), num_shared(num_shared) {}
 			};
 			using TypeMap = std::unordered_map<std::string, std::reference_wrapper<const Type>>;
-			using VariableMap = std::unordered_map<std::string, std::unique_ptr<VariableDeclaration>>;
+			struct VariableMap {
+				std::vector<std::unique_ptr<VariableDeclaration>> decls; // declaration order
+				std::unordered_map<SymbolId, const VariableDeclaration*> lookup;
+			};
 			using FunctionMap = std::unordered_map<std::string, Function&>;
 			using ArgDeclList = std::vector<std::pair<std::string, std::string>>;
 			std::shared_ptr<Program> _program = nullptr;
@@ -40,7 +43,7 @@ namespace cola {
 			void pushScope();
 			std::vector<std::unique_ptr<VariableDeclaration>> popScope();
 			void addVariable(std::unique_ptr<VariableDeclaration> variable);
-			bool isVariableDeclared(std::string variableName);
+			const VariableDeclaration* findVariable(SymbolId variableId);
 			const VariableDeclaration& lookupVariable(std::string variableName);
 			bool isTypeDeclared(std::string typeName);
 			const Type& lookupType(std::string typeName);
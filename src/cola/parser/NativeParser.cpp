@@ -0,0 +1,1222 @@
+#include "cola/parser/NativeParser.hpp"
+
+#include "cola/util.hpp"
+#include <deque>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+
+using namespace cola;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Token {
+	enum Kind { IDENTIFIER, KEYWORD, STRING, SYMBOL, END };
+	Kind kind;
+	std::string text;
+	std::size_t line, column;
+	SymbolId symbol = 0; // interned text of identifiers
+};
+
+static const std::set<std::string> KEYWORDS = {
+	"inline", "extern", "void", "data_t", "bool", "int", "NULL", "EMPTY", "true", "false", "MAX_VAL", "MIN_VAL",
+	"struct", "class", "choose", "loop", "atomic", "if", "else", "while", "do", "skip", "malloc", "assume", "assert",
+	"angel", "continue", "break", "return", "CAS", "active", "member",
+	"observer", "positive", "negative", "variables", "thread", "pointer", "states", "initial", "final", "transitions",
+	"enter", "exit"
+};
+
+static const std::vector<std::string> SYMBOLS = { // longest first
+	"@invariant",
+	"==", "!=", "<=", ">=", "&&", "||", "->", "--", ">>",
+	"#", "{", "}", "(", ")", "[", "]", ";", ",", ":", "*", "=", "<", ">", "!"
+};
+
+class Lexer {
+	private:
+		const std::string& _input;
+		std::size_t _pos = 0;
+		std::size_t _line = 1;
+		std::size_t _line_start = 0;
+
+		static bool is_letter(char chr) { return ('a' <= chr && chr <= 'z') || ('A' <= chr && chr <= 'Z'); }
+		static bool is_digit(char chr) { return '0' <= chr && chr <= '9'; }
+		bool at(std::size_t offset, char chr) const { return _pos + offset < _input.size() && _input[_pos + offset] == chr; }
+
+		[[noreturn]] void error(std::string msg) const {
+			throw std::logic_error("Parsing error: line " + std::to_string(_line) + ":" + std::to_string(_pos - _line_start) + ": " + msg);
+		}
+
+		void advance(std::size_t count) {
+			for (std::size_t i = 0; i < count && _pos < _input.size(); i++, _pos++) {
+				if (_input[_pos] == '\n') {
+					_line++;
+					_line_start = _pos + 1;
+				}
+			}
+		}
+
+		void skip_whitespace_and_comments() {
+			while (_pos < _input.size()) {
+				char chr = _input[_pos];
+				if (chr == ' ' || chr == '\t' || chr == '\r' || chr == '\n') {
+					advance(1);
+				} else if (at(0, '/') && at(1, '*')) {
+					auto end = _input.find("*/", _pos + 2);
+					if (end == std::string::npos) {
+						error("unterminated comment.");
+					}
+					advance(end + 2 - _pos);
+				} else if (at(0, '/') && at(1, '/')) {
+					while (_pos < _input.size() && _input[_pos] != '\n' && _input[_pos] != '\r') {
+						advance(1);
+					}
+				} else {
+					break;
+				}
+			}
+		}
+
+		Token make(Token::Kind kind, std::size_t length) {
+			Token result { kind, _input.substr(_pos, length), _line, _pos - _line_start };
+			advance(length);
+			return result;
+		}
+
+		std::size_t identifier_length() const {
+			// Identifier : Letter ( ('-' | '_')* (Letter | '0'..'9') )*
+			std::size_t end = _pos + 1;
+			while (true) {
+				std::size_t next = end;
+				while (next < _input.size() && (_input[next] == '-' || _input[next] == '_')) {
+					next++;
+				}
+				if (next < _input.size() && (is_letter(_input[next]) || is_digit(_input[next]))) {
+					end = next + 1;
+				} else {
+					return end - _pos;
+				}
+			}
+		}
+
+		std::size_t string_length() const {
+			// strings extend to the last matching quote on the line
+			char quote = _input[_pos];
+			auto line_end = _input.find_first_of("\r\n", _pos);
+			if (line_end == std::string::npos) {
+				line_end = _input.size();
+			}
+			auto last = _input.rfind(quote, line_end - 1);
+			if (last == std::string::npos || last <= _pos) {
+				error("unterminated string.");
+			}
+			return last + 1 - _pos;
+		}
+
+	public:
+		Lexer(const std::string& input) : _input(input) {}
+
+		std::vector<Token> tokenize() {
+			std::vector<Token> result;
+			while (true) {
+				skip_whitespace_and_comments();
+				if (_pos >= _input.size()) {
+					result.push_back({ Token::END, "<EOF>", _line, _pos - _line_start });
+					return result;
+				}
+
+				char chr = _input[_pos];
+				if (is_letter(chr)) {
+					auto token = make(Token::IDENTIFIER, identifier_length());
+					if (KEYWORDS.count(token.text) != 0) {
+						token.kind = Token::KEYWORD;
+					} else {
+						token.symbol = intern(token.text);
+					}
+					result.push_back(std::move(token));
+
+				} else if (chr == '"' || chr == '\'') {
+					result.push_back(make(Token::STRING, string_length()));
+
+				} else {
+					bool found = false;
+					for (const auto& symbol : SYMBOLS) {
+						if (_input.compare(_pos, symbol.size(), symbol) == 0) {
+							result.push_back(make(Token::SYMBOL, symbol.size()));
+							found = true;
+							break;
+						}
+					}
+					if (!found) {
+						error("unexpected character '" + std::string(1, chr) + "'.");
+					}
+				}
+			}
+		}
+};
+
+
+class TokenStream {
+	private:
+		std::vector<Token> _tokens;
+		std::size_t _pos = 0;
+
+	public:
+		TokenStream(std::istream& input) {
+			std::string content((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+			_tokens = Lexer(content).tokenize();
+		}
+
+		const Token& peek(std::size_t offset=0) const {
+			return _tokens.at(std::min(_pos + offset, _tokens.size() - 1));
+		}
+
+		bool is(std::string text, std::size_t offset=0) const {
+			const auto& token = peek(offset);
+			return (token.kind == Token::KEYWORD || token.kind == Token::SYMBOL) && token.text == text;
+		}
+
+		bool is_identifier(std::size_t offset=0) const {
+			return peek(offset).kind == Token::IDENTIFIER;
+		}
+
+		bool is_end() const {
+			return peek().kind == Token::END;
+		}
+
+		[[noreturn]] void error(std::string expected) const {
+			const auto& token = peek();
+			std::stringstream msg;
+			msg << "Parsing error: line " << token.line << ":" << token.column << ": expected " << expected << " but found '" << token.text << "'.";
+			throw std::logic_error(msg.str());
+		}
+
+		bool accept(std::string text) {
+			if (is(text)) {
+				_pos++;
+				return true;
+			}
+			return false;
+		}
+
+		void expect(std::string text) {
+			if (!accept(text)) {
+				error("'" + text + "'");
+			}
+		}
+
+		const Token& expect_identifier_token() {
+			if (!is_identifier()) {
+				error("identifier");
+			}
+			return _tokens.at(_pos++);
+		}
+
+		std::string expect_identifier() {
+			return expect_identifier_token().text;
+		}
+
+		std::string expect_string() {
+			if (peek().kind != Token::STRING) {
+				error("string");
+			}
+			return _tokens.at(_pos++).text;
+		}
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class ProgramParser {
+	private:
+		// containers mirror 'AstBuilder'/'TypeBuilder' such that declarations end up in the same order
+		using TypeMap = std::unordered_map<std::string, std::reference_wrapper<const Type>>;
+		struct VariableMap {
+			std::vector<std::unique_ptr<VariableDeclaration>> decls; // declaration order
+			std::unordered_map<SymbolId, const VariableDeclaration*> lookup;
+		};
+		using FunctionMap = std::unordered_map<std::string, Function&>;
+		using FieldDecl = std::pair<std::string, std::vector<std::string>>;
+		const std::string INIT_NAME = "init";
+
+		TokenStream& _tokens;
+		std::shared_ptr<Program> _program;
+		std::deque<VariableMap> _scope;
+		TypeMap _types;
+		FunctionMap _functions;
+		bool _inside_loop = false;
+		bool _inside_tuple = false; // '>' closes a CAS tuple rather than being a comparison
+		const Function* _currentFunction = nullptr;
+
+		void pushScope() {
+			_scope.push_back(VariableMap());
+		}
+
+		std::vector<std::unique_ptr<VariableDeclaration>> popScope() {
+			std::vector<std::unique_ptr<VariableDeclaration>> decls = std::move(_scope.back().decls);
+			_scope.pop_back();
+			return decls;
+		}
+
+		const VariableDeclaration* findVariable(SymbolId variableId) {
+			for (auto it = _scope.crbegin(); it != _scope.crend(); it++) {
+				auto find = it->lookup.find(variableId);
+				if (find != it->lookup.end()) {
+					return find->second;
+				}
+			}
+			return nullptr;
+		}
+
+		const VariableDeclaration& lookupVariable(const Token& token) {
+			auto result = findVariable(token.symbol);
+			if (!result) {
+				throw std::logic_error("Variable '" + token.text + "' not declared.");
+			}
+			return *result;
+		}
+
+		void addVariable(const Token& token, const Type& type) {
+			if (findVariable(token.symbol)) {
+				throw std::logic_error("CompilationError: variable '" + token.text + "' already declared.");
+			}
+			auto variable = std::make_unique<VariableDeclaration>(token.text, type, false); // default to non-shared
+			_scope.back().lookup[token.symbol] = variable.get();
+			_scope.back().decls.push_back(std::move(variable));
+		}
+
+		const Type& lookupType(std::string typeName) {
+			auto it = _types.find(typeName);
+			if (it == _types.end()) {
+				std::string help = _types.count(typeName + "*") ? " Did you mean '" + typeName + "*'?" : "";
+				throw std::logic_error("Type '" + typeName + "' not declared." + help);
+			}
+			return it->second;
+		}
+
+		static std::unique_ptr<Statement> mk_stmt_from_list(std::vector<std::unique_ptr<Statement>> stmts) {
+			if (stmts.size() == 0) {
+				return std::make_unique<Skip>();
+			}
+			std::unique_ptr<Statement> current = std::move(stmts.at(0));
+			for (std::size_t i = 1; i < stmts.size(); i++) {
+				current = std::make_unique<Sequence>(std::move(current), std::move(stmts.at(i)));
+			}
+			return current;
+		}
+
+
+		/*--------------- types and declarations ---------------*/
+
+		bool is_type_name(std::size_t offset=0) const {
+			return _tokens.is("void", offset) || _tokens.is("bool", offset) || _tokens.is("int", offset) || _tokens.is("data_t", offset) || _tokens.is_identifier(offset);
+		}
+
+		std::size_t type_length(std::size_t offset=0) const {
+			if (!is_type_name(offset)) {
+				return 0;
+			}
+			return _tokens.is("*", offset + 1) ? 2 : 1;
+		}
+
+		std::string parse_type() {
+			std::string name;
+			if (_tokens.accept("void")) {
+				name = "void";
+			} else if (_tokens.accept("bool")) {
+				name = "bool";
+			} else if (_tokens.accept("int")) {
+				throw std::logic_error("Type 'int' not supported. Use 'data_t' instead.");
+			} else if (_tokens.accept("data_t")) {
+				name = "data_t";
+			} else {
+				name = _tokens.expect_identifier();
+			}
+			if (_tokens.accept("*")) {
+				name += "*";
+			}
+			return name;
+		}
+
+		std::vector<const Token*> parse_name_list() {
+			std::vector<const Token*> result;
+			result.push_back(&_tokens.expect_identifier_token());
+			while (_tokens.accept(",")) {
+				result.push_back(&_tokens.expect_identifier_token());
+			}
+			_tokens.expect(";");
+			return result;
+		}
+
+		bool is_var_decl() const {
+			auto length = type_length();
+			return length > 0 && _tokens.is_identifier(length);
+		}
+
+		void parse_var_decl() {
+			const Type& type = lookupType(parse_type());
+			for (const Token* name : parse_name_list()) {
+				addVariable(*name, type);
+			}
+		}
+
+		bool is_struct_decl() const {
+			return _tokens.is("struct") || _tokens.is("class") || (_tokens.is_identifier() && _tokens.is("{", 1));
+		}
+
+		std::pair<std::string, std::vector<FieldDecl>> parse_struct_decl() {
+			if (!_tokens.accept("struct")) {
+				_tokens.accept("class");
+			}
+			std::string name = _tokens.expect_identifier();
+			std::vector<FieldDecl> fields;
+			_tokens.expect("{");
+			while (!_tokens.accept("}")) {
+				std::string type = parse_type();
+				std::vector<std::string> names;
+				for (const Token* name : parse_name_list()) {
+					names.push_back(name->text);
+				}
+				fields.push_back({ type, std::move(names) });
+			}
+			_tokens.accept(";");
+			return { name, std::move(fields) };
+		}
+
+		void parse_types() {
+			std::vector<std::pair<std::string, std::vector<FieldDecl>>> structs;
+			while (is_struct_decl()) {
+				structs.push_back(parse_struct_decl());
+			}
+
+			std::unordered_map<std::string, std::unique_ptr<Type>> declared_types;
+			_types.insert({{ Type::void_type().name, Type::void_type() }});
+			_types.insert({{ Type::bool_type().name, Type::bool_type() }});
+			_types.insert({{ Type::data_type().name, Type::data_type() }});
+			_types.insert({{ Type::null_type().name, Type::null_type() }});
+
+			for (const auto& [structName, fields] : structs) {
+				std::string name = structName + "*";
+				if (_types.count(name) != 0) {
+					throw std::logic_error("Duplicate type declaration: type '" + name + "' already defined.");
+				}
+				auto new_type = std::make_unique<Type>(name, Sort::PTR);
+				_types.insert({{ name, std::cref(*new_type.get()) }});
+				declared_types[name] = std::move(new_type);
+			}
+
+			for (const auto& [structName, fields] : structs) {
+				Type& type = *declared_types.at(structName + "*");
+				for (const auto& [fieldTypeName, fieldNames] : fields) {
+					if (_types.count(fieldTypeName) == 0) {
+						throw std::logic_error("Field declaration of unknown type name '" + fieldTypeName + "'.");
+					}
+					const Type& fieldType = _types.at(fieldTypeName).get();
+					for (const auto& fieldName : fieldNames) {
+						if (!type.add_field(fieldName, fieldType)) {
+							throw std::logic_error("Duplicate field declaration: field with name '" + fieldName + "' already exists.");
+						}
+					}
+				}
+			}
+
+			_program->types.reserve(declared_types.size());
+			for (auto& kvpair : declared_types) {
+				_program->types.push_back(std::move(kvpair.second));
+			}
+		}
+
+		void parse_option() {
+			_tokens.expect("#");
+			std::string key = _tokens.expect_identifier();
+			std::string val = _tokens.expect_string();
+			val.erase(val.begin());
+			val.pop_back();
+
+			if (key == "name") {
+				_program->name = val;
+			}
+			auto insertion = _program->options.insert({ key, val });
+			if (!insertion.second) {
+				throw std::logic_error("Multiple options with the same key are not supported.");
+			}
+		}
+
+
+		/*--------------- functions ---------------*/
+
+		void parse_function() {
+			Function::Kind kind = Function::INTERFACE;
+			if (_tokens.accept("inline")) {
+				kind = Function::MACRO;
+			} else if (_tokens.accept("extern")) {
+				kind = Function::SMR;
+			}
+			const Type& returnType = lookupType(parse_type());
+			std::string name = _tokens.expect_identifier();
+
+			if (kind == Function::SMR && returnType != Type::void_type()) {
+				throw std::logic_error("Return type of extern SMR function " + name + " not support: must be of type 'void'.");
+			}
+			if (kind == Function::MACRO && returnType != Type::void_type()) {
+				throw std::logic_error("Return type of inline function " + name + " not support: must be of type 'void'.");
+			}
+			if (name == INIT_NAME) {
+				if (kind != Function::INTERFACE) {
+					throw std::logic_error("initializer function '" + name + "' must not have modifier.");
+				}
+				if (returnType != Type::void_type()) {
+					throw std::logic_error("initializer function '" + name + "' must have 'void' return type.");
+				}
+			}
+			if (name == "active") {
+				throw std::logic_error("Name clash: function name must not be 'active'.");
+			}
+
+			auto function = std::make_unique<Function>(name, returnType, kind);
+			_currentFunction = function.get();
+			if (name != INIT_NAME) {
+				// make function available for calls
+				if (_functions.count(name)) {
+					throw std::logic_error("Duplicate function declaration: function with name '" + name + "' already defined.");
+				}
+				_functions.insert({{ name, *function }});
+			}
+
+			// add arguments
+			pushScope();
+			std::vector<std::string> argnames_list;
+			_tokens.expect("(");
+			if (!_tokens.is(")")) {
+				do {
+					const Type& argtype = lookupType(parse_type());
+					const Token& argtoken = _tokens.expect_identifier_token();
+					std::string argname = argtoken.text;
+					argnames_list.push_back(argname);
+					addVariable(argtoken, argtype);
+
+					if (argtype.sort == Sort::VOID) {
+						throw std::logic_error("Argument type 'void' not supported for argument '" + argname + "'.");
+					}
+					if (kind == Function::INTERFACE && argtype.sort == Sort::PTR) {
+						throw std::logic_error("Argument with name '" + argname + "' of pointer sort not supported for interface functions.");
+					}
+				} while (_tokens.accept(","));
+			}
+			_tokens.expect(")");
+
+			// handle body
+			if (kind == Function::SMR) {
+				_tokens.expect(";");
+			} else {
+				function->body = parse_scope();
+			}
+
+			// get variable decls; enforce declaration order
+			std::vector<std::unique_ptr<VariableDeclaration>> scope = popScope();
+			function->args.reserve(argnames_list.size());
+			for (const auto& argname : argnames_list) {
+				for (auto& decl : scope) {
+					if (decl && decl->name == argname) {
+						function->args.push_back(std::move(decl));
+						break;
+					}
+				}
+			}
+			assert(function->args.size() == argnames_list.size());
+
+			// transfer ownership
+			if (name == INIT_NAME) {
+				_program->initializer = std::move(function);
+			} else {
+				_program->functions.push_back(std::move(function));
+			}
+		}
+
+
+		/*--------------- statements ---------------*/
+
+		std::unique_ptr<Scope> parse_scope() {
+			_tokens.expect("{");
+			pushScope();
+			while (is_var_decl()) {
+				parse_var_decl();
+			}
+			std::vector<std::unique_ptr<Statement>> stmts;
+			while (!_tokens.accept("}")) {
+				stmts.push_back(parse_statement());
+			}
+			auto scope = std::make_unique<Scope>(mk_stmt_from_list(std::move(stmts)));
+			scope->variables = popScope();
+			return scope;
+		}
+
+		std::unique_ptr<Scope> parse_block() {
+			if (_tokens.is("{")) {
+				return parse_scope();
+			}
+			return std::make_unique<Scope>(parse_statement());
+		}
+
+		std::unique_ptr<Scope> parse_loop_body(bool is_block) {
+			bool was_in_loop = _inside_loop;
+			_inside_loop = true;
+			auto result = is_block ? parse_block() : parse_scope();
+			_inside_loop = was_in_loop;
+			return result;
+		}
+
+		template<typename T>
+		std::unique_ptr<Statement> annotate(std::unique_ptr<T> stmt, std::unique_ptr<Invariant> annotation) {
+			stmt->annotation = std::move(annotation);
+			return stmt;
+		}
+
+		std::unique_ptr<Statement> parse_statement() {
+			if (_tokens.accept("choose")) {
+				auto result = std::make_unique<Choice>();
+				do {
+					result->branches.push_back(parse_scope());
+				} while (_tokens.is("{"));
+				return result;
+			}
+			if (_tokens.accept("loop")) {
+				return std::make_unique<Loop>(parse_loop_body(false));
+			}
+
+			std::unique_ptr<Invariant> annotation;
+			if (_tokens.accept("@invariant")) {
+				_tokens.expect("(");
+				annotation = parse_invariant();
+				_tokens.expect(")");
+			}
+
+			if (_tokens.accept("atomic")) {
+				return annotate(std::make_unique<Atomic>(parse_block()), std::move(annotation));
+
+			} else if (_tokens.accept("if")) {
+				_tokens.expect("(");
+				auto expr = parse_expression();
+				_tokens.expect(")");
+				auto ifScope = parse_block();
+				auto elseScope = _tokens.accept("else") ? parse_block() : std::make_unique<Scope>(std::make_unique<Skip>());
+				return annotate(std::make_unique<IfThenElse>(std::move(expr), std::move(ifScope), std::move(elseScope)), std::move(annotation));
+
+			} else if (_tokens.accept("while")) {
+				_tokens.expect("(");
+				auto expr = parse_expression();
+				_tokens.expect(")");
+				return annotate(std::make_unique<While>(std::move(expr), parse_loop_body(true)), std::move(annotation));
+
+			} else if (_tokens.is("do")) {
+				throw std::logic_error("Unsupported construct: do-while not supported, use regular while loop instead.");
+
+			} else {
+				auto result = parse_command(std::move(annotation));
+				_tokens.expect(";");
+				return result;
+			}
+		}
+
+
+		/*--------------- commands ---------------*/
+
+		std::unique_ptr<Statement> parse_command(std::unique_ptr<Invariant> annotation) {
+			if (_tokens.accept("skip")) {
+				return annotate(std::make_unique<Skip>(), std::move(annotation));
+
+			} else if (_tokens.accept("assume")) {
+				_tokens.expect("(");
+				auto expr = parse_expression();
+				_tokens.expect(")");
+				return annotate(std::make_unique<Assume>(std::move(expr)), std::move(annotation));
+
+			} else if (_tokens.accept("assert")) {
+				_tokens.expect("(");
+				auto inv = parse_invariant();
+				_tokens.expect(")");
+				return annotate(std::make_unique<Assert>(std::move(inv)), std::move(annotation));
+
+			} else if (_tokens.accept("angel")) {
+				_tokens.expect("(");
+				auto angel = parse_angel();
+				_tokens.expect(")");
+				angel->annotation = std::move(annotation);
+				return angel;
+
+			} else if (_tokens.accept("continue")) {
+				if (!_inside_loop) {
+					throw std::logic_error("Semantic error: 'continue' must only appear inside loops.");
+				}
+				return annotate(std::make_unique<Continue>(), std::move(annotation));
+
+			} else if (_tokens.accept("break")) {
+				if (!_inside_loop) {
+					throw std::logic_error("Semantic error: 'break' must only appear inside loops.");
+				}
+				return annotate(std::make_unique<Break>(), std::move(annotation));
+
+			} else if (_tokens.accept("return")) {
+				if (_tokens.is(";")) {
+					return annotate(std::make_unique<Return>(), std::move(annotation));
+				}
+				auto expr = parse_expression();
+				if (expr->type() != _currentFunction->return_type) {
+					throw std::logic_error("Type error: return value has type '" + expr->type().name + "' but function has return type '" + _currentFunction->return_type.name + "'.");
+				}
+				return annotate(std::make_unique<Return>(std::move(expr)), std::move(annotation));
+
+			} else if (_tokens.is("CAS")) {
+				return annotate(parse_cas(), std::move(annotation));
+
+			} else if (_tokens.is_identifier() && _tokens.is("(", 1)) {
+				return parse_call(std::move(annotation));
+
+			} else if (_tokens.is_identifier() && _tokens.is("=", 1) && _tokens.is("malloc", 2)) {
+				auto& lhs = lookupVariable(_tokens.expect_identifier_token());
+				_tokens.expect("=");
+				_tokens.expect("malloc");
+				if (lhs.type.sort != Sort::PTR) {
+					throw std::logic_error("Type error: cannot assign to expression of non-pointer type.");
+				}
+				if (lhs.type == Type::void_type()) {
+					throw std::logic_error("Type error: cannot assign to 'null'.");
+				}
+				return annotate(std::make_unique<Malloc>(lhs), std::move(annotation));
+
+			} else {
+				auto lhs = parse_expression();
+				_tokens.expect("=");
+				auto rhs = parse_expression();
+				if (!assignable(lhs->type(), rhs->type())) {
+					throw std::logic_error("Type error: cannot assign to expression of type '" + lhs->type().name + "' from expression of type '" + rhs->type().name + "'.");
+				}
+				if (lhs->type() == Type::void_type()) {
+					throw std::logic_error("Type error: cannot assign to 'null'.");
+				}
+				return annotate(std::make_unique<Assignment>(std::move(lhs), std::move(rhs)), std::move(annotation));
+			}
+		}
+
+		std::unique_ptr<Command> parse_angel() {
+			if (_tokens.accept("choose")) {
+				return std::make_unique<AngelChoose>(_tokens.accept("active"));
+			} else if (_tokens.accept("active")) {
+				return std::make_unique<AngelActive>();
+			} else if (_tokens.accept("member")) {
+				_tokens.expect("(");
+				const VariableDeclaration& decl = lookupVariable(_tokens.expect_identifier_token());
+				_tokens.expect(")");
+				return std::make_unique<AngelContains>(decl);
+			}
+			_tokens.error("angel expression");
+		}
+
+		std::unique_ptr<Statement> parse_call(std::unique_ptr<Invariant> annotation) {
+			std::string name = _tokens.expect_identifier();
+			if (!_functions.count(name)) {
+				throw std::logic_error("Error: call to undeclared function '" + name + "'.");
+			}
+			const Function& function = _functions.at(name);
+			if (function.kind == Function::INTERFACE) {
+				throw std::logic_error("Error: call to interface function '" + name + "' from interface function '" + _currentFunction->name + "', can only call 'inline'/'extern' functions.");
+			}
+
+			std::vector<std::unique_ptr<Expression>> args;
+			_tokens.expect("(");
+			if (!_tokens.is(")")) {
+				do {
+					args.push_back(parse_expression());
+				} while (_tokens.accept(","));
+			}
+			_tokens.expect(")");
+
+			if (function.args.size() != args.size()) {
+				std::stringstream msg;
+				msg << "Candidate function not applicable: '" << function.name << "' requires " << function.args.size() << " arguments, ";
+				msg << args.size() << " arguments provided.";
+				throw std::logic_error(msg.str());
+			}
+			// TODO: check argument types (neither does the ANTLR front end)
+
+			if (function.kind == Function::SMR) {
+				auto enter = std::make_unique<Enter>(function);
+				enter->args = std::move(args);
+				enter->annotation = std::move(annotation);
+				return std::make_unique<Sequence>(std::move(enter), std::make_unique<Exit>(function));
+
+			} else {
+				assert(function.kind == Function::MACRO);
+				auto macro = std::make_unique<Macro>(function);
+				macro->args = std::move(args);
+				return annotate(std::move(macro), std::move(annotation));
+			}
+		}
+
+		std::vector<std::unique_ptr<Expression>> parse_cas_tuple() {
+			bool was_inside_tuple = _inside_tuple;
+			_inside_tuple = true;
+			std::vector<std::unique_ptr<Expression>> result;
+			_tokens.expect("<");
+			do {
+				result.push_back(parse_expression());
+			} while (_tokens.accept(","));
+			_tokens.expect(">");
+			_tokens.expect(",");
+			_inside_tuple = was_inside_tuple;
+			return result;
+		}
+
+		std::unique_ptr<CompareAndSwap> parse_cas() {
+			std::vector<std::unique_ptr<Expression>> dst, cmp, src;
+			_tokens.expect("CAS");
+			_tokens.expect("(");
+			if (_tokens.is("<")) {
+				dst = parse_cas_tuple();
+				cmp = parse_cas_tuple();
+				src = parse_cas_tuple();
+			} else {
+				dst.push_back(parse_expression());
+				_tokens.expect(",");
+				cmp.push_back(parse_expression());
+				_tokens.expect(",");
+				src.push_back(parse_expression());
+			}
+			_tokens.expect(")");
+
+			if (dst.size() != cmp.size() || cmp.size() != src.size()) {
+				throw std::logic_error("Malformed CAS.");
+			}
+			auto result = std::make_unique<CompareAndSwap>();
+			result->elems.reserve(dst.size());
+			for (std::size_t i = 0; i < dst.size(); i++) {
+				result->elems.push_back(CompareAndSwap::Triple(std::move(dst.at(i)), std::move(cmp.at(i)), std::move(src.at(i))));
+			}
+			return result;
+		}
+
+
+		/*--------------- expressions ---------------*/
+
+		std::unique_ptr<Invariant> parse_invariant() {
+			if (_tokens.is("active") && _tokens.is("(", 1)) {
+				_tokens.expect("active");
+				_tokens.expect("(");
+				auto expr = parse_expression();
+				_tokens.expect(")");
+				return std::make_unique<InvariantActive>(std::move(expr));
+			}
+			return std::make_unique<InvariantExpression>(parse_expression());
+		}
+
+		// precedences follow ANTLR's rewriting of the left-recursive 'expression' rule
+		static const std::size_t PREC_NEGATION = 4;
+		static const std::size_t PREC_DEREF = 3;
+		static const std::size_t PREC_BINARY = 2;
+
+		bool parse_binop(BinaryExpression::Operator& op) {
+			static const std::vector<std::pair<std::string, BinaryExpression::Operator>> binops = {
+				{ "==", BinaryExpression::Operator::EQ }, { "!=", BinaryExpression::Operator::NEQ },
+				{ "<", BinaryExpression::Operator::LT }, { "<=", BinaryExpression::Operator::LEQ },
+				{ ">", BinaryExpression::Operator::GT }, { ">=", BinaryExpression::Operator::GEQ },
+				{ "&&", BinaryExpression::Operator::AND }, { "||", BinaryExpression::Operator::OR }
+			};
+			for (const auto& [text, binop] : binops) {
+				if (_tokens.is(text) && !(_inside_tuple && text == ">")) {
+					_tokens.accept(text);
+					op = binop;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		std::unique_ptr<Expression> parse_expression(std::size_t precedence=0) {
+			std::unique_ptr<Expression> result;
+			if (_tokens.accept("!")) {
+				result = std::make_unique<NegatedExpression>(parse_expression(PREC_NEGATION));
+			} else {
+				result = parse_primary();
+			}
+
+			while (true) {
+				BinaryExpression::Operator op;
+				if (precedence <= PREC_DEREF && _tokens.accept("->")) {
+					result = make_dereference(std::move(result), _tokens.expect_identifier());
+				} else if (precedence <= PREC_BINARY && parse_binop(op)) {
+					result = make_binary(op, std::move(result), parse_expression(PREC_DEREF));
+				} else {
+					return result;
+				}
+			}
+		}
+
+		std::unique_ptr<Expression> parse_primary() {
+			if (_tokens.is_identifier()) {
+				return std::make_unique<VariableExpression>(lookupVariable(_tokens.expect_identifier_token()));
+			} else if (_tokens.accept("NULL")) {
+				return std::make_unique<NullValue>();
+			} else if (_tokens.accept("true")) {
+				return std::make_unique<BooleanValue>(true);
+			} else if (_tokens.accept("false")) {
+				return std::make_unique<BooleanValue>(false);
+			} else if (_tokens.accept("*")) {
+				return std::make_unique<NDetValue>();
+			} else if (_tokens.accept("EMPTY")) {
+				return std::make_unique<EmptyValue>();
+			} else if (_tokens.accept("MAX_VAL")) {
+				return std::make_unique<MaxValue>();
+			} else if (_tokens.accept("MIN_VAL")) {
+				return std::make_unique<MinValue>();
+			} else if (_tokens.is("CAS")) {
+				return parse_cas();
+			} else if (_tokens.accept("(")) {
+				bool was_inside_tuple = _inside_tuple;
+				_inside_tuple = false;
+				auto result = parse_expression();
+				_inside_tuple = was_inside_tuple;
+				_tokens.expect(")");
+				return result;
+			}
+			_tokens.error("expression");
+		}
+
+		static std::unique_ptr<Expression> make_dereference(std::unique_ptr<Expression> expr, std::string fieldname) {
+			const Type& exprtype = expr->type();
+			if (exprtype.sort != Sort::PTR) {
+				throw std::logic_error("Cannot dereference expression of non-pointer type.");
+			}
+			if (exprtype == Type::null_type()) {
+				throw std::logic_error("Cannot dereference 'null'.");
+			}
+			if (!exprtype.has_field(fieldname)) {
+				throw std::logic_error("Expression evaluates to type '" + exprtype.name + "' which does not have a field '" + fieldname + "'.");
+			}
+			return std::make_unique<Dereference>(std::move(expr), fieldname);
+		}
+
+		static std::unique_ptr<Expression> make_binary(BinaryExpression::Operator op, std::unique_ptr<Expression> lhs, std::unique_ptr<Expression> rhs) {
+			bool is_logic = op == BinaryExpression::Operator::AND || op == BinaryExpression::Operator::OR;
+			bool is_equality = op == BinaryExpression::Operator::EQ || op == BinaryExpression::Operator::NEQ;
+			const Type& lhsType = lhs->type();
+			const Type& rhsType = rhs->type();
+
+			if (!comparable(lhsType, rhsType)) {
+				throw std::logic_error("Type error: cannot compare types '" + lhsType.name + "' and " + rhsType.name + "' using operator '" + toString(op) + "'.");
+			}
+			if (lhsType.sort == Sort::PTR && !is_equality) {
+				throw std::logic_error("Type error: pointer types allow only for (in)equality comparison.");
+			}
+			if (is_logic && lhsType.sort != Sort::BOOL) {
+				throw std::logic_error("Type error: logic operators require bool type.");
+			}
+			return std::make_unique<BinaryExpression>(op, std::move(lhs), std::move(rhs));
+		}
+
+	public:
+		ProgramParser(TokenStream& tokens) : _tokens(tokens) {}
+
+		std::shared_ptr<Program> parse() {
+			_program = std::make_shared<Program>();
+			_program->name = "unknown";
+
+			while (_tokens.is("#")) {
+				parse_option();
+			}
+			parse_types();
+
+			// add shared variables
+			pushScope();
+			while (is_var_decl() && !_tokens.is("(", type_length() + 1)) {
+				parse_var_decl();
+			}
+			for (auto& decl : _scope.back().decls) {
+				decl->is_shared = true;
+			}
+
+			while (!_tokens.is_end()) {
+				parse_function();
+			}
+			if (!_program->initializer) {
+				throw std::logic_error("Program has no 'init' function.");
+			}
+
+			_program->variables = popScope();
+			return _program;
+		}
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class ObserverParser {
+	private:
+		TokenStream& _tokens;
+		const Function& _free_function;
+		std::map<std::string, const Function*> _name2function;
+		std::map<std::string, State*> _name2state;
+		std::map<std::string, const ThreadObserverVariable*> _name2threadvar;
+		std::map<std::string, const ProgramObserverVariable*> _name2ptrvar;
+		Observer* _observer = nullptr;
+
+		void check_name_clash(std::string name) {
+			if (name == "this") {
+				throw std::logic_error("Parsing error: 'this' is a reserved key word.");
+			}
+			if (_name2state.count(name) > 0) {
+				throw std::logic_error("Parsing error: '" + name + "' is already defined as a state.");
+			}
+			if (_name2threadvar.count(name) > 0) {
+				throw std::logic_error("Parsing error: '" + name + "' is already defined as a thread variable.");
+			}
+			if (_name2ptrvar.count(name) > 0) {
+				throw std::logic_error("Parsing error: '" + name + "' is already defined as a pointer variable.");
+			}
+		}
+
+		template<typename T>
+		static T find(const std::map<std::string, T>& container, std::string name, std::string error) {
+			auto find = container.find(name);
+			if (find == container.end()) {
+				throw std::logic_error("Parsing error: " + error + " '" + name + "'.");
+			}
+			return find->second;
+		}
+
+		const Function& find_function(std::string name) {
+			if (name == _free_function.name) {
+				return _free_function;
+			}
+			return *find(_name2function, name, "unknown function");
+		}
+
+		void parse_variable() {
+			bool is_thread = _tokens.accept("thread");
+			if (!is_thread) {
+				_tokens.expect("pointer");
+			}
+			std::string name = _tokens.expect_identifier();
+			_tokens.expect(";");
+			check_name_clash(name);
+
+			if (is_thread) {
+				auto var = std::make_unique<ThreadObserverVariable>(name);
+				_name2threadvar.insert({ name, var.get() });
+				_observer->variables.push_back(std::move(var));
+			} else {
+				const Type& ptrtype = _free_function.args.at(0)->type;
+				auto var = std::make_unique<ProgramObserverVariable>(std::make_unique<VariableDeclaration>(name, ptrtype, false));
+				_name2ptrvar.insert({ name, var.get() });
+				_observer->variables.push_back(std::move(var));
+			}
+		}
+
+		void parse_state() {
+			auto state = std::make_unique<State>();
+			std::string id = _tokens.expect_identifier();
+			if (_tokens.accept("(")) {
+				state->name = _tokens.expect_identifier();
+				_tokens.expect(")");
+			}
+			if (_tokens.is("[") && _tokens.is("initial", 1)) {
+				_tokens.expect("[");
+				_tokens.expect("initial");
+				_tokens.expect("]");
+				state->initial = true;
+			}
+			if (_tokens.accept("[")) {
+				_tokens.expect("final");
+				_tokens.expect("]");
+				state->final = true;
+			}
+			_tokens.expect(";");
+			check_name_clash(id);
+			_name2state.insert({ id, state.get() });
+			_observer->states.push_back(std::move(state));
+		}
+
+		struct RawGuard {
+			bool is_true, is_negated;
+			std::string name;
+		};
+
+		RawGuard parse_guard() {
+			if (_tokens.accept("*")) {
+				return { true, false, "" };
+			}
+			bool is_negated = _tokens.accept("!");
+			return { false, is_negated, _tokens.expect_identifier() };
+		}
+
+		std::unique_ptr<Guard> make_guard(const RawGuard& raw, const VariableDeclaration* arg) {
+			const ObserverVariable* lhs;
+			std::unique_ptr<GuardVariable> rhs;
+			if (arg) {
+				// pointer case
+				lhs = find(_name2ptrvar, raw.name, "undefined pointer variable");
+				rhs = std::make_unique<ArgumentGuardVariable>(*arg);
+			} else {
+				// thread (this) case
+				lhs = find(_name2threadvar, raw.name, "undefined thread variable");
+				rhs = std::make_unique<SelfGuardVariable>();
+			}
+			if (raw.is_negated) {
+				return std::make_unique<NeqGuard>(*lhs, std::move(rhs));
+			}
+			return std::make_unique<EqGuard>(*lhs, std::move(rhs));
+		}
+
+		void parse_transition() {
+			auto& src = *find(_name2state, _tokens.expect_identifier(), "undefined state");
+			_tokens.expect("--");
+			bool is_enter = _tokens.accept("enter");
+			bool is_exit = !is_enter && _tokens.accept("exit");
+			const auto& label = find_function(_tokens.expect_identifier());
+
+			_tokens.expect("(");
+			RawGuard thisguard = parse_guard();
+			std::vector<RawGuard> argsguard;
+			while (_tokens.accept(",")) {
+				argsguard.push_back(parse_guard());
+			}
+			_tokens.expect(")");
+			_tokens.expect(">>");
+			const auto& dst = *find(_name2state, _tokens.expect_identifier(), "undefined state");
+			_tokens.expect(";");
+
+			// TODO: prevent free from having enter/exit
+			Transition::Kind kind = Transition::INVOCATION;
+			if (is_enter) {
+				if (argsguard.size() != label.args.size()) {
+					throw std::logic_error("Parsing error: function '" + label.name + "' has " + std::to_string(label.args.size()) + " parameters but " + std::to_string(argsguard.size()) + " were provided.");
+				}
+			} else if (is_exit) {
+				kind = Transition::RESPONSE;
+				if (argsguard.size() != 0) {
+					throw std::logic_error("Parsing error: 'exit' definition for function '" + label.name + "' specifies paramters.");
+				}
+			} else if (&label != &_free_function) {
+				throw std::logic_error("Parsing error: missing enter/exit in transition.");
+			}
+			if (argsguard.size() > label.args.size()) {
+				throw std::logic_error("Parsing error: function '" + label.name + "' has " + std::to_string(label.args.size()) + " parameters but " + std::to_string(argsguard.size()) + " were provided.");
+			}
+
+			// create guard; '*' guards are dropped
+			std::vector<std::unique_ptr<Guard>> conjuncts;
+			if (!thisguard.is_true) {
+				conjuncts.push_back(make_guard(thisguard, nullptr));
+			}
+			for (std::size_t i = 0; i < argsguard.size(); i++) {
+				if (!argsguard.at(i).is_true) {
+					conjuncts.push_back(make_guard(argsguard.at(i), label.args.at(i).get()));
+				}
+			}
+			if (conjuncts.size() == 0) {
+				conjuncts.push_back(std::make_unique<TrueGuard>());
+			}
+			src.transitions.push_back(std::make_unique<Transition>(src, dst, label, kind, std::make_unique<ConjunctionGuard>(std::move(conjuncts))));
+		}
+
+		std::unique_ptr<Observer> parse_observer() {
+			_name2state.clear();
+			_name2threadvar.clear();
+			_name2ptrvar.clear();
+
+			_tokens.expect("observer");
+			auto result = std::make_unique<Observer>(_tokens.expect_identifier());
+			_observer = result.get();
+
+			bool positive = false, negative = false;
+			if (_tokens.accept("[")) {
+				positive = _tokens.accept("positive");
+				negative = !positive && _tokens.accept("negative");
+				if (!positive && !negative) {
+					_tokens.error("'positive' or 'negative'");
+				}
+				_tokens.expect("]");
+			}
+			if (positive == negative) {
+				throw std::logic_error("Parsing error: observer is positive and negative.");
+			}
+			_observer->negative_specification = negative;
+
+			_tokens.expect("{");
+			_tokens.expect("variables");
+			_tokens.expect(":");
+			while (_tokens.is("thread") || _tokens.is("pointer")) {
+				parse_variable();
+			}
+			_tokens.expect("states");
+			_tokens.expect(":");
+			while (_tokens.is_identifier()) {
+				parse_state();
+			}
+			_tokens.expect("transitions");
+			_tokens.expect(":");
+			while (_tokens.is_identifier()) {
+				parse_transition();
+			}
+			_tokens.expect("}");
+			return result;
+		}
+
+	public:
+		ObserverParser(TokenStream& tokens, const Program& program) : _tokens(tokens), _free_function(Observer::free_function()) {
+			for (const auto& function : program.functions) {
+				if (function->kind == Function::SMR) {
+					_name2function[function->name] = function.get();
+				}
+			}
+		}
+
+		std::vector<std::unique_ptr<Observer>> parse() {
+			std::vector<std::unique_ptr<Observer>> result;
+			do {
+				result.push_back(parse_observer());
+			} while (!_tokens.is_end());
+			return result;
+		}
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<Program> NativeParser::parse_program(std::istream& input) {
+	TokenStream tokens(input);
+	ProgramParser parser(tokens);
+	return parser.parse();
+}
+
+std::vector<std::unique_ptr<Observer>> NativeParser::parse_observer(std::istream& input, const Program& program) {
+	TokenStream tokens(input);
+	ObserverParser parser(tokens, program);
+	return parser.parse();
+}
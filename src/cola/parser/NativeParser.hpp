@@ -0,0 +1,26 @@
+#pragma once
+#ifndef COLA_NATIVEPARSER
+#define COLA_NATIVEPARSER
+
+#include <istream>
+#include <memory>
+#include <vector>
+#include "cola/ast.hpp"
+#include "cola/observer.hpp"
+
+
+namespace cola {
+
+	/** Hand-written lexer and recursive-descent parser for the grammar in 'CoLa.g4'.
+	  * Builds the AST directly (no parse tree, no ANTLR runtime) and performs the same semantic checks as
+	  * 'AstBuilder'/'ObserverBuilder'; the resulting programs and observers are structurally identical.
+	  * Errors are reported by throwing 'std::logic_error' at the first offending token.
+	  */
+	struct NativeParser {
+		static std::shared_ptr<Program> parse_program(std::istream& input);
+		static std::vector<std::unique_ptr<Observer>> parse_observer(std::istream& input, const Program& program);
+	};
+
+} // namespace cola
+
+#endif
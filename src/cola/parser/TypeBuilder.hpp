@@ -98,11 +98,9 @@ namespace cola {
 				const Type& fieldType = lookup(context->type()->accept(this).as<std::string>());
 				for (auto& token : context->names) {
 					std::string name = token->getText();
-					if (_currentType->fields.count(name) != 0) {
+					if (!_currentType->add_field(name, fieldType)) {
 						throw std::logic_error("Duplicate field declaration: field with name '" + name + "' already exists.");
 					}
-					auto wrapper = std::cref(fieldType);
-					_currentType->fields.insert({{ name, wrapper }});
 				}
 				return nullptr;
 			}
@@ -11,6 +11,8 @@
 #include "cola/parser/AstBuilder.hpp"
 #include "cola/observer.hpp"
 #include "cola/parser/ObserverBuilder.hpp"
+#include "cola/parser/NativeParser.hpp"
+#include "cola/trace.hpp"
 
 using namespace antlr4;
 using namespace cola;
@@ -29,15 +31,15 @@ std::string get_path(std::string filename) {
 }
 
 
-std::shared_ptr<Program> cola::parse_program(std::string filename) {
+std::shared_ptr<Program> cola::parse_program(std::string filename, ParserFrontend frontend) {
 	std::ifstream file(filename);
-	auto result = parse_program(file);
+	auto result = parse_program(file, frontend);
 	result->options["_path"] = get_path(filename);
 	// std::cout << get_path(filename) << std::endl;
 	return result;
 }
 
-std::shared_ptr<Program> cola::parse_program(std::istream& input) {
+std::shared_ptr<Program> parse_program_antlr(std::istream& input) {
 	ANTLRInputStream antlr(input);
 	CoLaLexer lexer(&antlr);
 	CommonTokenStream tokens(&lexer);
@@ -53,13 +55,22 @@ std::shared_ptr<Program> cola::parse_program(std::istream& input) {
 	return AstBuilder::buildFrom(programContext);
 }
 
+std::shared_ptr<Program> cola::parse_program(std::istream& input, ParserFrontend frontend) {
+	TraceScope trace("parse", "parse program");
+	auto arena = NodeArena::make(false); // programs are built and rewritten by a single thread
+	ArenaScope scope(arena);
+	auto result = frontend == ParserFrontend::NATIVE ? NativeParser::parse_program(input) : parse_program_antlr(input);
+	result->arena = std::move(arena);
+	return result;
+}
+
 
-std::vector<std::unique_ptr<Observer>> cola::parse_observer(std::string filename, const Program& program) {
+std::vector<std::unique_ptr<Observer>> cola::parse_observer(std::string filename, const Program& program, ParserFrontend frontend) {
 	std::ifstream file(filename);
-	return parse_observer(file, program);
+	return parse_observer(file, program, frontend);
 }
 
-std::vector<std::unique_ptr<Observer>> cola::parse_observer(std::istream& input, const Program& program) {
+std::vector<std::unique_ptr<Observer>> parse_observer_antlr(std::istream& input, const Program& program) {
 	ANTLRInputStream antlr(input);
 	CoLaLexer lexer(&antlr);
 	CommonTokenStream tokens(&lexer);
@@ -74,3 +85,13 @@ std::vector<std::unique_ptr<Observer>> cola::parse_observer(std::istream& input,
 
 	return ObserverBuilder::buildFrom(observerContext, program);
 }
+
+std::vector<std::unique_ptr<Observer>> cola::parse_observer(std::istream& input, const Program& program, ParserFrontend frontend) {
+	TraceScope trace("parse", "parse observer");
+	// observers reference the program's functions and thus live no longer than the program
+	ArenaScope scope(program.arena);
+	if (frontend == ParserFrontend::NATIVE) {
+		return NativeParser::parse_observer(input, program);
+	}
+	return parse_observer_antlr(input, program);
+}
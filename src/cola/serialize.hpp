@@ -0,0 +1,33 @@
+#pragma once
+#ifndef COLA_SERIALIZE
+#define COLA_SERIALIZE
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <memory>
+#include "cola/ast.hpp"
+
+
+namespace cola {
+
+	/** Version of the binary format written by 'serialize'; loading a different version fails.
+	  */
+	static const std::uint32_t SERIALIZATION_VERSION = 1;
+
+	/** Writes a compact binary representation of 'program' (types, declarations, statements, options) to 'stream'.
+	  * Intended for caching preprocessed programs; the result is read back by 'deserialize_program' without the ANTLR runtime.
+	  */
+	void serialize(const Program& program, std::ostream& stream);
+
+	/** Reconstructs a program written by 'serialize'. Throws 'std::logic_error' on malformed input or version mismatch.
+	  */
+	std::shared_ptr<Program> deserialize_program(std::istream& stream);
+
+	void serialize(const Program& program, std::string filename);
+
+	std::shared_ptr<Program> deserialize_program(std::string filename);
+
+} // namespace cola
+
+#endif
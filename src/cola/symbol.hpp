@@ -0,0 +1,21 @@
+#pragma once
+#ifndef COLA_SYMBOL
+#define COLA_SYMBOL
+
+#include <cstdint>
+#include <string>
+
+
+namespace cola {
+
+	/** Small integer id of an interned identifier; equal strings map to equal ids (process-wide).
+	  */
+	using SymbolId = std::uint32_t;
+
+	/** Returns the id of 'name', adding it to the symbol table if necessary. Thread-safe.
+	  */
+	SymbolId intern(const std::string& name);
+
+} // namespace cola
+
+#endif
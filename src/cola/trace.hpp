@@ -0,0 +1,61 @@
+#pragma once
+#ifndef COLA_TRACE
+#define COLA_TRACE
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+
+namespace cola {
+
+	/** Timeline of verification phases in the Chrome trace event format (readable by 'chrome://tracing' and Perfetto).
+	  * Tracing is disabled by default; while it is, 'TraceScope' records nothing and costs a single atomic load.
+	  * Names that must be computed should be passed as a function, which is called only if tracing is enabled.
+	  * Events are collected process-wide and may be recorded from any thread.
+	  */
+	struct Trace {
+		/** Starts recording. Events recorded before are kept.
+		  */
+		static void enable();
+
+		static bool enabled();
+
+		/** Writes all events recorded so far as a JSON trace file.
+		  */
+		static void write(std::ostream& stream);
+	};
+
+	/** Records a complete event spanning its lifetime, provided tracing is enabled at construction.
+	  * Nested scopes show up as nested slices of the calling thread.
+	  */
+	class TraceScope {
+		private:
+			bool _active;
+			std::string _name;
+			const char* _category;
+			std::chrono::steady_clock::time_point _begin;
+
+			TraceScope(const char* category);
+			void start(std::string name);
+
+		public:
+			TraceScope(const char* category, const char* name);
+			TraceScope(const char* category, std::string name);
+
+			template<typename NameFunction, typename = std::enable_if_t<std::is_invocable_r_v<std::string, NameFunction&>>>
+			TraceScope(const char* category, NameFunction&& name) : TraceScope(category) {
+				if (_active) {
+					start(name());
+				}
+			}
+
+			TraceScope(const TraceScope& other) = delete;
+			TraceScope& operator=(const TraceScope& other) = delete;
+			~TraceScope();
+	};
+
+} // namespace cola
+
+#endif
@@ -41,17 +41,25 @@ namespace cola {
 	  */
 	void remove_cas(Program& program);
 
+	/** Performs 'remove_cas', 'remove_scoped_variables', 'remove_conditionals', and 'remove_useless_scopes' (in this order)
+	  * in a single bottom-up traversal. The result is identical to invoking the passes one after another.
+	  */
+	void desugar(Program& program);
+
+	/** Redirects 'enter' and 'exit' statements of the given program to other function declarations.
+	  * Calls to functions not contained in 'rebinding' are left untouched.
+	  * Used to let programs share the SMR functions (and thus the compiled observers) of another program.
+	  */
+	void rebind_functions(Program& program, const std::map<const Function*, const Function*>& rebinding);
+
 	/** Rewrites program to CoLa Light.
 	  */
 	inline void simplify(Program& program) {
 		// Note: removing conditionals should be done only after jump removal
 		// Reason: while(true) relies on breaks; but jump removal would add a assume(false)
 		remove_jumps(program);
-		remove_conditionals(program);
-		remove_scoped_variables(program);
+		desugar(program);
 		simplify_expressions(program);
-		remove_cas(program);
-		remove_useless_scopes(program);
 	}
 
 } // namespace cola
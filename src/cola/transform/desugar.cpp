@@ -0,0 +1,418 @@
+#include "cola/transform.hpp"
+#include "cola/util.hpp"
+#include <set>
+#include <typeindex>
+#include <unordered_map>
+
+using namespace cola;
+
+
+struct DesugarCasFinderVisitor final : public Visitor {
+	const CompareAndSwap* found = nullptr;
+	bool on_top_level = true;
+	bool found_low_level = false;
+
+	void visit(const VariableDeclaration& /*node*/) { on_top_level = false; }
+	void visit(const BooleanValue& /*node*/) { on_top_level = false; }
+	void visit(const NullValue& /*node*/) { on_top_level = false; }
+	void visit(const EmptyValue& /*node*/) { on_top_level = false; }
+	void visit(const MaxValue& /*node*/) { on_top_level = false; }
+	void visit(const MinValue& /*node*/) { on_top_level = false; }
+	void visit(const NDetValue& /*node*/) { on_top_level = false; }
+	void visit(const VariableExpression& /*node*/) { on_top_level = false; }
+	void visit(const NegatedExpression& node) {
+		on_top_level = false;
+		node.expr->accept(*this);
+	}
+	void visit(const BinaryExpression& node) {
+		on_top_level = false;
+		node.lhs->accept(*this);
+		node.rhs->accept(*this);
+	}
+	void visit(const Dereference& node) {
+		on_top_level = false;
+		node.expr->accept(*this);
+	}
+	void visit(const CompareAndSwap& node) {
+		if (!on_top_level) {
+			found_low_level = true;
+		}
+		found = &node;
+	}
+
+	void visit(const Expression& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Expression&)"); }
+	void visit(const InvariantExpression& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const InvariantExpression&)"); }
+	void visit(const InvariantActive& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const InvariantActive&)"); }
+	void visit(const Sequence& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Sequence&)"); }
+	void visit(const Scope& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Scope&)"); }
+	void visit(const Atomic& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Atomic&)"); }
+	void visit(const Choice& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Choice&)"); }
+	void visit(const IfThenElse& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const IfThenElse&)"); }
+	void visit(const Loop& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Loop&)"); }
+	void visit(const While& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const While&)"); }
+	void visit(const Skip& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Skip&)"); }
+	void visit(const Break& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Break&)"); }
+	void visit(const Continue& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Continue&)"); }
+	void visit(const Assume& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Assume&)"); }
+	void visit(const Assert& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Assert&)"); }
+	void visit(const AngelChoose& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const AngelChoose&)"); }
+	void visit(const AngelActive& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const AngelActive&)"); }
+	void visit(const AngelContains& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const AngelContains&)"); }
+	void visit(const Return& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Return&)"); }
+	void visit(const Malloc& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Malloc&)"); }
+	void visit(const Assignment& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Assignment&)"); }
+	void visit(const Enter& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Enter&)"); }
+	void visit(const Exit& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Exit&)"); }
+	void visit(const Macro& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Macro&)"); }
+	void visit(const Function& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Function&)"); }
+	void visit(const Program& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarCasFinderVisitor::visit(const Program&)"); }
+};
+
+
+/** Single bottom-up traversal performing 'remove_cas', 'remove_scoped_variables', 'remove_conditionals' and
+  * 'remove_useless_scopes' at once. Children of a statement are rewritten first; afterwards, the rules registered
+  * for the statement's dynamic type (see 'rule_table') are applied to the statement's slot until none fires.
+  * Rules may build fresh statements from already rewritten subtrees; they rewrite the fresh parts themselves via
+  * 'reduce' and never descend into the reused subtrees again.
+  *
+  * To match the sequential passes exactly:
+  *  - temporaries for CAS destinations are created in post-order and named against the top-level variables only,
+  *  - scoped variables are collected in pre-order and only renamed/hoisted once the whole function is rewritten.
+  */
+struct DesugarVisitor final : public NonConstVisitor {
+	using Rule = bool (DesugarVisitor::*)(std::unique_ptr<Statement>& slot);
+
+	Function* current_function = nullptr;
+	std::vector<std::unique_ptr<VariableDeclaration>> scoped_variables;
+	std::size_t rename_counter = 2;
+	bool in_atomic = false;
+	bool else_branch_is_skip = false; // whether the else branch of the 'IfThenElse' to be reduced consisted of a single 'skip'
+
+	static const std::unordered_map<std::type_index, std::vector<Rule>>& rule_table() {
+		static const std::unordered_map<std::type_index, std::vector<Rule>> table = {
+			{ std::type_index(typeid(CompareAndSwap)), { &DesugarVisitor::rule_cas } },
+			{ std::type_index(typeid(IfThenElse)), { &DesugarVisitor::rule_cas_condition, &DesugarVisitor::rule_conditional } },
+			{ std::type_index(typeid(While)), { &DesugarVisitor::rule_while } },
+			{ std::type_index(typeid(Scope)), { &DesugarVisitor::rule_useless_scope } },
+		};
+		return table;
+	}
+
+	void reduce(std::unique_ptr<Statement>& slot) {
+		const auto& table = rule_table();
+		while (true) {
+			auto rules = table.find(std::type_index(typeid(*slot)));
+			if (rules == table.end()) {
+				return;
+			}
+			bool fired = false;
+			for (Rule rule : rules->second) {
+				if ((this->*rule)(slot)) {
+					fired = true;
+					break;
+				}
+			}
+			if (!fired) {
+				return;
+			}
+		}
+	}
+
+	void rewrite(std::unique_ptr<Statement>& slot) {
+		slot->accept(*this);
+		reduce(slot);
+	}
+
+
+	/*********************** rules: CAS ***********************/
+
+	VariableDeclaration& make_tmp_var(const Type& type) {
+		assert(current_function);
+		std::set<std::string> names;
+		for (const auto& var : current_function->body->variables) {
+			names.insert(var->name);
+		}
+		std::size_t counter = 0;
+		std::string fix = (&type == &Type::bool_type()) ? "FLAG_" : "";
+		while (true) {
+			std::string var_name = "TMP_CAS_" + fix + std::to_string(counter) + "_";
+			if (names.count(var_name) == 0) {
+				current_function->body->variables.push_back(std::make_unique<VariableDeclaration>(var_name, type, false));
+				return *current_function->body->variables.back();
+			}
+			++counter;
+		}
+	}
+
+	std::pair<std::unique_ptr<Statement>, std::unique_ptr<Expression>> convert_cas_dst(const Expression& dst) {
+		std::pair<std::unique_ptr<Statement>, std::unique_ptr<Expression>> result;
+		if (dynamic_cast<const Dereference*>(&dst)) {
+			assert(dst.type().sort == Sort::PTR);
+			VariableDeclaration& tmp = make_tmp_var(dst.type());
+			result.first = std::make_unique<Assignment>(std::make_unique<VariableExpression>(tmp), cola::copy(dst));
+			result.second = std::make_unique<VariableExpression>(tmp);
+		} else if (dynamic_cast<const VariableExpression*>(&dst)) {
+			result.second = cola::copy(dst);
+		} else {
+			throw std::logic_error("Unexpected CAS destination: expected variable or dereference.");
+		}
+		return result;
+	}
+
+	std::unique_ptr<Statement> combine_cas_preamble_and_ite(std::unique_ptr<Statement> preamble, std::unique_ptr<Statement> ite) {
+		std::unique_ptr<Statement> stmt;
+		if (preamble) {
+			stmt = std::make_unique<Sequence>(std::move(preamble), std::move(ite));
+		} else {
+			stmt = std::move(ite);
+		}
+		if (in_atomic) {
+			return stmt;
+		} else {
+			return std::make_unique<Atomic>(std::make_unique<Scope>(std::move(stmt)));
+		}
+	}
+
+	bool rule_cas(std::unique_ptr<Statement>& slot) {
+		auto& cas = static_cast<CompareAndSwap&>(*slot);
+		if (cas.elems.size() != 1) {
+			throw std::logic_error("not yet implemented: desugaring of kCAS with k!=1");
+		}
+		auto& dst = *cas.elems.at(0).dst;
+		auto& cmp = *cas.elems.at(0).cmp;
+		auto& src = *cas.elems.at(0).src;
+		// replace cas with: if (dst == cmp) { dst = src; } else { skip; }
+		auto preamble = convert_cas_dst(dst).first;
+		auto condition = std::make_unique<BinaryExpression>(BinaryExpression::Operator::EQ, cola::copy(dst), cola::copy(cmp));
+		auto assignment = std::make_unique<Assignment>(cola::copy(dst), cola::copy(src));
+		std::unique_ptr<Statement> ite = std::make_unique<IfThenElse>(std::move(condition), std::make_unique<Scope>(std::move(assignment)), std::make_unique<Scope>(std::make_unique<Skip>()));
+		else_branch_is_skip = true;
+		reduce(ite);
+		slot = combine_cas_preamble_and_ite(std::move(preamble), std::move(ite));
+		return true;
+	}
+
+	bool rule_cas_condition(std::unique_ptr<Statement>& slot) {
+		auto& node = static_cast<IfThenElse&>(*slot);
+		DesugarCasFinderVisitor visitor;
+		node.expr->accept(visitor);
+		if (visitor.found == nullptr) {
+			return false;
+		}
+		assert(!visitor.found_low_level);
+		auto& cas = *visitor.found;
+		if (cas.elems.size() != 1) {
+			throw std::logic_error("not yet implemented: desugaring of kCAS with k!=1");
+		}
+		auto& dst = *cas.elems.at(0).dst;
+		auto& cmp = *cas.elems.at(0).cmp;
+		auto& src = *cas.elems.at(0).src;
+		// replace cas with: if (dst == cmp) { dst = src; } else { skip; }
+		auto [preamble, dstexpr] = convert_cas_dst(dst);
+		auto condition = std::make_unique<BinaryExpression>(BinaryExpression::Operator::EQ, std::move(dstexpr), cola::copy(cmp));
+		auto assignment = std::make_unique<Assignment>(cola::copy(dst), cola::copy(src));
+		if (in_atomic) {
+			auto true_body = std::make_unique<Sequence>(std::move(assignment), std::move(node.ifBranch));
+			reduce(true_body->second);
+			auto branch_true = std::make_unique<Scope>(std::move(true_body));
+			auto branch_false = std::move(node.elseBranch);
+			std::unique_ptr<Statement> ite = std::make_unique<IfThenElse>(std::move(condition), std::move(branch_true), std::move(branch_false));
+			reduce(ite); // 'else_branch_is_skip' still describes 'branch_false'
+			slot = combine_cas_preamble_and_ite(std::move(preamble), std::move(ite));
+		} else {
+			auto [preamblecopy, dstexprcopy] = convert_cas_dst(dst);
+			auto cas_false = combine_cas_preamble_and_ite(std::move(preamblecopy), std::make_unique<Assume>(cola::negate(*condition)));
+			auto cas_true = combine_cas_preamble_and_ite(std::move(preamble), std::make_unique<Sequence>(std::make_unique<Assume>(std::move(condition)), std::move(assignment)));
+			auto true_body = std::make_unique<Sequence>(std::move(cas_true), std::move(node.ifBranch));
+			auto false_body = std::make_unique<Sequence>(std::move(cas_false), std::move(node.elseBranch));
+			reduce(true_body->second);
+			reduce(false_body->second);
+			auto replacement = std::make_unique<Choice>();
+			replacement->branches.push_back(std::make_unique<Scope>(std::move(true_body)));
+			replacement->branches.push_back(std::make_unique<Scope>(std::move(false_body)));
+			slot = std::move(replacement);
+		}
+		return true;
+	}
+
+
+	/*********************** rules: conditionals ***********************/
+
+	void prepend_assumption(Scope& scope, std::unique_ptr<Expression> expr) {
+		auto assume = std::make_unique<Assume>(std::move(expr));
+		scope.body = std::make_unique<Sequence>(std::move(assume), std::move(scope.body));
+	}
+
+	bool rule_conditional(std::unique_ptr<Statement>& slot) {
+		auto& ite = static_cast<IfThenElse&>(*slot);
+		if (ite.elseBranch) {
+			auto expr = cola::negate(*ite.expr);
+			if (else_branch_is_skip) {
+				ite.elseBranch->body = std::make_unique<Assume>(std::move(expr));
+			} else {
+				prepend_assumption(*ite.elseBranch, std::move(expr));
+			}
+		}
+		prepend_assumption(*ite.ifBranch, std::move(ite.expr));
+
+		auto choice = std::make_unique<Choice>();
+		choice->branches.reserve(2);
+		choice->branches.push_back(std::move(ite.ifBranch));
+		choice->branches.push_back(std::move(ite.elseBranch));
+		slot = std::move(choice);
+		return true;
+	}
+
+	bool rule_while(std::unique_ptr<Statement>& slot) {
+		auto& whl = static_cast<While&>(*slot);
+		auto value = dynamic_cast<const BooleanValue*>(whl.expr.get());
+		if (value && value->value) {
+			return false;
+		}
+		auto expr = cola::negate(*whl.expr);
+		prepend_assumption(*whl.body, std::move(whl.expr));
+		auto loop = std::make_unique<Loop>(std::move(whl.body));
+		auto assume = std::make_unique<Assume>(std::move(expr));
+		slot = std::make_unique<Sequence>(std::move(loop), std::move(assume));
+		return true;
+	}
+
+
+	/*********************** rules: scopes ***********************/
+
+	bool rule_useless_scope(std::unique_ptr<Statement>& slot) {
+		// by construction: a scope in statement position is useless
+		auto& scope = static_cast<Scope&>(*slot);
+		if (scope.variables.size() != 0) {
+			throw std::logic_error("Rewrite error: cannot remove scope, contains variable declaration.");
+		}
+		slot = std::move(scope.body);
+		return true;
+	}
+
+	bool contains(const VariableDeclaration& decl) {
+		assert(current_function);
+		for (const auto& var : current_function->args) {
+			if (var->name == decl.name) {
+				return true;
+			}
+		}
+		for (const auto& var : current_function->body->variables) {
+			if (var->name == decl.name) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void hoist_scoped_variables() {
+		assert(current_function);
+		auto& variables = current_function->body->variables;
+		variables.reserve(variables.size() + scoped_variables.size());
+		for (auto& var : scoped_variables) {
+			if (contains(*var)) {
+				var->name = var->name + "_" + std::to_string(rename_counter++);
+				if (contains(*var)) {
+					throw std::logic_error("Name clash: cannot move variable with name '" + var->name + "', it exists in multiple loops; I tried to rename it but failed.");
+				}
+			}
+			variables.push_back(std::move(var));
+		}
+		scoped_variables.clear();
+	}
+
+
+	/*********************** traversal ***********************/
+
+	void visit(Program& program) {
+		program.initializer->accept(*this);
+		for (auto& function : program.functions) {
+			function->accept(*this);
+		}
+	}
+
+	void visit(Function& function) {
+		if (function.body) {
+			current_function = &function;
+			rewrite(function.body->body); // top level scope keeps its variables
+			hoist_scoped_variables();
+		}
+	}
+
+	void visit(Scope& scope) {
+		for (auto& var : scope.variables) {
+			scoped_variables.push_back(std::move(var));
+		}
+		scope.variables.clear();
+		rewrite(scope.body);
+	}
+
+	void visit(Sequence& sequence) {
+		rewrite(sequence.first);
+		rewrite(sequence.second);
+	}
+
+	void visit(Atomic& atomic) {
+		bool was_in_atomic = in_atomic;
+		in_atomic = true;
+		atomic.body->accept(*this);
+		in_atomic = was_in_atomic;
+	}
+
+	void visit(Choice& choice) {
+		for (auto& branch : choice.branches) {
+			branch->accept(*this);
+		}
+	}
+
+	void visit(IfThenElse& ite) {
+		bool skip = ite.elseBranch && dynamic_cast<const Skip*>(ite.elseBranch->body.get());
+		ite.ifBranch->accept(*this);
+		ite.elseBranch->accept(*this);
+		else_branch_is_skip = skip;
+	}
+
+	void visit(Loop& loop) {
+		loop.body->accept(*this);
+	}
+
+	void visit(While& whl) {
+		whl.body->accept(*this);
+	}
+
+	void visit(Skip& /*node*/) { /* do nothing */ }
+	void visit(Break& /*node*/) { /* do nothing */ }
+	void visit(Continue& /*node*/) { /* do nothing */ }
+	void visit(Assume& /*node*/) { /* do nothing */ }
+	void visit(Assert& /*node*/) { /* do nothing */ }
+	void visit(AngelChoose& /*node*/) { /* do nothing */ }
+	void visit(AngelActive& /*node*/) { /* do nothing */ }
+	void visit(AngelContains& /*node*/) { /* do nothing */ }
+	void visit(Return& /*node*/) { /* do nothing */ }
+	void visit(Malloc& /*node*/) { /* do nothing */ }
+	void visit(Assignment& /*node*/) { /* do nothing */ }
+	void visit(Enter& /*node*/) { /* do nothing */ }
+	void visit(Exit& /*node*/) { /* do nothing */ }
+	void visit(Macro& /*node*/) { /* do nothing */ }
+	void visit(CompareAndSwap& /*node*/) { /* do nothing */ }
+
+	void visit(VariableDeclaration& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarVisitor::visit(VariableDeclaration&)"); }
+	void visit(Expression& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarVisitor::visit(Expression&)"); }
+	void visit(BooleanValue& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarVisitor::visit(BooleanValue&)"); }
+	void visit(NullValue& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarVisitor::visit(NullValue&)"); }
+	void visit(EmptyValue& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarVisitor::visit(EmptyValue&)"); }
+	void visit(MaxValue& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarVisitor::visit(MaxValue&)"); }
+	void visit(MinValue& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarVisitor::visit(MinValue&)"); }
+	void visit(NDetValue& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarVisitor::visit(NDetValue&)"); }
+	void visit(VariableExpression& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarVisitor::visit(VariableExpression&)"); }
+	void visit(NegatedExpression& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarVisitor::visit(NegatedExpression&)"); }
+	void visit(BinaryExpression& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarVisitor::visit(BinaryExpression&)"); }
+	void visit(Dereference& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarVisitor::visit(Dereference&)"); }
+	void visit(InvariantExpression& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarVisitor::visit(InvariantExpression&)"); }
+	void visit(InvariantActive& /*node*/) { throw std::logic_error("Unexpected invocation: DesugarVisitor::visit(InvariantActive&)"); }
+};
+
+
+void cola::desugar(Program& program) {
+	DesugarVisitor().visit(program);
+}
@@ -0,0 +1,105 @@
+#include "cola/transform.hpp"
+
+using namespace cola;
+
+
+struct RebindFunctionsVisitor final : NonConstVisitor {
+	const std::map<const Function*, const Function*>& rebinding;
+	std::unique_ptr<Statement> replacement;
+	RebindFunctionsVisitor(const std::map<const Function*, const Function*>& rebinding) : rebinding(rebinding) {}
+
+	const Function* lookup(const Function& function) {
+		auto search = rebinding.find(&function);
+		return search == rebinding.end() ? nullptr : search->second;
+	}
+
+	void handle(std::unique_ptr<Statement>& stmt) {
+		assert(stmt);
+		stmt->accept(*this);
+		if (replacement) {
+			stmt = std::move(replacement);
+		}
+	}
+
+	void visit(Program& program) {
+		program.initializer->accept(*this);
+		for (auto& func : program.functions) {
+			func->accept(*this);
+		}
+	}
+
+	void visit(Function& function) {
+		if (function.body) {
+			function.body->accept(*this);
+		}
+	}
+
+	void visit(Scope& scope) { handle(scope.body); }
+	void visit(Sequence& sequence) {
+		handle(sequence.first);
+		handle(sequence.second);
+	}
+	void visit(Atomic& atomic) { atomic.body->accept(*this); }
+	void visit(Choice& choice) {
+		for (auto& scope : choice.branches) {
+			scope->accept(*this);
+		}
+	}
+	void visit(IfThenElse& ite) {
+		ite.ifBranch->accept(*this);
+		ite.elseBranch->accept(*this);
+	}
+	void visit(Loop& loop) { loop.body->accept(*this); }
+	void visit(While& whl) { whl.body->accept(*this); }
+
+	void visit(Enter& enter) {
+		if (auto target = lookup(enter.decl)) {
+			auto result = std::make_unique<Enter>(*target);
+			result->args = std::move(enter.args);
+			result->annotation = std::move(enter.annotation);
+			replacement = std::move(result);
+		}
+	}
+	void visit(Exit& exit) {
+		if (auto target = lookup(exit.decl)) {
+			auto result = std::make_unique<Exit>(*target);
+			result->annotation = std::move(exit.annotation);
+			replacement = std::move(result);
+		}
+	}
+
+	void visit(Skip& /*node*/) { /* do nothing */ }
+	void visit(Break& /*node*/) { /* do nothing */ }
+	void visit(Continue& /*node*/) { /* do nothing */ }
+	void visit(Assume& /*node*/) { /* do nothing */ }
+	void visit(Assert& /*node*/) { /* do nothing */ }
+	void visit(AngelChoose& /*node*/) { /* do nothing */ }
+	void visit(AngelActive& /*node*/) { /* do nothing */ }
+	void visit(AngelContains& /*node*/) { /* do nothing */ }
+	void visit(Return& /*node*/) { /* do nothing */ }
+	void visit(Malloc& /*node*/) { /* do nothing */ }
+	void visit(Assignment& /*node*/) { /* do nothing */ }
+	void visit(Macro& /*node*/) { /* do nothing */ }
+	void visit(CompareAndSwap& /*node*/) { /* do nothing */ }
+
+	void visit(VariableDeclaration& /*node*/) { throw std::logic_error("Unexpected invocation (NonConstVisitor::visit(VariableDeclaration&))"); }
+	void visit(Expression& /*node*/) { throw std::logic_error("Unexpected invocation (NonConstVisitor::visit(Expression&))"); }
+	void visit(BooleanValue& /*node*/) { throw std::logic_error("Unexpected invocation (NonConstVisitor::visit(BooleanValue&))"); }
+	void visit(NullValue& /*node*/) { throw std::logic_error("Unexpected invocation (NonConstVisitor::visit(NullValue&))"); }
+	void visit(EmptyValue& /*node*/) { throw std::logic_error("Unexpected invocation (NonConstVisitor::visit(EmptyValue&))"); }
+	void visit(MaxValue& /*node*/) { throw std::logic_error("Unexpected invocation (NonConstVisitor::visit(MaxValue&))"); }
+	void visit(MinValue& /*node*/) { throw std::logic_error("Unexpected invocation (NonConstVisitor::visit(MinValue&))"); }
+	void visit(NDetValue& /*node*/) { throw std::logic_error("Unexpected invocation (NonConstVisitor::visit(NDetValue&))"); }
+	void visit(VariableExpression& /*node*/) { throw std::logic_error("Unexpected invocation (NonConstVisitor::visit(VariableExpression&))"); }
+	void visit(NegatedExpression& /*node*/) { throw std::logic_error("Unexpected invocation (NonConstVisitor::visit(NegatedExpression&))"); }
+	void visit(BinaryExpression& /*node*/) { throw std::logic_error("Unexpected invocation (NonConstVisitor::visit(BinaryExpression&))"); }
+	void visit(Dereference& /*node*/) { throw std::logic_error("Unexpected invocation (NonConstVisitor::visit(Dereference&))"); }
+	void visit(InvariantExpression& /*node*/) { throw std::logic_error("Unexpected invocation (NonConstVisitor::visit(InvariantExpression&))"); }
+	void visit(InvariantActive& /*node*/) { throw std::logic_error("Unexpected invocation (NonConstVisitor::visit(InvariantActive&))"); }
+};
+
+
+void cola::rebind_functions(Program& program, const std::map<const Function*, const Function*>& rebinding) {
+	RebindFunctionsVisitor visitor(rebinding);
+	visitor.visit(program);
+}
@@ -0,0 +1,126 @@
+#include "cola/arena.hpp"
+
+#include <new>
+
+using namespace cola;
+
+
+struct alignas(alignof(std::max_align_t)) BlockHeader {
+	NodeArena* arena; // nullptr for oversized nodes allocated via the global 'operator new'
+	std::size_t size_class;
+};
+
+static thread_local NodeArena* current_arena = nullptr;
+
+
+NodeArena::~NodeArena() {
+	for (void* chunk : _chunks) {
+		::operator delete(chunk);
+	}
+}
+
+std::shared_ptr<NodeArena> NodeArena::make(bool synchronized) {
+	return std::shared_ptr<NodeArena>(new NodeArena(synchronized), [](NodeArena* arena) { arena->release(); });
+}
+
+NodeArena& NodeArena::global() {
+	static NodeArena* global_arena = new NodeArena(true); // never released; outlives static nodes; used by all threads
+	return *global_arena;
+}
+
+NodeArena& NodeArena::current() {
+	return current_arena ? *current_arena : global();
+}
+
+std::unique_lock<std::mutex> NodeArena::lock() {
+	return _synchronized ? std::unique_lock<std::mutex>(_mutex) : std::unique_lock<std::mutex>();
+}
+
+void NodeArena::release() {
+	bool drop;
+	{
+		auto guard = lock();
+		_released = true;
+		drop = _live == 0;
+	}
+	if (drop) {
+		delete this;
+	}
+}
+
+void* NodeArena::allocate_block(std::size_t size_class) {
+	auto guard = lock();
+	_live++;
+
+	void* result = _free_lists[size_class];
+	if (result) {
+		_free_lists[size_class] = *static_cast<void**>(result);
+		return result;
+	}
+
+	std::size_t block_size = (size_class + 1) * ALIGNMENT;
+	if (_cursor + block_size > _end) {
+		_cursor = static_cast<char*>(::operator new(CHUNK_SIZE));
+		_end = _cursor + CHUNK_SIZE;
+		_chunks.push_back(_cursor);
+	}
+	result = _cursor;
+	_cursor += block_size;
+	return result;
+}
+
+void* NodeArena::allocate(std::size_t size) {
+	std::size_t total = size + sizeof(BlockHeader);
+	std::size_t size_class = (total + ALIGNMENT - 1) / ALIGNMENT - 1;
+
+	BlockHeader* header;
+	if (size_class < NUM_SIZE_CLASSES) {
+		NodeArena& arena = current();
+		header = static_cast<BlockHeader*>(arena.allocate_block(size_class));
+		header->arena = &arena;
+	} else {
+		header = static_cast<BlockHeader*>(::operator new(total));
+		header->arena = nullptr;
+	}
+	header->size_class = size_class;
+	return header + 1;
+}
+
+void NodeArena::deallocate(void* ptr) noexcept {
+	if (!ptr) {
+		return;
+	}
+	BlockHeader* header = static_cast<BlockHeader*>(ptr) - 1;
+	NodeArena* arena = header->arena;
+	if (!arena) {
+		::operator delete(header);
+		return;
+	}
+
+	bool drop;
+	{
+		auto guard = arena->lock();
+		*reinterpret_cast<void**>(header) = arena->_free_lists[header->size_class];
+		arena->_free_lists[header->size_class] = header;
+		arena->_live--;
+		drop = arena->_released && arena->_live == 0;
+	}
+	if (drop) {
+		delete arena;
+	}
+}
+
+
+ArenaScope::ArenaScope(NodeArena& arena) : _previous(current_arena) {
+	current_arena = &arena;
+}
+
+ArenaScope::ArenaScope(const std::shared_ptr<NodeArena>& arena) : _previous(current_arena) {
+	if (arena) {
+		current_arena = arena.get();
+	}
+}
+
+ArenaScope::~ArenaScope() {
+	current_arena = _previous;
+}
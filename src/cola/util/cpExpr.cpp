@@ -60,7 +60,7 @@ struct CopyExpressionVisitor final : public Visitor {
 	void visit(const Dereference& expr) {
 		assert(!result);
 		expr.expr->accept(*this);
-		result = std::make_unique<Dereference>(std::move(result), expr.fieldname);
+		result = std::make_unique<Dereference>(std::move(result), expr.fieldname, expr.field_id);
 	}
 
 	void visit(const InvariantExpression& /*node*/) { throw std::logic_error("Unexpected invocation (CopyExpressionVisitor::visit(const InvariantExpression&))"); }
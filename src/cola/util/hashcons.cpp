@@ -0,0 +1,150 @@
+#include "cola/hashcons.hpp"
+
+#include <functional>
+
+using namespace cola;
+
+
+inline std::size_t combine_hash(std::size_t seed, std::size_t value) {
+	return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+struct HashConsVisitor final : public Visitor {
+	ExpressionTable& table;
+	const ExpressionInfo* result = nullptr;
+	HashConsVisitor(ExpressionTable& table) : table(table) {}
+
+	const ExpressionInfo& make_leaf(ExpressionInfo::Kind kind, std::size_t payload=0) {
+		ExpressionInfo info;
+		info.kind = kind;
+		info.payload = payload;
+		return table.make(std::move(info));
+	}
+
+	void visit(const BooleanValue& node) { result = &make_leaf(ExpressionInfo::Kind::BOOL, node.value ? 1 : 0); }
+	void visit(const NullValue& /*node*/) { result = &make_leaf(ExpressionInfo::Kind::NULLPTR); }
+	void visit(const EmptyValue& /*node*/) { result = &make_leaf(ExpressionInfo::Kind::EMPTY); }
+	void visit(const MaxValue& /*node*/) { result = &make_leaf(ExpressionInfo::Kind::MAX); }
+	void visit(const MinValue& /*node*/) { result = &make_leaf(ExpressionInfo::Kind::MIN); }
+	void visit(const NDetValue& /*node*/) { result = &make_leaf(ExpressionInfo::Kind::NDET); }
+	void visit(const VariableExpression& node) {
+		ExpressionInfo info;
+		info.kind = ExpressionInfo::Kind::VARIABLE;
+		info.decl = &node.decl;
+		result = &table.make(std::move(info));
+	}
+	void visit(const NegatedExpression& node) {
+		ExpressionInfo info;
+		info.kind = ExpressionInfo::Kind::NEGATION;
+		info.lhs = &table[*node.expr];
+		result = &table.make(std::move(info));
+	}
+	void visit(const BinaryExpression& node) {
+		ExpressionInfo info;
+		info.kind = ExpressionInfo::Kind::BINARY;
+		info.payload = static_cast<std::size_t>(node.op);
+		info.lhs = &table[*node.lhs];
+		info.rhs = &table[*node.rhs];
+		result = &table.make(std::move(info));
+	}
+	void visit(const Dereference& node) {
+		ExpressionInfo info;
+		info.kind = ExpressionInfo::Kind::DEREFERENCE;
+		info.payload = node.field_id;
+		info.lhs = &table[*node.expr];
+		result = &table.make(std::move(info));
+	}
+
+	void visit(const Expression& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Expression&)"); }
+	void visit(const CompareAndSwap& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const CompareAndSwap&)"); }
+	void visit(const VariableDeclaration& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const VariableDeclaration&)"); }
+	void visit(const InvariantExpression& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const InvariantExpression&)"); }
+	void visit(const InvariantActive& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const InvariantActive&)"); }
+	void visit(const Sequence& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Sequence&)"); }
+	void visit(const Scope& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Scope&)"); }
+	void visit(const Atomic& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Atomic&)"); }
+	void visit(const Choice& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Choice&)"); }
+	void visit(const IfThenElse& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const IfThenElse&)"); }
+	void visit(const Loop& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Loop&)"); }
+	void visit(const While& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const While&)"); }
+	void visit(const Skip& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Skip&)"); }
+	void visit(const Break& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Break&)"); }
+	void visit(const Continue& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Continue&)"); }
+	void visit(const Assume& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Assume&)"); }
+	void visit(const Assert& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Assert&)"); }
+	void visit(const AngelChoose& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const AngelChoose&)"); }
+	void visit(const AngelActive& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const AngelActive&)"); }
+	void visit(const AngelContains& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const AngelContains&)"); }
+	void visit(const Return& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Return&)"); }
+	void visit(const Malloc& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Malloc&)"); }
+	void visit(const Assignment& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Assignment&)"); }
+	void visit(const Enter& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Enter&)"); }
+	void visit(const Exit& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Exit&)"); }
+	void visit(const Macro& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Macro&)"); }
+	void visit(const Function& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Function&)"); }
+	void visit(const Program& /*node*/) { throw std::logic_error("Unexpected invocation: HashConsVisitor::visit(const Program&)"); }
+};
+
+
+bool ExpressionTable::InfoEqual::operator()(const ExpressionInfo* info, const ExpressionInfo* other) const {
+	// children are hash-consed already, comparing them by address suffices
+	return info->kind == other->kind
+	    && info->payload == other->payload
+	    && info->decl == other->decl
+	    && info->lhs == other->lhs
+	    && info->rhs == other->rhs;
+}
+
+const ExpressionInfo& ExpressionTable::make(ExpressionInfo info) {
+	info.hash = combine_hash(static_cast<std::size_t>(info.kind), info.payload);
+	info.hash = combine_hash(info.hash, std::hash<const void*>()(info.decl));
+	info.hash = combine_hash(info.hash, info.lhs ? info.lhs->hash : 0);
+	info.hash = combine_hash(info.hash, info.rhs ? info.rhs->hash : 0);
+
+	auto existing = _infos.find(&info);
+	if (existing != _infos.end()) {
+		return **existing;
+	}
+
+	// attributes are derived once per distinct expression
+	if (info.decl) {
+		info.is_local = !info.decl->is_shared;
+		info.variables.insert(info.decl);
+	}
+	for (const ExpressionInfo* child : { info.lhs, info.rhs }) {
+		if (child) {
+			info.is_local &= child->is_local;
+			info.variables.insert(child->variables.begin(), child->variables.end());
+		}
+	}
+	if (info.kind == ExpressionInfo::Kind::DEREFERENCE) {
+		info.is_local = false; // memory access may not be local
+	}
+
+	_storage.push_back(std::move(info));
+	_infos.insert(&_storage.back());
+	return _storage.back();
+}
+
+const ExpressionInfo& ExpressionTable::operator[](const Expression& expr) {
+	auto known = _nodes.find(&expr);
+	if (known != _nodes.end()) {
+		return *known->second;
+	}
+	HashConsVisitor visitor(*this);
+	expr.accept(visitor);
+	assert(visitor.result);
+	_nodes[&expr] = visitor.result;
+	return *visitor.result;
+}
+
+
+std::size_t cola::structural_hash(const Expression& expr) {
+	ExpressionTable table;
+	return table[expr].hash;
+}
+
+bool cola::structurally_equal(const Expression& expr, const Expression& other) {
+	ExpressionTable table;
+	return table.equal(expr, other);
+}
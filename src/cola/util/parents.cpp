@@ -0,0 +1,119 @@
+#include "cola/parents.hpp"
+
+#include <stdexcept>
+
+using namespace cola;
+
+
+struct ParentIndexVisitor final : public NonConstVisitor {
+	std::unordered_map<const Statement*, StatementLocation>& locations;
+	Function* function;
+	ParentIndexVisitor(std::unordered_map<const Statement*, StatementLocation>& locations, Function* function) : locations(locations), function(function) {}
+
+	void handle(Statement& stmt, Statement* parent, std::unique_ptr<Statement>* owner) {
+		StatementLocation location;
+		location.function = function;
+		location.parent = parent;
+		location.owner = owner;
+		locations[&stmt] = location;
+		stmt.accept(*this);
+	}
+	void handle(std::unique_ptr<Statement>& slot, Statement& parent) {
+		assert(slot);
+		handle(*slot, &parent, &slot);
+	}
+	void handle(std::unique_ptr<Scope>& scope, Statement& parent) {
+		assert(scope);
+		handle(*scope, &parent, nullptr);
+	}
+
+	void visit(Sequence& node) {
+		handle(node.first, node);
+		handle(node.second, node);
+	}
+	void visit(Scope& node) { handle(node.body, node); }
+	void visit(Atomic& node) { handle(node.body, node); }
+	void visit(Choice& node) {
+		for (auto& branch : node.branches) {
+			handle(branch, node);
+		}
+	}
+	void visit(IfThenElse& node) {
+		handle(node.ifBranch, node);
+		handle(node.elseBranch, node);
+	}
+	void visit(Loop& node) { handle(node.body, node); }
+	void visit(While& node) { handle(node.body, node); }
+
+	void visit(Skip& /*node*/) { /* do nothing */ }
+	void visit(Break& /*node*/) { /* do nothing */ }
+	void visit(Continue& /*node*/) { /* do nothing */ }
+	void visit(Assume& /*node*/) { /* do nothing */ }
+	void visit(Assert& /*node*/) { /* do nothing */ }
+	void visit(AngelChoose& /*node*/) { /* do nothing */ }
+	void visit(AngelActive& /*node*/) { /* do nothing */ }
+	void visit(AngelContains& /*node*/) { /* do nothing */ }
+	void visit(Return& /*node*/) { /* do nothing */ }
+	void visit(Malloc& /*node*/) { /* do nothing */ }
+	void visit(Assignment& /*node*/) { /* do nothing */ }
+	void visit(Enter& /*node*/) { /* do nothing */ }
+	void visit(Exit& /*node*/) { /* do nothing */ }
+	void visit(Macro& /*node*/) { /* do nothing */ }
+	void visit(CompareAndSwap& /*node*/) { /* do nothing */ }
+
+	void visit(VariableDeclaration& /*node*/) { throw std::logic_error("Unexpected invocation: ParentIndexVisitor::visit(VariableDeclaration&)"); }
+	void visit(Expression& /*node*/) { throw std::logic_error("Unexpected invocation: ParentIndexVisitor::visit(Expression&)"); }
+	void visit(BooleanValue& /*node*/) { throw std::logic_error("Unexpected invocation: ParentIndexVisitor::visit(BooleanValue&)"); }
+	void visit(NullValue& /*node*/) { throw std::logic_error("Unexpected invocation: ParentIndexVisitor::visit(NullValue&)"); }
+	void visit(EmptyValue& /*node*/) { throw std::logic_error("Unexpected invocation: ParentIndexVisitor::visit(EmptyValue&)"); }
+	void visit(MaxValue& /*node*/) { throw std::logic_error("Unexpected invocation: ParentIndexVisitor::visit(MaxValue&)"); }
+	void visit(MinValue& /*node*/) { throw std::logic_error("Unexpected invocation: ParentIndexVisitor::visit(MinValue&)"); }
+	void visit(NDetValue& /*node*/) { throw std::logic_error("Unexpected invocation: ParentIndexVisitor::visit(NDetValue&)"); }
+	void visit(VariableExpression& /*node*/) { throw std::logic_error("Unexpected invocation: ParentIndexVisitor::visit(VariableExpression&)"); }
+	void visit(NegatedExpression& /*node*/) { throw std::logic_error("Unexpected invocation: ParentIndexVisitor::visit(NegatedExpression&)"); }
+	void visit(BinaryExpression& /*node*/) { throw std::logic_error("Unexpected invocation: ParentIndexVisitor::visit(BinaryExpression&)"); }
+	void visit(Dereference& /*node*/) { throw std::logic_error("Unexpected invocation: ParentIndexVisitor::visit(Dereference&)"); }
+	void visit(InvariantExpression& /*node*/) { throw std::logic_error("Unexpected invocation: ParentIndexVisitor::visit(InvariantExpression&)"); }
+	void visit(InvariantActive& /*node*/) { throw std::logic_error("Unexpected invocation: ParentIndexVisitor::visit(InvariantActive&)"); }
+	void visit(Function& /*node*/) { throw std::logic_error("Unexpected invocation: ParentIndexVisitor::visit(Function&)"); }
+	void visit(Program& /*node*/) { throw std::logic_error("Unexpected invocation: ParentIndexVisitor::visit(Program&)"); }
+};
+
+
+void ParentIndex::index(Statement& stmt, StatementLocation location) {
+	ParentIndexVisitor visitor(_locations, location.function);
+	visitor.handle(stmt, location.parent, location.owner);
+}
+
+ParentIndex::ParentIndex(Program& program) {
+	auto index_function = [this](Function& function) {
+		if (function.body) {
+			StatementLocation location;
+			location.function = &function;
+			index(*function.body, location);
+		}
+	};
+	if (program.initializer) {
+		index_function(*program.initializer);
+	}
+	for (auto& function : program.functions) {
+		index_function(*function);
+	}
+}
+
+const StatementLocation& ParentIndex::operator[](const Statement& stmt) const {
+	auto search = _locations.find(&stmt);
+	if (search == _locations.end()) {
+		throw std::logic_error("Statement not contained in parent index.");
+	}
+	return search->second;
+}
+
+void ParentIndex::update(std::unique_ptr<Statement>& slot, Statement* parent, Function& function) {
+	assert(slot);
+	StatementLocation location;
+	location.function = &function;
+	location.parent = parent;
+	location.owner = &slot;
+	index(*slot, location);
+}
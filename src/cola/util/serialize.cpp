@@ -0,0 +1,722 @@
+#include "cola/serialize.hpp"
+#include <fstream>
+#include <map>
+#include <vector>
+#include <stdexcept>
+
+using namespace cola;
+
+
+static const char MAGIC[] = { 'C', 'O', 'L', 'A', 'A', 'S', 'T', '\0' };
+
+enum struct Tag : std::uint8_t {
+	// expressions
+	BOOL_VALUE, NULL_VALUE, EMPTY_VALUE, MAX_VALUE, MIN_VALUE, NDET_VALUE, VARIABLE, NEGATION, BINARY, DEREFERENCE,
+	// invariants
+	INVARIANT_EXPRESSION, INVARIANT_ACTIVE,
+	// statements
+	SEQUENCE, SCOPE, ATOMIC, CHOICE, ITE, LOOP, WHILE,
+	// commands
+	SKIP, BREAK, CONTINUE, ASSUME, ASSERT, ANGEL_CHOOSE, ANGEL_ACTIVE, ANGEL_CONTAINS, RETURN, MALLOC, ASSIGNMENT, ENTER, EXIT, MACRO, CAS,
+	// misc
+	NONE
+};
+
+enum BuiltinType : std::uint64_t { VOID_TYPE, BOOL_TYPE, DATA_TYPE, NULL_TYPE, NUM_BUILTIN_TYPES };
+
+
+/*--------------- writing ---------------*/
+
+struct Writer {
+	std::ostream& stream;
+	Writer(std::ostream& stream) : stream(stream) {}
+
+	void write_byte(std::uint8_t value) {
+		stream.put(static_cast<char>(value));
+	}
+	void write_number(std::uint64_t value) { // LEB128
+		do {
+			std::uint8_t byte = value & 0x7f;
+			value >>= 7;
+			if (value != 0) byte |= 0x80;
+			write_byte(byte);
+		} while (value != 0);
+	}
+	void write_tag(Tag tag) {
+		write_byte(static_cast<std::uint8_t>(tag));
+	}
+	void write_string(const std::string& value) {
+		write_number(value.size());
+		stream.write(value.data(), value.size());
+	}
+};
+
+struct SerializeVisitor final : public Visitor {
+	Writer writer;
+	std::map<const Type*, std::uint64_t> type2index;
+	std::map<const VariableDeclaration*, std::uint64_t> variable2index;
+	std::vector<const VariableDeclaration*> variables; // in scope; mirrors the indices the loader assigns
+	std::map<const Function*, std::uint64_t> function2index;
+
+	SerializeVisitor(std::ostream& stream) : writer(stream) {}
+
+	std::uint64_t type_index(const Type& type) {
+		if (&type == &Type::void_type()) return VOID_TYPE;
+		if (&type == &Type::bool_type()) return BOOL_TYPE;
+		if (&type == &Type::data_type()) return DATA_TYPE;
+		if (&type == &Type::null_type()) return NULL_TYPE;
+		auto find = type2index.find(&type);
+		if (find == type2index.end()) {
+			throw std::logic_error("Cannot serialize type '" + type.name + "': not declared by program.");
+		}
+		return find->second;
+	}
+
+	void register_declaration(const VariableDeclaration& decl) {
+		assert(variable2index.count(&decl) == 0);
+		variable2index[&decl] = variables.size();
+		variables.push_back(&decl);
+	}
+
+	void forget_declarations(std::size_t keep) {
+		while (variables.size() > keep) {
+			variable2index.erase(variables.back());
+			variables.pop_back();
+		}
+	}
+
+	void write_declaration(const VariableDeclaration& decl) {
+		register_declaration(decl);
+		writer.write_string(decl.name);
+		writer.write_number(type_index(decl.type));
+		writer.write_byte(decl.is_shared ? 1 : 0);
+	}
+
+	void write_reference(const VariableDeclaration& decl) {
+		auto find = variable2index.find(&decl);
+		if (find == variable2index.end()) {
+			throw std::logic_error("Cannot serialize reference to variable '" + decl.name + "': not in scope.");
+		}
+		writer.write_number(find->second);
+	}
+
+	void write_reference(const Function& function) {
+		auto find = function2index.find(&function);
+		if (find == function2index.end()) {
+			throw std::logic_error("Cannot serialize reference to function '" + function.name + "': not declared by program.");
+		}
+		writer.write_number(find->second);
+	}
+
+	void write_annotation(const AnnotatedStatement& stmt) {
+		if (stmt.annotation) {
+			stmt.annotation->accept(*this);
+		} else {
+			writer.write_tag(Tag::NONE);
+		}
+	}
+
+	void write_arguments(const std::vector<std::unique_ptr<Expression>>& args) {
+		writer.write_number(args.size());
+		for (const auto& arg : args) {
+			arg->accept(*this);
+		}
+	}
+
+	void visit(const VariableDeclaration& /*node*/) override { throw std::logic_error("Unexpected invocation: SerializeVisitor::visit(const VariableDeclaration&)"); }
+	void visit(const Expression& /*node*/) override { throw std::logic_error("Unexpected invocation: SerializeVisitor::visit(const Expression&)"); }
+
+	void visit(const BooleanValue& node) override { writer.write_tag(Tag::BOOL_VALUE); writer.write_byte(node.value ? 1 : 0); }
+	void visit(const NullValue& /*node*/) override { writer.write_tag(Tag::NULL_VALUE); }
+	void visit(const EmptyValue& /*node*/) override { writer.write_tag(Tag::EMPTY_VALUE); }
+	void visit(const MaxValue& /*node*/) override { writer.write_tag(Tag::MAX_VALUE); }
+	void visit(const MinValue& /*node*/) override { writer.write_tag(Tag::MIN_VALUE); }
+	void visit(const NDetValue& /*node*/) override { writer.write_tag(Tag::NDET_VALUE); }
+	void visit(const VariableExpression& node) override { writer.write_tag(Tag::VARIABLE); write_reference(node.decl); }
+	void visit(const NegatedExpression& node) override { writer.write_tag(Tag::NEGATION); node.expr->accept(*this); }
+	void visit(const BinaryExpression& node) override {
+		writer.write_tag(Tag::BINARY);
+		writer.write_byte(static_cast<std::uint8_t>(node.op));
+		node.lhs->accept(*this);
+		node.rhs->accept(*this);
+	}
+	void visit(const Dereference& node) override {
+		writer.write_tag(Tag::DEREFERENCE);
+		writer.write_string(node.fieldname);
+		node.expr->accept(*this);
+	}
+	void visit(const InvariantExpression& node) override { writer.write_tag(Tag::INVARIANT_EXPRESSION); node.expr->accept(*this); }
+	void visit(const InvariantActive& node) override { writer.write_tag(Tag::INVARIANT_ACTIVE); node.expr->accept(*this); }
+
+	void visit(const Sequence& node) override {
+		writer.write_tag(Tag::SEQUENCE);
+		node.first->accept(*this);
+		node.second->accept(*this);
+	}
+	void visit(const Scope& node) override {
+		writer.write_tag(Tag::SCOPE);
+		writer.write_number(node.variables.size());
+		for (const auto& decl : node.variables) {
+			write_declaration(*decl);
+		}
+		node.body->accept(*this);
+	}
+	void visit(const Atomic& node) override {
+		writer.write_tag(Tag::ATOMIC);
+		write_annotation(node);
+		node.body->accept(*this);
+	}
+	void visit(const Choice& node) override {
+		writer.write_tag(Tag::CHOICE);
+		writer.write_number(node.branches.size());
+		for (const auto& branch : node.branches) {
+			branch->accept(*this);
+		}
+	}
+	void visit(const IfThenElse& node) override {
+		writer.write_tag(Tag::ITE);
+		write_annotation(node);
+		node.expr->accept(*this);
+		node.ifBranch->accept(*this);
+		node.elseBranch->accept(*this);
+	}
+	void visit(const Loop& node) override {
+		writer.write_tag(Tag::LOOP);
+		node.body->accept(*this);
+	}
+	void visit(const While& node) override {
+		writer.write_tag(Tag::WHILE);
+		write_annotation(node);
+		node.expr->accept(*this);
+		node.body->accept(*this);
+	}
+
+	void visit(const Skip& node) override { writer.write_tag(Tag::SKIP); write_annotation(node); }
+	void visit(const Break& node) override { writer.write_tag(Tag::BREAK); write_annotation(node); }
+	void visit(const Continue& node) override { writer.write_tag(Tag::CONTINUE); write_annotation(node); }
+	void visit(const Assume& node) override { writer.write_tag(Tag::ASSUME); write_annotation(node); node.expr->accept(*this); }
+	void visit(const Assert& node) override { writer.write_tag(Tag::ASSERT); write_annotation(node); node.inv->accept(*this); }
+	void visit(const AngelChoose& node) override { writer.write_tag(Tag::ANGEL_CHOOSE); write_annotation(node); writer.write_byte(node.active ? 1 : 0); }
+	void visit(const AngelActive& node) override { writer.write_tag(Tag::ANGEL_ACTIVE); write_annotation(node); }
+	void visit(const AngelContains& node) override { writer.write_tag(Tag::ANGEL_CONTAINS); write_annotation(node); write_reference(node.var); }
+	void visit(const Return& node) override {
+		writer.write_tag(Tag::RETURN);
+		write_annotation(node);
+		if (node.expr) {
+			node.expr->accept(*this);
+		} else {
+			writer.write_tag(Tag::NONE);
+		}
+	}
+	void visit(const Malloc& node) override { writer.write_tag(Tag::MALLOC); write_annotation(node); write_reference(node.lhs); }
+	void visit(const Assignment& node) override {
+		writer.write_tag(Tag::ASSIGNMENT);
+		write_annotation(node);
+		node.lhs->accept(*this);
+		node.rhs->accept(*this);
+	}
+	void visit(const Enter& node) override {
+		writer.write_tag(Tag::ENTER);
+		write_annotation(node);
+		write_reference(node.decl);
+		write_arguments(node.args);
+	}
+	void visit(const Exit& node) override {
+		writer.write_tag(Tag::EXIT);
+		write_annotation(node);
+		write_reference(node.decl);
+	}
+	void visit(const Macro& node) override {
+		writer.write_tag(Tag::MACRO);
+		write_annotation(node);
+		write_reference(node.decl);
+		write_arguments(node.args);
+	}
+	void visit(const CompareAndSwap& node) override {
+		writer.write_tag(Tag::CAS);
+		write_annotation(node);
+		writer.write_number(node.elems.size());
+		for (const auto& elem : node.elems) {
+			elem.dst->accept(*this);
+			elem.cmp->accept(*this);
+			elem.src->accept(*this);
+		}
+	}
+
+	void write_function_header(const Function& function) {
+		writer.write_string(function.name);
+		writer.write_number(type_index(function.return_type));
+		writer.write_byte(static_cast<std::uint8_t>(function.kind));
+		writer.write_number(function.args.size());
+		for (const auto& decl : function.args) {
+			write_declaration(*decl);
+		}
+	}
+
+	void visit(const Function& function) override {
+		// header is written upfront (see Program) to allow for forward references
+		if (function.body) {
+			function.body->accept(*this);
+		} else {
+			writer.write_tag(Tag::NONE);
+		}
+	}
+
+	void visit(const Program& program) override {
+		writer.stream.write(MAGIC, sizeof(MAGIC));
+		writer.write_number(SERIALIZATION_VERSION);
+		writer.write_string(program.name);
+
+		writer.write_number(program.options.size());
+		for (const auto& [key, value] : program.options) {
+			writer.write_string(key);
+			writer.write_string(value);
+		}
+
+		// types: names first, fields second (fields may refer to any type)
+		writer.write_number(program.types.size());
+		for (const auto& type : program.types) {
+			type2index[type.get()] = NUM_BUILTIN_TYPES + type2index.size();
+			writer.write_string(type->name);
+			writer.write_byte(static_cast<std::uint8_t>(type->sort));
+		}
+		for (const auto& type : program.types) {
+			writer.write_number(type->fields.size());
+			for (const auto& [name, field_type] : type->fields) {
+				writer.write_string(name);
+				writer.write_number(type_index(field_type));
+			}
+		}
+
+		writer.write_number(program.variables.size());
+		for (const auto& decl : program.variables) {
+			write_declaration(*decl);
+		}
+		std::size_t num_globals = variables.size();
+
+		// functions: headers first, bodies second (bodies may call any function)
+		writer.write_number(program.functions.size());
+		for (const auto& function : program.functions) {
+			function2index[function.get()] = function2index.size();
+			write_function_header(*function);
+		}
+		write_function_header(*program.initializer);
+		forget_declarations(num_globals);
+
+		// arguments and locals are visible only within their function
+		auto write_body = [&,this](const Function& function) {
+			for (const auto& decl : function.args) {
+				register_declaration(*decl);
+			}
+			function.accept(*this);
+			forget_declarations(num_globals);
+		};
+		for (const auto& function : program.functions) {
+			write_body(*function);
+		}
+		write_body(*program.initializer);
+	}
+};
+
+void cola::serialize(const Program& program, std::ostream& stream) {
+	SerializeVisitor visitor(stream);
+	program.accept(visitor);
+	if (!stream) {
+		throw std::logic_error("Could not write serialized program.");
+	}
+}
+
+void cola::serialize(const Program& program, std::string filename) {
+	std::ofstream file(filename, std::ios::binary);
+	serialize(program, file);
+}
+
+
+/*--------------- reading ---------------*/
+
+struct Reader {
+	std::istream& stream;
+	Reader(std::istream& stream) : stream(stream) {}
+
+	[[noreturn]] void fail(std::string reason) {
+		throw std::logic_error("Malformed serialized program: " + reason + ".");
+	}
+
+	std::uint8_t read_byte() {
+		auto value = stream.get();
+		if (value == std::istream::traits_type::eof()) {
+			fail("unexpected end of input");
+		}
+		return static_cast<std::uint8_t>(value);
+	}
+	std::uint64_t read_number() {
+		std::uint64_t result = 0;
+		for (unsigned shift = 0; shift < 64; shift += 7) {
+			std::uint8_t byte = read_byte();
+			result |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0) {
+				return result;
+			}
+		}
+		fail("number too large");
+	}
+	Tag read_tag() {
+		auto tag = read_byte();
+		if (tag > static_cast<std::uint8_t>(Tag::NONE)) {
+			fail("unknown node tag " + std::to_string(tag));
+		}
+		return static_cast<Tag>(tag);
+	}
+	std::string read_string() {
+		auto size = read_number();
+		std::string result(size, '\0');
+		stream.read(result.data(), size);
+		if (static_cast<std::uint64_t>(stream.gcount()) != size) {
+			fail("unexpected end of input");
+		}
+		return result;
+	}
+};
+
+struct Deserializer {
+	Reader reader;
+	std::shared_ptr<Program> program;
+	std::vector<const Type*> types;
+	std::vector<const VariableDeclaration*> variables;
+	std::vector<Function*> functions;
+
+	Deserializer(std::istream& stream) : reader(stream), program(std::make_shared<Program>()) {
+		types = { &Type::void_type(), &Type::bool_type(), &Type::data_type(), &Type::null_type() };
+	}
+
+	template<typename T>
+	const T& lookup(const std::vector<const T*>& container, std::string what) {
+		auto index = reader.read_number();
+		if (index >= container.size()) {
+			reader.fail("reference to undeclared " + what);
+		}
+		return *container.at(index);
+	}
+
+	const Type& read_type() { return lookup(types, "type"); }
+	const VariableDeclaration& read_variable() { return lookup(variables, "variable"); }
+	const Function& read_function() {
+		auto index = reader.read_number();
+		if (index >= functions.size()) {
+			reader.fail("reference to undeclared function");
+		}
+		return *functions.at(index);
+	}
+
+	std::unique_ptr<VariableDeclaration> read_declaration() {
+		auto name = reader.read_string();
+		const Type& type = read_type();
+		bool is_shared = reader.read_byte() != 0;
+		auto result = std::make_unique<VariableDeclaration>(name, type, is_shared);
+		variables.push_back(result.get());
+		return result;
+	}
+
+	std::unique_ptr<Expression> read_expression() {
+		Tag tag = reader.read_tag();
+		switch (tag) {
+			case Tag::BOOL_VALUE: return std::make_unique<BooleanValue>(reader.read_byte() != 0);
+			case Tag::NULL_VALUE: return std::make_unique<NullValue>();
+			case Tag::EMPTY_VALUE: return std::make_unique<EmptyValue>();
+			case Tag::MAX_VALUE: return std::make_unique<MaxValue>();
+			case Tag::MIN_VALUE: return std::make_unique<MinValue>();
+			case Tag::NDET_VALUE: return std::make_unique<NDetValue>();
+			case Tag::VARIABLE: return std::make_unique<VariableExpression>(read_variable());
+			case Tag::NEGATION: return std::make_unique<NegatedExpression>(read_expression());
+			case Tag::BINARY: {
+				auto op = reader.read_byte();
+				if (op > static_cast<std::uint8_t>(BinaryExpression::Operator::OR)) {
+					reader.fail("unknown binary operator");
+				}
+				auto lhs = read_expression();
+				auto rhs = read_expression();
+				return std::make_unique<BinaryExpression>(static_cast<BinaryExpression::Operator>(op), std::move(lhs), std::move(rhs));
+			}
+			case Tag::DEREFERENCE: {
+				auto fieldname = reader.read_string();
+				auto expr = read_expression();
+				if (!expr->type().has_field(fieldname)) {
+					reader.fail("dereference of unknown field '" + fieldname + "'");
+				}
+				return std::make_unique<Dereference>(std::move(expr), fieldname);
+			}
+			case Tag::CAS: return read_cas();
+			default: reader.fail("expected expression");
+		}
+	}
+
+	std::unique_ptr<Invariant> read_invariant(Tag tag) {
+		switch (tag) {
+			case Tag::INVARIANT_EXPRESSION: return std::make_unique<InvariantExpression>(read_expression());
+			case Tag::INVARIANT_ACTIVE: return std::make_unique<InvariantActive>(read_expression());
+			default: reader.fail("expected invariant");
+		}
+	}
+
+	std::unique_ptr<Invariant> read_invariant() {
+		return read_invariant(reader.read_tag());
+	}
+
+	std::unique_ptr<Invariant> read_annotation() {
+		Tag tag = reader.read_tag();
+		if (tag == Tag::NONE) {
+			return nullptr;
+		}
+		return read_invariant(tag);
+	}
+
+	template<typename T>
+	std::unique_ptr<T> annotate(std::unique_ptr<Invariant> annotation, std::unique_ptr<T> stmt) {
+		stmt->annotation = std::move(annotation);
+		return stmt;
+	}
+
+	void read_arguments(std::vector<std::unique_ptr<Expression>>& args) {
+		auto size = reader.read_number();
+		for (std::uint64_t index = 0; index < size; ++index) {
+			args.push_back(read_expression());
+		}
+	}
+
+	std::unique_ptr<CompareAndSwap> read_cas() {
+		auto annotation = read_annotation();
+		auto result = std::make_unique<CompareAndSwap>();
+		result->annotation = std::move(annotation);
+		auto size = reader.read_number();
+		for (std::uint64_t index = 0; index < size; ++index) {
+			auto dst = read_expression();
+			auto cmp = read_expression();
+			auto src = read_expression();
+			result->elems.emplace_back(std::move(dst), std::move(cmp), std::move(src));
+		}
+		return result;
+	}
+
+	std::unique_ptr<Scope> read_scope() {
+		if (reader.read_tag() != Tag::SCOPE) {
+			reader.fail("expected scope");
+		}
+		return read_scope_content();
+	}
+
+	std::unique_ptr<Scope> read_scope_content() {
+		auto size = reader.read_number();
+		std::vector<std::unique_ptr<VariableDeclaration>> decls;
+		for (std::uint64_t index = 0; index < size; ++index) {
+			decls.push_back(read_declaration());
+		}
+		auto result = std::make_unique<Scope>(read_statement());
+		result->variables = std::move(decls);
+		return result;
+	}
+
+	std::unique_ptr<Statement> read_statement() {
+		Tag tag = reader.read_tag();
+		switch (tag) {
+			case Tag::SEQUENCE: {
+				auto first = read_statement();
+				auto second = read_statement();
+				return std::make_unique<Sequence>(std::move(first), std::move(second));
+			}
+			case Tag::SCOPE: return read_scope_content();
+			case Tag::ATOMIC: {
+				auto annotation = read_annotation();
+				return annotate(std::move(annotation), std::make_unique<Atomic>(read_scope()));
+			}
+			case Tag::CHOICE: {
+				auto result = std::make_unique<Choice>();
+				auto size = reader.read_number();
+				for (std::uint64_t index = 0; index < size; ++index) {
+					result->branches.push_back(read_scope());
+				}
+				return result;
+			}
+			case Tag::ITE: {
+				auto annotation = read_annotation();
+				auto expr = read_expression();
+				auto ifBranch = read_scope();
+				auto elseBranch = read_scope();
+				return annotate(std::move(annotation), std::make_unique<IfThenElse>(std::move(expr), std::move(ifBranch), std::move(elseBranch)));
+			}
+			case Tag::LOOP: return std::make_unique<Loop>(read_scope());
+			case Tag::WHILE: {
+				auto annotation = read_annotation();
+				auto expr = read_expression();
+				auto body = read_scope();
+				return annotate(std::move(annotation), std::make_unique<While>(std::move(expr), std::move(body)));
+			}
+			case Tag::SKIP: return annotate(read_annotation(), std::make_unique<Skip>());
+			case Tag::BREAK: return annotate(read_annotation(), std::make_unique<Break>());
+			case Tag::CONTINUE: return annotate(read_annotation(), std::make_unique<Continue>());
+			case Tag::ASSUME: {
+				auto annotation = read_annotation();
+				return annotate(std::move(annotation), std::make_unique<Assume>(read_expression()));
+			}
+			case Tag::ASSERT: {
+				auto annotation = read_annotation();
+				return annotate(std::move(annotation), std::make_unique<Assert>(read_invariant()));
+			}
+			case Tag::ANGEL_CHOOSE: {
+				auto annotation = read_annotation();
+				return annotate(std::move(annotation), std::make_unique<AngelChoose>(reader.read_byte() != 0));
+			}
+			case Tag::ANGEL_ACTIVE: return annotate(read_annotation(), std::make_unique<AngelActive>());
+			case Tag::ANGEL_CONTAINS: {
+				auto annotation = read_annotation();
+				return annotate(std::move(annotation), std::make_unique<AngelContains>(read_variable()));
+			}
+			case Tag::RETURN: {
+				auto annotation = read_annotation();
+				if (reader.stream.peek() == static_cast<int>(Tag::NONE)) {
+					reader.read_tag();
+					return annotate(std::move(annotation), std::make_unique<Return>());
+				}
+				return annotate(std::move(annotation), std::make_unique<Return>(read_expression()));
+			}
+			case Tag::MALLOC: {
+				auto annotation = read_annotation();
+				return annotate(std::move(annotation), std::make_unique<Malloc>(read_variable()));
+			}
+			case Tag::ASSIGNMENT: {
+				auto annotation = read_annotation();
+				auto lhs = read_expression();
+				auto rhs = read_expression();
+				return annotate(std::move(annotation), std::make_unique<Assignment>(std::move(lhs), std::move(rhs)));
+			}
+			case Tag::ENTER: {
+				auto annotation = read_annotation();
+				auto result = std::make_unique<Enter>(read_function());
+				read_arguments(result->args);
+				return annotate(std::move(annotation), std::move(result));
+			}
+			case Tag::EXIT: {
+				auto annotation = read_annotation();
+				return annotate(std::move(annotation), std::make_unique<Exit>(read_function()));
+			}
+			case Tag::MACRO: {
+				auto annotation = read_annotation();
+				auto result = std::make_unique<Macro>(read_function());
+				read_arguments(result->args);
+				return annotate(std::move(annotation), std::move(result));
+			}
+			case Tag::CAS: return read_cas();
+			default: reader.fail("expected statement");
+		}
+	}
+
+	std::unique_ptr<Function> read_function_header() {
+		auto name = reader.read_string();
+		const Type& return_type = read_type();
+		auto kind = reader.read_byte();
+		if (kind > Function::MACRO) {
+			reader.fail("unknown function kind");
+		}
+		auto result = std::make_unique<Function>(name, return_type, static_cast<Function::Kind>(kind));
+		auto size = reader.read_number();
+		for (std::uint64_t index = 0; index < size; ++index) {
+			result->args.push_back(read_declaration());
+		}
+		return result;
+	}
+
+	void read_function_body(Function& function) {
+		if (reader.stream.peek() == static_cast<int>(Tag::NONE)) {
+			reader.read_tag();
+		} else {
+			function.body = read_scope();
+		}
+		// local variables are not visible to other functions
+		variables.resize(global_variable_count);
+	}
+
+	std::size_t global_variable_count = 0;
+
+	std::shared_ptr<Program> read_program() {
+		char magic[sizeof(MAGIC)];
+		reader.stream.read(magic, sizeof(MAGIC));
+		if (reader.stream.gcount() != sizeof(MAGIC) || !std::equal(magic, magic + sizeof(MAGIC), MAGIC)) {
+			reader.fail("not a serialized CoLa program");
+		}
+		auto version = reader.read_number();
+		if (version != SERIALIZATION_VERSION) {
+			reader.fail("unsupported version " + std::to_string(version) + ", expected " + std::to_string(SERIALIZATION_VERSION));
+		}
+		program->name = reader.read_string();
+
+		auto num_options = reader.read_number();
+		for (std::uint64_t index = 0; index < num_options; ++index) {
+			auto key = reader.read_string();
+			program->options[key] = reader.read_string();
+		}
+
+		auto num_types = reader.read_number();
+		for (std::uint64_t index = 0; index < num_types; ++index) {
+			auto name = reader.read_string();
+			auto sort = reader.read_byte();
+			if (sort > static_cast<std::uint8_t>(Sort::PTR)) {
+				reader.fail("unknown sort");
+			}
+			program->types.push_back(std::make_unique<Type>(name, static_cast<Sort>(sort)));
+			types.push_back(program->types.back().get());
+		}
+		for (auto& type : program->types) {
+			auto num_fields = reader.read_number();
+			for (std::uint64_t index = 0; index < num_fields; ++index) {
+				auto name = reader.read_string();
+				type->add_field(name, read_type());
+			}
+		}
+
+		auto num_variables = reader.read_number();
+		for (std::uint64_t index = 0; index < num_variables; ++index) {
+			program->variables.push_back(read_declaration());
+		}
+
+		auto num_functions = reader.read_number();
+		for (std::uint64_t index = 0; index < num_functions; ++index) {
+			program->functions.push_back(read_function_header());
+			functions.push_back(program->functions.back().get());
+		}
+		program->initializer = read_function_header();
+
+		// arguments and locals are visible only within their function
+		global_variable_count = program->variables.size();
+		variables.resize(global_variable_count);
+		for (auto& function : program->functions) {
+			register_arguments(*function);
+			read_function_body(*function);
+		}
+		register_arguments(*program->initializer);
+		read_function_body(*program->initializer);
+
+		return std::move(program);
+	}
+
+	void register_arguments(const Function& function) {
+		for (const auto& decl : function.args) {
+			variables.push_back(decl.get());
+		}
+	}
+};
+
+std::shared_ptr<Program> cola::deserialize_program(std::istream& stream) {
+	auto arena = NodeArena::make(false); // like parsed programs, see 'parse_program'
+	ArenaScope scope(arena);
+	Deserializer deserializer(stream);
+	auto result = deserializer.read_program();
+	result->arena = std::move(arena);
+	return result;
+}
+
+std::shared_ptr<Program> cola::deserialize_program(std::string filename) {
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		throw std::logic_error("Could not open serialized program '" + filename + "'.");
+	}
+	return deserialize_program(file);
+}
@@ -0,0 +1,15 @@
+#include "cola/symbol.hpp"
+
+#include <mutex>
+#include <unordered_map>
+
+using namespace cola;
+
+
+SymbolId cola::intern(const std::string& name) {
+	static std::mutex mutex;
+	static std::unordered_map<std::string, SymbolId>* table = new std::unordered_map<std::string, SymbolId>(); // never destroyed; used by static types
+	std::lock_guard<std::mutex> guard(mutex);
+	auto insertion = table->insert({ name, (SymbolId) table->size() });
+	return insertion.first->second;
+}
@@ -0,0 +1,115 @@
+#include "cola/trace.hpp"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace cola;
+
+
+struct TraceEvent {
+	std::string name;
+	const char* category;
+	std::chrono::microseconds begin;
+	std::chrono::microseconds duration;
+	std::size_t thread;
+};
+
+struct TraceLog {
+	std::atomic<bool> enabled{false};
+	std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+	std::mutex mutex;
+	std::vector<TraceEvent> events;
+	std::map<std::thread::id, std::size_t> threads; // small ids, in order of first event
+};
+
+static TraceLog& trace_log() {
+	// never destroyed: scopes may still close during static destruction
+	static TraceLog* log = new TraceLog();
+	return *log;
+}
+
+static void write_escaped(std::ostream& stream, const std::string& text) {
+	for (char chr : text) {
+		if (chr == '"' || chr == '\\') {
+			stream << '\\' << chr;
+		} else if (chr == '\n') {
+			stream << "\\n";
+		} else {
+			stream << chr;
+		}
+	}
+}
+
+
+void Trace::enable() {
+	trace_log().enabled = true;
+}
+
+bool Trace::enabled() {
+	return trace_log().enabled.load(std::memory_order_relaxed);
+}
+
+void Trace::write(std::ostream& stream) {
+	auto& log = trace_log();
+	std::lock_guard<std::mutex> guard(log.mutex);
+	auto pid = getpid();
+
+	stream << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl;
+	for (std::size_t index = 0; index < log.events.size(); ++index) {
+		const auto& event = log.events.at(index);
+		stream << "  { \"name\": \"";
+		write_escaped(stream, event.name);
+		stream << "\", \"cat\": \"" << event.category << "\", \"ph\": \"X\", ";
+		stream << "\"ts\": " << event.begin.count() << ", \"dur\": " << event.duration.count() << ", ";
+		stream << "\"pid\": " << pid << ", \"tid\": " << event.thread << " }";
+		stream << (index+1 < log.events.size() ? "," : "") << std::endl;
+	}
+	stream << "]}" << std::endl;
+}
+
+
+TraceScope::TraceScope(const char* category) : _active(Trace::enabled()), _category(category) {
+}
+
+TraceScope::TraceScope(const char* category, const char* name) : TraceScope(category) {
+	if (_active) {
+		start(name);
+	}
+}
+
+TraceScope::TraceScope(const char* category, std::string name) : TraceScope(category) {
+	if (_active) {
+		start(std::move(name));
+	}
+}
+
+void TraceScope::start(std::string name) {
+	_name = std::move(name);
+	_begin = std::chrono::steady_clock::now();
+}
+
+TraceScope::~TraceScope() {
+	if (!_active) {
+		return;
+	}
+	auto end = std::chrono::steady_clock::now();
+	auto& log = trace_log();
+	std::lock_guard<std::mutex> guard(log.mutex);
+	try {
+		auto thread = log.threads.emplace(std::this_thread::get_id(), log.threads.size()).first->second;
+		log.events.push_back({
+			std::move(_name),
+			_category,
+			std::chrono::duration_cast<std::chrono::microseconds>(_begin - log.origin),
+			std::chrono::duration_cast<std::chrono::microseconds>(end - _begin),
+			thread
+		});
+	} catch (const std::bad_alloc& /*err*/) {
+		// the event is lost; scopes may close while unwinding an exhausted memory budget
+	}
+}
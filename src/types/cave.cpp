@@ -1,11 +1,35 @@
 #include "types/cave.hpp"
 #include "cola/ast.hpp"
 #include "cola/util.hpp"
+#include "cola/trace.hpp"
 #include "types/error.hpp"
+#include "types/slice.hpp"
+#include "types/discharge.hpp"
+#include "types/deadline.hpp"
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <array>
+#include <algorithm>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+#include <condition_variable>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
 
 using namespace cola;
 using namespace prtypes;
@@ -154,6 +178,60 @@ bool contains_angels(const Function& function) {
 }
 
 
+struct AssertCollectorVisitor final : Visitor {
+	std::vector<const Assert*> result;
+	void visit(const VariableDeclaration& /*node*/) override { throw std::logic_error("Unexpected invocation: AssertCollectorVisitor::visit(const VariableDeclaration&)"); }
+	void visit(const Expression& /*node*/) override { throw std::logic_error("Unexpected invocation: AssertCollectorVisitor::visit(const Expression&)"); }
+	void visit(const BooleanValue& /*node*/) override { throw std::logic_error("Unexpected invocation: AssertCollectorVisitor::visit(const BooleanValue&)"); }
+	void visit(const NullValue& /*node*/) override { throw std::logic_error("Unexpected invocation: AssertCollectorVisitor::visit(const NullValue&)"); }
+	void visit(const EmptyValue& /*node*/) override { throw std::logic_error("Unexpected invocation: AssertCollectorVisitor::visit(const EmptyValue&)"); }
+	void visit(const MaxValue& /*node*/) override { throw std::logic_error("Unexpected invocation: AssertCollectorVisitor::visit(const MaxValue&)"); }
+	void visit(const MinValue& /*node*/) override { throw std::logic_error("Unexpected invocation: AssertCollectorVisitor::visit(const MinValue&)"); }
+	void visit(const NDetValue& /*node*/) override { throw std::logic_error("Unexpected invocation: AssertCollectorVisitor::visit(const NDetValue&)"); }
+	void visit(const VariableExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: AssertCollectorVisitor::visit(const VariableExpression&)"); }
+	void visit(const NegatedExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: AssertCollectorVisitor::visit(const NegatedExpression&)"); }
+	void visit(const BinaryExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: AssertCollectorVisitor::visit(const BinaryExpression&)"); }
+	void visit(const Dereference& /*node*/) override { throw std::logic_error("Unexpected invocation: AssertCollectorVisitor::visit(const Dereference&)"); }
+	void visit(const InvariantExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: AssertCollectorVisitor::visit(const InvariantExpression&)"); }
+	void visit(const InvariantActive& /*node*/) override { throw std::logic_error("Unexpected invocation: AssertCollectorVisitor::visit(const InvariantActive&)"); }
+	void visit(const Program& /*node*/) override { throw std::logic_error("Unexpected invocation: AssertCollectorVisitor::visit(const Program&)"); }
+
+	void visit(const Sequence& node) override { node.first->accept(*this); node.second->accept(*this); }
+	void visit(const Scope& node) override { node.body->accept(*this); }
+	void visit(const Atomic& node) override { node.body->accept(*this); }
+	void visit(const Choice& node) override {
+		for (const auto& branch : node.branches) {
+			branch->accept(*this);
+		}
+	}
+	void visit(const IfThenElse& node) override { node.ifBranch->accept(*this); node.elseBranch->accept(*this); }
+	void visit(const Loop& node) override { node.body->accept(*this); }
+	void visit(const While& node) override { node.body->accept(*this); }
+	void visit(const Skip& /*node*/) override { /* do nothing */ }
+	void visit(const Break& /*node*/) override { /* do nothing */ }
+	void visit(const Continue& /*node*/) override { /* do nothing */ }
+	void visit(const Assume& /*node*/) override { /* do nothing */ }
+	void visit(const Assert& node) override { this->result.push_back(&node); }
+	void visit(const AngelChoose& /*node*/) override { /* do nothing */ }
+	void visit(const AngelActive& /*node*/) override { /* do nothing */ }
+	void visit(const AngelContains& /*node*/) override { /* do nothing */ }
+	void visit(const Return& /*node*/) override { /* do nothing */ }
+	void visit(const Malloc& /*node*/) override { /* do nothing */ }
+	void visit(const Assignment& /*node*/) override { /* do nothing */ }
+	void visit(const Enter& /*node*/) override { /* do nothing */ }
+	void visit(const Exit& /*node*/) override { /* do nothing */ }
+	void visit(const Macro& /*node*/) override { /* do nothing */ }
+	void visit(const CompareAndSwap& /*node*/) override { /* do nothing */ }
+	void visit(const Function& node) override { if (node.body) { node.body->accept(*this); } }
+};
+
+std::vector<const Assert*> collect_assertions(const Function& function) {
+	AssertCollectorVisitor visitor;
+	function.accept(visitor);
+	return std::move(visitor.result);
+}
+
+
 struct CaveConfig {
 	bool INSTRUMENT_OBJECTS = true;
 	const bool INSTRUMENT_FLAG = false; // not supported (does not work)
@@ -204,6 +282,7 @@ struct CaveOutputVisitor : public Visitor {
 	const Function* retire;
 	const Type* retire_type;
 	const std::set<const Assert*>* whitelist;
+	const CaveSlice* slice = nullptr;
 	bool add_fix_me = false;
 	bool needs_parents = false;
 	const Program* program;
@@ -229,6 +308,11 @@ struct CaveOutputVisitor : public Visitor {
 	// ****************************** HELPERS ****************************** //
 	// ********************************************************************* //
 
+	template<typename T>
+	bool is_sliced(const T& node) {
+		return this->slice && this->slice->is_sliced(node);
+	}
+
 	void print_options(const Program& program) {
 		if (this->conf.INSTRUMENT_INSERT_OPTS) {
 			for (std::string key : opt_keys) {
@@ -261,7 +345,7 @@ struct CaveOutputVisitor : public Visitor {
 			stream << indent << type2cave(type) << " " << fiedl_name << ";" << std::endl;
 		}
 		if (this->instrument && this->conf.INSTRUMENT_OBJECTS) {
-			if (&type == retire_type) {
+			if (type == *retire_type) {
 				// instrument retire flag
 				stream << std::endl;
 				stream << indent << "// instrumented retire flag" << std::endl;
@@ -509,7 +593,9 @@ struct CaveOutputVisitor : public Visitor {
 		stream << "{" << std::endl;
 		indent++;
 		for (const auto& decl : scope.variables) {
-			print_var_def(*decl);
+			if (!is_sliced(*decl)) {
+				print_var_def(*decl);
+			}
 		}
 		if (this->top_level_scope) {
 			if (this->instrument_angels) {
@@ -726,7 +812,7 @@ struct CaveOutputVisitor : public Visitor {
 
 	void visit(const Malloc& malloc) {
 		stream << indent << var2cave(malloc.lhs) << " = new();" << std::endl;
-		if (this->instrument && &malloc.lhs.type == retire_type) {
+		if (this->instrument && malloc.lhs.type == *retire_type) {
 			if (this->conf.INSTRUMENT_OBJECTS) {
 				stream << indent << var2cave(malloc.lhs) << "->RETIRED_ = false;" << std::endl;
 			} else if (this->conf.INSTRUMENT_FLAG) {
@@ -737,6 +823,16 @@ struct CaveOutputVisitor : public Visitor {
 	}
 
 	void visit(const Assignment& assign) {
+		if (is_sliced(assign)) {
+			// a single comment line; printing the command would put its annotation (if any) on a line of its own
+			stream << indent << "// sliced: ";
+			cola::print(*assign.lhs, stream);
+			stream << " = ";
+			cola::print(*assign.rhs, stream);
+			stream << "; // " << assign.id << std::endl;
+			return;
+		}
+
 		auto handle_assign = [&] (const Assignment& to_handle) {
 			assert(to_handle.lhs);
 			to_handle.lhs->accept(*this);
@@ -774,7 +870,7 @@ struct CaveOutputVisitor : public Visitor {
 			assert(enter.args.size() == 1);
 			assert(enter.args.at(0)->type().sort == Sort::PTR);
 			assert(retire->args.size() == 1);
-			assert(&retire->args.at(0)->type == &enter.args.at(0)->type());
+			assert(retire->args.at(0)->type == enter.args.at(0)->type());
 			stream << indent << "if (";
 			enter.args.at(0)->accept(*this);
 			stream << " == NULL) { fail(); }" << std::endl;
@@ -884,7 +980,9 @@ struct CaveOutputVisitor : public Visitor {
 			indent++;
 		}
 		for (const auto& decl : program.variables) {
-			print_var_def(*decl);
+			if (!is_sliced(*decl)) {
+				print_var_def(*decl);
+			}
 		}
 		print_instrumentation_decls();
 		if (this->conf.INSTRUMENT_WRAP_SHARED) {
@@ -922,63 +1020,547 @@ struct CaveOutputVisitor : public Visitor {
 	}
 };
 
+static std::atomic<bool> slicing_enabled(true);
+
+void prtypes::set_cave_slicing(bool enabled) {
+	slicing_enabled = enabled;
+}
+
 void to_cave_input(const Program& program, const Function& retire_function, std::set<const Assert*>* whitelist, std::ostream& stream) {
 	CaveOutputVisitor visitor(stream, retire_function, whitelist);
+	CaveSlice slice;
+	if (slicing_enabled) {
+		slice = compute_cave_slice(program, whitelist);
+		visitor.slice = &slice;
+	}
 	program.accept(visitor);
 }
 
+static std::mutex limits_mutex;
+static CaveLimits annotation_limits, linearizability_limits;
+
+void prtypes::set_cave_limits(CavePhase phase, CaveLimits limits) {
+	std::lock_guard<std::mutex> lock(limits_mutex);
+	switch (phase) {
+		case CavePhase::ANNOTATIONS: annotation_limits = limits; break;
+		case CavePhase::LINEARIZABILITY: linearizability_limits = limits; break;
+	}
+}
+
+CaveLimits prtypes::get_cave_limits(CavePhase phase) {
+	std::lock_guard<std::mutex> lock(limits_mutex);
+	switch (phase) {
+		case CavePhase::ANNOTATIONS: return annotation_limits;
+		case CavePhase::LINEARIZABILITY: return linearizability_limits;
+	}
+	throw std::logic_error("Unexpected CAVE phase.");
+}
+
+enum struct CaveVerdict { VALID, NOT_VALID, UNKNOWN };
+
+struct CaveResultCache {
+	std::atomic<bool> enabled{false};
+	std::mutex mutex;
+	std::unordered_map<std::string, CaveVerdict> verdicts;
+};
+
+static CaveResultCache& get_result_cache() {
+	static CaveResultCache cache;
+	return cache;
+}
+
+void prtypes::set_cave_result_cache(bool enabled) {
+	auto& cache = get_result_cache();
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	cache.enabled = enabled;
+	if (!enabled) {
+		cache.verdicts.clear();
+	}
+}
+
+static std::string make_result_cache_key(CavePhase phase, const std::vector<std::string>& arguments) {
+	// queries live in fresh temporary directories, so input files are identified by their content;
+	// comments are dropped, they carry statement ids which differ between otherwise equal programs
+	std::stringstream result;
+	result << (phase == CavePhase::ANNOTATIONS ? 'a' : 'l');
+	for (const auto& arg : arguments) {
+		result << '\0';
+		std::error_code error;
+		if (std::filesystem::is_regular_file(arg, error)) {
+			std::ifstream file(arg);
+			std::string line;
+			while (std::getline(file, line)) {
+				result << line.substr(0, line.find("//")) << '\n';
+			}
+		} else {
+			result << arg;
+		}
+	}
+	return result.str();
+}
+
+inline CaveVerdict find_verdict(const std::string& output) {
+	if (output.find("\nNOT Valid\n") != std::string::npos) {
+		return CaveVerdict::NOT_VALID;
+	} else if (output.find("\nValid\n") != std::string::npos) {
+		return CaveVerdict::VALID;
+	} else {
+		return CaveVerdict::UNKNOWN;
+	}
+}
+
+inline bool looks_like_out_of_memory(const std::string& output) {
+	return output.find("Out_of_memory") != std::string::npos || output.find("out of memory") != std::string::npos;
+}
+
 /**
- * See: https://stackoverflow.com/questions/478898/how-do-i-execute-a-command-and-get-output-of-command-within-c-using-posix
+ * Runs 'executable' with 'arguments' in a fresh process group, capturing stdout and stderr.
+ * Output is consumed as it arrives; the process is killed as soon as a verdict has been printed
+ * or once it exceeds the wall-clock limit or the calling thread's deadline (see types/deadline.hpp).
+ * The memory limit is enforced via RLIMIT_AS in the child.
  */
-std::string exec(const char* cmd) {
-	std::array<char, 128> buffer;
-	std::string result;
-	std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(cmd, "r"), pclose);
-	if (!pipe) {
-		throw std::runtime_error("popen() failed!");
+std::pair<CaveVerdict, std::string> run_cave_process(const std::string& executable, const std::vector<std::string>& arguments, const CaveLimits& limits) {
+	// close-on-exec: other threads fork CAVE processes concurrently, which must not inherit the write end (no EOF otherwise)
+	int channel[2];
+#ifdef __linux__
+	int created = pipe2(channel, O_CLOEXEC);
+#else
+	int created = pipe(channel);
+	if (created == 0) {
+		fcntl(channel[0], F_SETFD, FD_CLOEXEC);
+		fcntl(channel[1], F_SETFD, FD_CLOEXEC);
+	}
+#endif
+	if (created != 0) {
+		throw CaveError("Could not create pipe for CAVE: " + std::string(strerror(errno)) + ".");
+	}
+
+	std::vector<char*> argv;
+	argv.push_back(const_cast<char*>(executable.c_str()));
+	for (const auto& arg : arguments) {
+		argv.push_back(const_cast<char*>(arg.c_str()));
+	}
+	argv.push_back(nullptr);
+
+	pid_t pid = fork();
+	if (pid < 0) {
+		close(channel[0]);
+		close(channel[1]);
+		throw CaveError("Could not fork CAVE process: " + std::string(strerror(errno)) + ".");
+	}
+
+	if (pid == 0) {
+		// child: only async-signal-safe calls from here on
+		setpgid(0, 0);
+#ifdef __linux__
+		prctl(PR_SET_PDEATHSIG, SIGKILL); // do not outlive a killed seal process, e.g., a batch worker
+#endif
+		dup2(channel[1], STDOUT_FILENO); // the duplicates do not inherit close-on-exec
+		dup2(channel[1], STDERR_FILENO);
+		close(channel[0]);
+		close(channel[1]);
+		if (limits.memory_mb > 0) {
+			rlim_t bytes = (rlim_t) limits.memory_mb * 1024 * 1024;
+			struct rlimit limit = { bytes, bytes };
+			setrlimit(RLIMIT_AS, &limit);
+		}
+		execv(executable.c_str(), argv.data());
+		_exit(127);
+	}
+
+	// parent
+	close(channel[1]);
+	auto kill_child = [pid]() {
+		kill(-pid, SIGKILL);
+		kill(pid, SIGKILL);
+	};
+	auto deadline = std::chrono::steady_clock::now() + limits.timeout;
+	auto phase_deadline = get_deadline();
+	bool timed_out = false;
+	bool phase_timed_out = false;
+	std::string output;
+	std::array<char, 4096> buffer;
+	CaveVerdict verdict = CaveVerdict::UNKNOWN;
+
+	while (true) {
+		int wait_ms = -1;
+		auto now = std::chrono::steady_clock::now();
+		if (limits.timeout.count() > 0) {
+			auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
+			if (remaining.count() <= 0) {
+				timed_out = true;
+				break;
+			}
+			wait_ms = (int) std::min<long long>(remaining.count(), 1000 * 60);
+		}
+		if (phase_deadline.has_value()) {
+			auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(*phase_deadline - now);
+			if (remaining.count() <= 0) {
+				phase_timed_out = true;
+				break;
+			}
+			int phase_wait_ms = (int) std::min<long long>(remaining.count(), 1000 * 60);
+			wait_ms = wait_ms < 0 ? phase_wait_ms : std::min(wait_ms, phase_wait_ms);
+		}
+
+		struct pollfd request = { channel[0], POLLIN, 0 };
+		int ready = poll(&request, 1, wait_ms);
+		if (ready < 0) {
+			if (errno == EINTR) continue;
+			break;
+		} else if (ready == 0) {
+			continue; // re-check deadline
+		}
+
+		ssize_t count = read(channel[0], buffer.data(), buffer.size());
+		if (count < 0) {
+			if (errno == EINTR) continue;
+			break;
+		} else if (count == 0) {
+			break; // EOF
+		}
+
+		// a failure anywhere is final, so CAVE may stop early; a 'Valid' may still be followed by one and is decided at EOF
+		std::size_t search_from = output.size() < 16 ? 0 : output.size() - 16; // only the tail can complete a new verdict
+		output.append(buffer.data(), count);
+		if (find_verdict(output.substr(search_from)) == CaveVerdict::NOT_VALID) {
+			verdict = CaveVerdict::NOT_VALID;
+			break;
+		}
 	}
-	while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-		result += buffer.data();
+	close(channel[0]);
+
+	if (verdict != CaveVerdict::UNKNOWN || timed_out || phase_timed_out) {
+		kill_child();
 	}
-	return result;
+	int status = 0;
+	while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+
+	if (phase_timed_out) {
+		throw TimeoutError("CAVE did not finish before the deadline");
+	}
+	if (timed_out) {
+		throw CaveResourceError(CaveResourceError::TIMEOUT, "wall-clock limit of " + std::to_string(limits.timeout.count()) + "s");
+	}
+	if (verdict == CaveVerdict::UNKNOWN) {
+		verdict = find_verdict(output);
+	}
+	if (verdict == CaveVerdict::UNKNOWN) {
+		// without a verdict, the process was not killed by us; SIGKILL then stems from the kernel's out-of-memory killer
+		bool killed = WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL;
+		if (looks_like_out_of_memory(output) || killed) {
+			throw CaveResourceError(CaveResourceError::MEMORY, limits.memory_mb > 0 ? "memory limit of " + std::to_string(limits.memory_mb) + "MB" : "available memory");
+		}
+		if (WIFSIGNALED(status)) {
+			throw CaveError("CAVE was terminated by signal " + std::to_string(WTERMSIG(status)) + ".");
+		}
+		if (WIFEXITED(status) && WEXITSTATUS(status) == 127) {
+			throw CaveError("Could not execute CAVE binary '" + executable + "'.");
+		}
+	}
+	return { verdict, std::move(output) };
+}
+
+
+struct CaveJobSlots {
+	std::mutex mutex;
+	std::condition_variable released;
+	std::size_t limit = 1;
+	std::size_t running = 0;
+};
+
+static CaveJobSlots& get_job_slots() {
+	static CaveJobSlots slots;
+	return slots;
+}
+
+void prtypes::set_cave_job_limit(std::size_t limit) {
+	auto& slots = get_job_slots();
+	std::lock_guard<std::mutex> lock(slots.mutex);
+	slots.limit = std::max(limit, (std::size_t) 1);
+	slots.released.notify_all();
+}
+
+std::size_t prtypes::get_cave_job_limit() {
+	auto& slots = get_job_slots();
+	std::lock_guard<std::mutex> lock(slots.mutex);
+	return slots.limit;
 }
 
+/**
+ * A single CAVE invocation. Occupies one of the job slots for its lifetime
+ * and works inside its own temporary directory, so that concurrent jobs
+ * (and concurrent seal processes) do not clobber each other's input files.
+ * The directory is removed on destruction unless the job failed.
+ */
+struct CaveJob {
+	std::filesystem::path directory;
+	bool keep_directory = false;
+
+	CaveJob() {
+		auto& slots = get_job_slots();
+		std::unique_lock<std::mutex> lock(slots.mutex);
+		auto is_free = [&slots]{ return slots.running < slots.limit; };
+		if (auto deadline = get_deadline()) {
+			if (!slots.released.wait_until(lock, *deadline, is_free)) {
+				throw TimeoutError("no CAVE job slot became available before the deadline");
+			}
+		} else {
+			slots.released.wait(lock, is_free);
+		}
+		slots.running++;
+		lock.unlock();
+
+		std::string pattern = (std::filesystem::temp_directory_path() / "seal-cave-XXXXXX").string();
+		if (mkdtemp(pattern.data()) == nullptr) {
+			release();
+			throw CaveError("Could not create temporary directory for CAVE job.");
+		}
+		directory = pattern;
+	}
+
+	~CaveJob() {
+		if (!keep_directory) {
+			std::error_code error;
+			std::filesystem::remove_all(directory, error);
+		}
+		release();
+	}
+
+	void release() {
+		auto& slots = get_job_slots();
+		std::lock_guard<std::mutex> lock(slots.mutex);
+		slots.running--;
+		slots.released.notify_one();
+	}
+
+	std::string file(std::string name) const {
+		return (directory / name).string();
+	}
+
+	bool run(std::vector<std::string> arguments, CavePhase phase) {
+		TraceScope trace("cave", phase == CavePhase::ANNOTATIONS ? "CAVE annotations" : "CAVE linearizability");
+		auto& cache = get_result_cache();
+		std::string key = cache.enabled ? make_result_cache_key(phase, arguments) : "";
+		if (!key.empty()) {
+			std::lock_guard<std::mutex> lock(cache.mutex);
+			auto search = cache.verdicts.find(key);
+			if (search != cache.verdicts.end()) {
+				return search->second == CaveVerdict::VALID;
+			}
+		}
+
+		// TODO: call CAVE executable relativ to working dir
+		CaveVerdict verdict;
+		std::string output;
+		try {
+			std::tie(verdict, output) = run_cave_process("./cave", arguments, get_cave_limits(phase));
+		} catch (const CaveResourceError& /*err*/) {
+			throw;
+		} catch (const CaveError& err) {
+			keep_directory = true;
+			throw CaveError(err.cause + " Input retained in '" + directory.string() + "'.");
+		}
+		if (!key.empty() && verdict != CaveVerdict::UNKNOWN) {
+			std::lock_guard<std::mutex> lock(cache.mutex);
+			cache.verdicts[key] = verdict;
+		}
+		switch (verdict) {
+			case CaveVerdict::VALID: return true;
+			case CaveVerdict::NOT_VALID: return false;
+			case CaveVerdict::UNKNOWN: break;
+		}
+		keep_directory = true;
+		throw CaveError("CAVE failed me (unrcognized output)! Cannot recover. Input retained in '" + directory.string() + "'.");
+	}
+};
+
 
 bool discharge_assertions_impl(const Program& program, const Function& retire_function, std::set<const Assert*>* whitelist) {
-	std::string filename = "tmp_memchk.cav";
+	CaveJob job;
+	std::string filename = job.file("tmp_memchk.cav");
 	std::ofstream outfile(filename);
 	to_cave_input(program, retire_function, whitelist, outfile);
 	outfile.close();
 
-	// std::string command = "./cave -allow_leaks -lm -por " + filename;
-	// TODO: call CAVE executable relativ to working dir
-	std::string command = "./cave -allow_leaks " + filename;
-	std::string result = exec(command.data());
-	if (result.find("\nNOT Valid\n") != std::string::npos) {
-		return false;
-	} else if (result.find("\nValid\n") != std::string::npos) {
-		return true;
-	} else {
-		throw CaveError("CAVE failed me (unrcognized output)! Cannot recover.");
+	// return job.run({ "-allow_leaks", "-lm", "-por", filename }, CavePhase::ANNOTATIONS);
+	return job.run({ "-allow_leaks", filename }, CavePhase::ANNOTATIONS);
+}
+
+static std::atomic<bool> local_discharge_enabled(true);
+
+void prtypes::set_cave_local_discharge(bool enabled) {
+	local_discharge_enabled = enabled;
+}
+
+inline std::set<const Assert*> get_locally_valid_assertions(const Program& program, bool relative=true) {
+	if (!local_discharge_enabled) {
+		return {};
 	}
+	return find_locally_valid_assertions(program, relative);
+}
+
+inline std::set<const Assert*> get_all_assertions(const Program& program) {
+	std::set<const Assert*> result;
+	auto add = [&result](const Function& function) {
+		auto assertions = collect_assertions(function);
+		result.insert(assertions.begin(), assertions.end());
+	};
+	add(*program.initializer);
+	for (const auto& function : program.functions) {
+		if (function->kind != Function::SMR) {
+			add(*function);
+		}
+	}
+	return result;
 }
 
 bool prtypes::discharge_assertions(const Program& program, const Function& retire_function) {
-	return discharge_assertions_impl(program, retire_function, nullptr);
+	auto locally_valid = get_locally_valid_assertions(program);
+	if (locally_valid.empty()) {
+		return discharge_assertions_impl(program, retire_function, nullptr);
+	}
+	auto whitelist = get_all_assertions(program);
+	for (const auto* assertion : locally_valid) {
+		whitelist.erase(assertion);
+	}
+	return discharge_assertions_impl(program, retire_function, &whitelist);
 }
 
 
 bool prtypes::discharge_assertions(const Program& program, const Function& retire_function, const std::vector<std::reference_wrapper<const Assert>>& whitelist) {
+	// assertions outside the whitelist are not checked, so none can vouch for an alias
+	auto locally_valid = get_locally_valid_assertions(program, false);
 	std::set<const Assert*> set;
 	for (const Assert& assert : whitelist) {
-		set.insert(&assert);
+		if (locally_valid.count(&assert) == 0) {
+			set.insert(&assert);
+		}
+	}
+	if (set.empty() && !whitelist.empty()) {
+		// everything asked for holds trivially
+		return true;
 	}
 	return discharge_assertions_impl(program, retire_function, &set);
 }
 
 
+std::vector<std::set<const Assert*>> make_assertion_groups(const Program& program, CaveSplit split, std::size_t group_size) {
+	auto locally_valid = get_locally_valid_assertions(program);
+	auto collect = [&locally_valid](const Function& function) {
+		auto assertions = collect_assertions(function);
+		assertions.erase(std::remove_if(assertions.begin(), assertions.end(), [&locally_valid](const Assert* assertion) {
+			return locally_valid.count(assertion) > 0;
+		}), assertions.end());
+		return assertions;
+	};
+
+	std::vector<std::vector<const Assert*>> per_function;
+	per_function.push_back(collect(*program.initializer));
+	for (const auto& function : program.functions) {
+		if (function->kind == Function::INTERFACE) {
+			per_function.push_back(collect(*function));
+		}
+	}
+
+	std::vector<std::set<const Assert*>> result;
+	switch (split) {
+		case CaveSplit::NONE:
+			result.emplace_back();
+			for (const auto& assertions : per_function) {
+				result.back().insert(assertions.begin(), assertions.end());
+			}
+			break;
+
+		case CaveSplit::FUNCTION:
+			for (const auto& assertions : per_function) {
+				if (!assertions.empty()) {
+					result.emplace_back(assertions.begin(), assertions.end());
+				}
+			}
+			break;
+
+		case CaveSplit::ASSERTION:
+			group_size = std::max(group_size, (std::size_t) 1);
+			for (const auto& assertions : per_function) {
+				for (std::size_t index = 0; index < assertions.size(); ++index) {
+					if (index % group_size == 0) {
+						result.emplace_back();
+					}
+					result.back().insert(assertions.at(index));
+				}
+			}
+			break;
+	}
+
+	// the instrumentation checks more than the assertions (e.g. retiring NULL); make sure that is checked at least once
+	if (result.empty()) {
+		result.emplace_back();
+	}
+	return result;
+}
+
+bool prtypes::discharge_assertions(const Program& program, const Function& retire_function, CaveSplit split, std::size_t group_size) {
+	if (split == CaveSplit::NONE) {
+		return discharge_assertions(program, retire_function);
+	}
+
+	// every query contains the full program (interference!), but checks only the assertions in its group
+	auto groups = make_assertion_groups(program, split, group_size);
+
+	// a fixed pool of workers takes the groups in order; more workers than job slots would only wait for a slot
+	std::atomic<std::size_t> next_group(0);
+	std::atomic<bool> result(true);
+	std::atomic<bool> failed(false); // stops the other workers once the verdict is clear or a query threw
+	auto work = [&program,&retire_function,&groups,&next_group,&result,&failed]() {
+		while (!failed) {
+			std::size_t index = next_group++;
+			if (index >= groups.size()) {
+				break;
+			}
+			try {
+				if (!discharge_assertions_impl(program, retire_function, &groups.at(index))) {
+					result = false;
+					failed = true;
+				}
+			} catch (...) {
+				failed = true;
+				throw;
+			}
+		}
+	};
+
+	std::size_t number_of_workers = std::min(get_cave_job_limit(), groups.size());
+	std::vector<std::future<void>> workers;
+	for (std::size_t worker = 1; worker < number_of_workers; ++worker) {
+		workers.push_back(std::async(std::launch::async, [&work,deadline=get_deadline()]() {
+			DeadlineScope scope(deadline);
+			work();
+		}));
+	}
+	std::exception_ptr error;
+	try {
+		work(); // the calling thread is a worker, too
+	} catch (...) {
+		error = std::current_exception();
+	}
+	for (auto& worker : workers) {
+		try {
+			worker.get();
+		} catch (...) {
+			if (!error) error = std::current_exception();
+		}
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+	return result;
+}
+
+
 bool prtypes::check_linearizability(const cola::Program& program) {
-	std::string filename = "tmp_linear.cav";
+	CaveJob job;
+	std::string filename = job.file("tmp_linear.cav");
 	std::ofstream outfile(filename);
 	CaveOutputVisitor visitor(outfile);
 	visitor.opt_keys.insert("cavelin");
@@ -996,14 +1578,5 @@ bool prtypes::check_linearizability(const cola::Program& program) {
 		spec_file = find->second + spec_file;
 	}
 
-	// TODO: call CAVE executable relativ to working dir
-	std::string command = "./cave -linear " + spec_file + " " + filename;
-	std::string result = exec(command.data());
-	if (result.find("\nNOT Valid\n") != std::string::npos) {
-		return false;
-	} else if (result.find("\nValid\n") != std::string::npos) {
-		return true;
-	} else {
-		throw CaveError("CAVE failed me (unrcognized output)! Cannot recover.");
-	}
+	return job.run({ "-linear", spec_file, filename }, CavePhase::LINEARIZABILITY);
 }
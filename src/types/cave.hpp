@@ -5,17 +5,65 @@
 #include "cola/ast.hpp"
 #include "types/check.hpp"
 #include <ostream>
+#include <chrono>
 #include <string>
 #include <vector>
 
 
 namespace prtypes {
 
+	/** Sets the maximal number of CAVE instances that may run at the same time (at least 1).
+	  * Each instance works in its own temporary directory; callers may thus invoke the checks below from multiple threads.
+	  */
+	void set_cave_job_limit(std::size_t limit);
+
+	std::size_t get_cave_job_limit();
+
+	/** Enables/disables slicing away assignments and variables irrelevant for the memory safety check (enabled by default).
+	  * See 'compute_cave_slice' in types/slice.hpp.
+	  */
+	void set_cave_slicing(bool enabled);
+
+	/** Enables/disables discharging trivially valid active assertions without CAVE (enabled by default).
+	  * Such assertions are excluded from the CAVE queries; see 'find_locally_valid_assertions' in types/discharge.hpp.
+	  */
+	void set_cave_local_discharge(bool enabled);
+
+	/** Resource limits for a single CAVE process; zero means unlimited.
+	  * Exceeding a limit kills the process and raises a 'CaveResourceError'.
+	  */
+	struct CaveLimits {
+		std::chrono::seconds timeout = std::chrono::seconds(0);
+		std::size_t memory_mb = 0;
+	};
+
+	enum struct CavePhase { ANNOTATIONS, LINEARIZABILITY };
+
+	/** Enables/disables remembering CAVE verdicts in memory (disabled by default). A query whose input files and
+	  * arguments match an earlier one is answered without running CAVE. Meant for long-running processes.
+	  */
+	void set_cave_result_cache(bool enabled);
+
+	void set_cave_limits(CavePhase phase, CaveLimits limits);
+
+	CaveLimits get_cave_limits(CavePhase phase);
+
 	bool check_linearizability(const cola::Program& program);
 
 	bool discharge_assertions(const cola::Program& program, const cola::Function& retire_function);
 
 	bool discharge_assertions(const cola::Program& program, const cola::Function& retire_function, const std::vector<std::reference_wrapper<const cola::Assert>>& whitelist);
+
+	/** How to split the memory safety check into multiple (smaller) CAVE queries.
+	  * Each query contains the entire program but checks only a subset of its assertions; queries run in parallel on
+	  * up to 'get_cave_job_limit()' threads. No further queries are started once one of them fails.
+	  *   - NONE: a single query checking all assertions
+	  *   - FUNCTION: one query per interface function (and the initializer) containing assertions
+	  *   - ASSERTION: one query per group of (at most 'group_size') assertions from the same function
+	  */
+	enum struct CaveSplit { NONE, FUNCTION, ASSERTION };
+
+	bool discharge_assertions(const cola::Program& program, const cola::Function& retire_function, CaveSplit split, std::size_t group_size=1);
 	
 	inline bool discharge_assertions(const cola::Program& program, const SmrObserverStore& observer_store) {
 		return discharge_assertions(program, observer_store.retire_function);
@@ -25,6 +73,10 @@ namespace prtypes {
 		return discharge_assertions(program, observer_store.retire_function, std::move(whitelist));
 	}
 
+	inline bool discharge_assertions(const cola::Program& program, const SmrObserverStore& observer_store, CaveSplit split, std::size_t group_size=1) {
+		return discharge_assertions(program, observer_store.retire_function, split, group_size);
+	}
+
 } // namespace prtypes
 
 #endif
\ No newline at end of file
@@ -95,6 +95,10 @@ bool prtypes::SmrObserverStore::supports_elison(const Observer& observer) const
 
 bool prtypes::type_check(const cola::Program& program, const SmrObserverStore& observer_store) {
 	TypeContext context(observer_store);
+	return prtypes::type_check(program, context);
+}
+
+bool prtypes::type_check(const cola::Program& program, const TypeContext& context) {
 	TypeChecker checker(program, context);
 	return checker.is_well_typed();
 }
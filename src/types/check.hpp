@@ -25,8 +25,15 @@ namespace prtypes {
 	};
 
 
+	struct TypeContext;
+
 	bool type_check(const cola::Program& program, const SmrObserverStore& observer_store);
 
+	/** Like the above, but reuses the given context instead of building the cross-product of the store's observers anew.
+	  * The program's SMR calls must refer to the functions the store's observers were built for.
+	  */
+	bool type_check(const cola::Program& program, const TypeContext& context);
+
 } // namespace prtypes
 
 #endif
\ No newline at end of file
@@ -2,7 +2,9 @@
 #ifndef PRTYPES_CHECKER
 #define PRTYPES_CHECKER
 
+#include <map>
 #include <optional>
+#include <tuple>
 #include "cola/ast.hpp"
 #include "types/types.hpp"
 #include "types/simulation.hpp"
@@ -107,6 +109,7 @@ namespace prtypes {
 			void check_ite(const cola::IfThenElse& ite);
 			void check_loop(const cola::Loop& loop);
 			void check_while(const cola::While& whl);
+			void check_macro(const cola::Macro& call, std::vector<std::pair<std::reference_wrapper<const cola::VariableDeclaration>, std::reference_wrapper<const cola::VariableDeclaration>>> bindings);
 			void check_interface_function(const cola::Function& function);
 			void check_program(const cola::Program& program);
 
@@ -117,6 +120,18 @@ namespace prtypes {
 			std::vector<TypeEnv> break_envs;
 			std::unique_ptr<cola::VariableDeclaration> current_angel;
 
+			/** Type transformer of a macro body: the type environment (parameters in place of the arguments) and the
+			  * environments reaching a 'break' after checking the body. Summaries are keyed on the macro, the atomicity
+			  * of the call site, and the ids of the input types; repeated calls with equal input types are lookups.
+			  */
+			struct MacroSummary {
+				TypeEnv post_types;
+				std::vector<TypeEnv> break_types;
+			};
+			using MacroSummaryKey = std::tuple<const cola::Function*, bool, std::vector<std::pair<const cola::VariableDeclaration*, std::size_t>>>;
+			std::map<MacroSummaryKey, MacroSummary> macro_summaries;
+			std::map<std::tuple<SymbolicStateSet, bool, bool, bool, bool>, std::size_t> type_ids;
+
 			struct VariableOrDereferenceOrNull {
 				std::optional<const cola::VariableDeclaration*> var;
 				std::optional<const cola::Dereference*> deref;
@@ -131,6 +146,7 @@ namespace prtypes {
 			};
 
 			bool is_pointer_valid(const cola::VariableDeclaration& variable);
+			std::size_t type_id(const Type& type);
 			const cola::VariableDeclaration& expression_to_variable(const cola::Expression& expression);
 			VariableOrDereferenceOrNull expression_to_variable_or_dereference_or_null_or_value(const cola::Expression& expression);
 			FlatBinaryExpression expression_to_flat_binary_expression(const cola::Expression& expression);
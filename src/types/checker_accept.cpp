@@ -2,6 +2,7 @@
 #include "types/error.hpp"
 #include "cola/util.hpp"
 #include <iostream>
+#include <set>
 
 using namespace cola;
 using namespace prtypes;
@@ -546,10 +547,24 @@ void TypeChecker::visit(const Exit& exit) {
 	this->visit_command_end();
 }
 
-void TypeChecker::visit(const Macro& /*node*/) {
-	this->visit_command_begin();
-	raise_error<UnsupportedConstructError>("calls to 'MACRO' functions are not supported");
-	this->visit_command_end();
+void TypeChecker::visit(const Macro& call) {
+	// the body takes care of atomicity itself, as if it was inlined
+	assert(call.args.size() == call.decl.args.size());
+	std::vector<std::pair<std::reference_wrapper<const VariableDeclaration>, std::reference_wrapper<const VariableDeclaration>>> bindings;
+	std::set<const VariableDeclaration*> arguments;
+	for (std::size_t index = 0; index < call.args.size(); ++index) {
+		const VariableDeclaration& param = *call.decl.args.at(index);
+		if (param.type.sort != Sort::PTR) {
+			continue;
+		}
+		assert(call.args.at(index));
+		const VariableDeclaration& arg = expression_to_variable(*call.args.at(index));
+		conditionally_raise_error<UnsupportedConstructError>(arg.is_shared, "shared variables must not be passed to 'inline' functions");
+		conditionally_raise_error<UnsupportedConstructError>(!arguments.insert(&arg).second, "pointer arguments of 'inline' functions must be distinct");
+		bindings.push_back({ param, arg });
+	}
+
+	this->check_macro(call, std::move(bindings));
 }
 
 void TypeChecker::visit(const CompareAndSwap& /*node*/) {
@@ -565,8 +580,7 @@ void TypeChecker::visit(const Function& function) {
 			return;
 
 		case Function::Kind::MACRO:
-			raise_error<UnsupportedConstructError>("unsupported function kind 'MACRO'"); // TODO: support this or assume inlineing?
-			return;
+			return; // checked at its call sites
 
 		case Function::Kind::SMR:
 			return; // has no implementation (no type check)
@@ -1,7 +1,9 @@
 #include "types/checker.hpp"
 #include "types/error.hpp"
 #include "types/util.hpp"
+#include "types/deadline.hpp"
 #include "cola/util.hpp"
+#include "cola/trace.hpp"
 #include <iostream>
 
 using namespace cola;
@@ -440,7 +442,11 @@ void TypeChecker::check_loop(const Loop& loop) {
 	TypeEnv pre_types;
 
 	conditionally_raise_error<TypeCheckError>(!this->break_envs.empty(), "'break' must not jump over loops");
+	std::size_t iteration = 0;
 	do {
+		++iteration;
+		TraceScope trace("types", [&]{ return "loop iteration " + std::to_string(iteration); });
+		check_deadline();
 //		std::cout << "========DOING WHILE" << std::endl;
 //		debug_type_env(this->current_type_environment);
 		assert(this->break_envs.empty());
@@ -473,7 +479,11 @@ void TypeChecker::check_while(const While& whl) {
 
 	// apply loop rule, but peel breaking iterations
 	TypeEnv pre_types;
+	std::size_t iteration = 0;
 	do {
+		++iteration;
+		TraceScope trace("types", [&]{ return "while iteration " + std::to_string(iteration); });
+		check_deadline();
 		// std::cout << "========DOING WHILE " << whl.id << std::endl;
 		// debug_type_env(this->current_type_environment);
 		pre_types = this->current_type_environment;
@@ -528,7 +538,62 @@ void TypeChecker::check_while(const While& whl) {
 	// }
 }
 
+std::size_t TypeChecker::type_id(const Type& type) {
+	auto key = std::make_tuple(type.states, type.is_active, type.is_local, type.is_valid, type.is_transient);
+	auto insertion = type_ids.insert({ std::move(key), type_ids.size() });
+	return insertion.first->second;
+}
+
+TypeEnv rebind_type_environment(TypeEnv env, const std::vector<std::pair<std::reference_wrapper<const VariableDeclaration>, std::reference_wrapper<const VariableDeclaration>>>& renaming) {
+	for (const auto& [from, to] : renaming) {
+		assert(prtypes::has_binding(env, from));
+		auto node = env.extract(from);
+		node.key() = to;
+		auto insertion = env.insert(std::move(node));
+		conditionally_raise_error<UnsupportedConstructError>(!insertion.inserted, "recursive calls to 'inline' functions are not supported");
+	}
+	return env;
+}
+
+void TypeChecker::check_macro(const Macro& call, std::vector<std::pair<std::reference_wrapper<const VariableDeclaration>, std::reference_wrapper<const VariableDeclaration>>> bindings) {
+	const Function& macro = call.decl;
+	assert(macro.body);
+
+	// move the argument types to the parameters; the body leaves other variables alone, except for type_post/closure
+	std::vector<std::pair<std::reference_wrapper<const VariableDeclaration>, std::reference_wrapper<const VariableDeclaration>>> to_params, to_args;
+	for (const auto& [param, arg] : bindings) {
+		to_params.push_back({ arg, param });
+		to_args.push_back({ param, arg });
+	}
+	TypeEnv pre_types = rebind_type_environment(this->current_type_environment, to_params);
+
+	MacroSummaryKey key = { &macro, this->inside_atomic, {} };
+	for (const auto& [decl, type] : pre_types) {
+		std::get<2>(key).push_back({ &decl.get(), type_id(type) });
+	}
+
+	// compute summary on first call with these input types
+	auto summary = macro_summaries.find(key);
+	if (summary == macro_summaries.end()) {
+		std::vector<TypeEnv> outer_breaks = std::move(this->break_envs);
+		this->break_envs.clear();
+		this->current_type_environment = std::move(pre_types);
+		macro.body->accept(*this);
+		MacroSummary result = { std::move(this->current_type_environment), std::move(this->break_envs) };
+		this->break_envs = std::move(outer_breaks);
+		summary = macro_summaries.emplace(std::move(key), std::move(result)).first;
+	}
+
+	// apply summary
+	this->current_type_environment = rebind_type_environment(summary->second.post_types, to_args);
+	for (const auto& env : summary->second.break_types) {
+		this->break_envs.push_back(rebind_type_environment(env, to_args));
+	}
+}
+
 void TypeChecker::check_interface_function(const Function& function) {
+	TraceScope trace("types", [&]{ return "check " + function.name; });
+	check_deadline();
 	std::cout << "[" << function.name << "]" << std::endl;
 	function.body->accept(*this);
 
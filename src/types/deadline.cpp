@@ -0,0 +1,139 @@
+#include "types/deadline.hpp"
+#include "types/error.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+
+using namespace prtypes;
+
+
+static thread_local deadline_t current_deadline = std::nullopt;
+
+static deadline_t min_deadline(deadline_t deadline, deadline_t other) {
+	if (!deadline.has_value()) return other;
+	if (!other.has_value()) return deadline;
+	return std::min(*deadline, *other);
+}
+
+DeadlineScope::DeadlineScope(deadline_t deadline) : _previous(current_deadline) {
+	current_deadline = min_deadline(current_deadline, deadline);
+}
+
+DeadlineScope::DeadlineScope(std::chrono::milliseconds budget) : DeadlineScope(budget.count() > 0 ? deadline_t(std::chrono::steady_clock::now() + budget) : std::nullopt) {
+}
+
+DeadlineScope::~DeadlineScope() {
+	current_deadline = _previous;
+}
+
+deadline_t prtypes::get_deadline() {
+	return current_deadline;
+}
+
+void prtypes::check_deadline() {
+	if (current_deadline.has_value() && std::chrono::steady_clock::now() >= *current_deadline) {
+		throw TimeoutError("phase did not finish in time");
+	}
+}
+
+
+/**
+ * Interrupts z3 checks that run past their deadline. Setting a 'timeout' parameter instead would reconfigure
+ * the solver before every check, which costs z3 its incrementality. Started with the first bounded check.
+ */
+struct Watchdog {
+	struct Watch {
+		z3::context& context;
+		std::chrono::steady_clock::time_point deadline;
+		bool interrupted = false;
+	};
+
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::list<Watch> watches;
+	bool running = false;
+	std::optional<std::chrono::steady_clock::time_point> wakeup; // of the sleeping watchdog, if any
+
+	std::list<Watch>::iterator watch(z3::context& context, std::chrono::steady_clock::time_point deadline) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!running) {
+			std::thread(&Watchdog::run, this).detach();
+			running = true;
+		}
+		auto result = watches.insert(watches.end(), { context, deadline });
+		if (!wakeup.has_value() || deadline < *wakeup) {
+			changed.notify_one(); // consecutive checks usually share their deadline; no need to wake up for those
+		}
+		return result;
+	}
+
+	void unwatch(std::list<Watch>::iterator watch) {
+		// once removed, the context is no longer interrupted; z3 ignores interrupts while not checking
+		std::lock_guard<std::mutex> lock(mutex);
+		watches.erase(watch);
+	}
+
+	void run() {
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true) {
+			auto now = std::chrono::steady_clock::now();
+			std::optional<std::chrono::steady_clock::time_point> next;
+			for (auto& watch : watches) {
+				if (watch.interrupted) {
+					continue;
+				} else if (watch.deadline <= now) {
+					watch.context.interrupt();
+					watch.interrupted = true;
+				} else {
+					next = next.has_value() ? std::min(*next, watch.deadline) : watch.deadline;
+				}
+			}
+			wakeup = next;
+			if (next.has_value()) {
+				changed.wait_until(lock, *next);
+			} else {
+				changed.wait(lock);
+			}
+		}
+	}
+};
+
+static Watchdog& get_watchdog() {
+	// never destroyed: the thread is detached
+	static Watchdog* watchdog = new Watchdog();
+	return *watchdog;
+}
+
+template<typename Check>
+static z3::check_result run_within_deadline(z3::context& context, Check check) {
+	if (!current_deadline.has_value()) {
+		return check();
+	}
+
+	check_deadline();
+	auto& watchdog = get_watchdog();
+	auto watch = watchdog.watch(context, *current_deadline);
+	z3::check_result result;
+	try {
+		result = check();
+	} catch (...) {
+		watchdog.unwatch(watch);
+		throw;
+	}
+	watchdog.unwatch(watch);
+
+	if (result == z3::unknown) {
+		check_deadline(); // otherwise, 'unknown' is up to the caller as before
+	}
+	return result;
+}
+
+z3::check_result prtypes::check_within_deadline(z3::solver& solver) {
+	return run_within_deadline(solver.ctx(), [&solver]() { return solver.check(); });
+}
+
+z3::check_result prtypes::check_within_deadline(z3::solver& solver, const z3::expr_vector& assumptions) {
+	return run_within_deadline(solver.ctx(), [&solver, &assumptions]() { return solver.check(assumptions); });
+}
@@ -0,0 +1,47 @@
+#pragma once
+#ifndef PRTYPES_DEADLINE
+#define PRTYPES_DEADLINE
+
+#include <chrono>
+#include <optional>
+#include "z3++.h"
+
+
+namespace prtypes {
+
+	using deadline_t = std::optional<std::chrono::steady_clock::time_point>;
+
+	/** Limits the calling thread to a time budget for its lifetime; the previous deadline is restored on destruction.
+	  * Nested scopes can only shorten the deadline. A zero budget (or 'std::nullopt') imposes no limit.
+	  * Work is cancelled cooperatively: 'check_deadline' throws a 'TimeoutError' once the deadline has passed.
+	  */
+	class DeadlineScope {
+		private:
+			deadline_t _previous;
+
+		public:
+			DeadlineScope(std::chrono::milliseconds budget);
+			DeadlineScope(deadline_t deadline); // e.g., to hand the deadline of a thread on to its helper threads
+			DeadlineScope(const DeadlineScope& other) = delete;
+			DeadlineScope& operator=(const DeadlineScope& other) = delete;
+			~DeadlineScope();
+	};
+
+	deadline_t get_deadline();
+
+	/** Cancellation checkpoint; throws a 'TimeoutError' if the calling thread's deadline has passed.
+	  */
+	void check_deadline();
+
+	/** Runs 'solver.check()', interrupting z3 once the calling thread's deadline passes.
+	  * Throws a 'TimeoutError' if the deadline passes before z3 finds an answer.
+	  */
+	z3::check_result check_within_deadline(z3::solver& solver);
+
+	/** Like 'check_within_deadline(solver)', but runs 'solver.check(assumptions)'.
+	  */
+	z3::check_result check_within_deadline(z3::solver& solver, const z3::expr_vector& assumptions);
+
+} // namespace prtypes
+
+#endif
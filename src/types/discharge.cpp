@@ -0,0 +1,331 @@
+#include "types/discharge.hpp"
+#include <map>
+#include <vector>
+#include <stdexcept>
+
+using namespace cola;
+using namespace prtypes;
+
+
+struct LocalState {
+	bool unreachable = false;
+	std::map<const VariableDeclaration*, const Malloc*> fresh; // unpublished allocation a variable points to
+	std::set<const VariableDeclaration*> active; // variables known to be active within the current atomic block
+
+	static LocalState bottom() {
+		LocalState result;
+		result.unreachable = true;
+		return result;
+	}
+
+	bool is_fresh(const VariableDeclaration& decl) const {
+		return fresh.count(&decl) > 0;
+	}
+
+	bool is_trivially_active(const VariableDeclaration& decl) const {
+		return is_fresh(decl) || active.count(&decl) > 0;
+	}
+
+	void forget(const VariableDeclaration& decl) {
+		fresh.erase(&decl);
+		active.erase(&decl);
+	}
+
+	void publish(const VariableDeclaration& decl) {
+		// every alias of a published cell is published as well
+		auto find = fresh.find(&decl);
+		if (find == fresh.end()) {
+			return;
+		}
+		const Malloc* allocation = find->second;
+		for (auto it = fresh.begin(); it != fresh.end(); ) {
+			if (it->second == allocation) {
+				it = fresh.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+
+	void copy(const VariableDeclaration& dst, const VariableDeclaration& src) {
+		auto find = fresh.find(&src);
+		const Malloc* allocation = find == fresh.end() ? nullptr : find->second;
+		bool is_active = active.count(&src) > 0;
+		forget(dst);
+		// other threads may see shared variables, so an allocation reached through one is not fresh
+		if (allocation && !src.is_shared && !dst.is_shared) fresh[&dst] = allocation;
+		if (is_active) active.insert(&dst);
+	}
+
+	void join(const LocalState& other) {
+		if (other.unreachable) {
+			return;
+		}
+		if (unreachable) {
+			*this = other;
+			return;
+		}
+		for (auto it = fresh.begin(); it != fresh.end(); ) {
+			auto find = other.fresh.find(it->first);
+			if (find == other.fresh.end() || find->second != it->second) {
+				it = fresh.erase(it);
+			} else {
+				++it;
+			}
+		}
+		for (auto it = active.begin(); it != active.end(); ) {
+			if (other.active.count(*it) == 0) {
+				it = active.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+
+	bool operator==(const LocalState& other) const {
+		return unreachable == other.unreachable && fresh == other.fresh && active == other.active;
+	}
+	bool operator!=(const LocalState& other) const { return !(*this == other); }
+};
+
+
+inline const VariableDeclaration* as_pointer_variable(const Expression& expr) {
+	auto var = dynamic_cast<const VariableExpression*>(&expr);
+	if (var && var->decl.type.sort == Sort::PTR) {
+		return &var->decl;
+	}
+	return nullptr;
+}
+
+inline void collect_cas(const Expression& expr, std::vector<const CompareAndSwap*>& result) {
+	if (auto cas = dynamic_cast<const CompareAndSwap*>(&expr)) {
+		result.push_back(cas);
+	} else if (auto negation = dynamic_cast<const NegatedExpression*>(&expr)) {
+		collect_cas(*negation->expr, result);
+	} else if (auto binary = dynamic_cast<const BinaryExpression*>(&expr)) {
+		collect_cas(*binary->lhs, result);
+		collect_cas(*binary->rhs, result);
+	}
+}
+
+
+struct LocalDischargeVisitor final : public Visitor {
+	LocalState state;
+	std::vector<LocalState> break_states, continue_states;
+	bool inside_atomic = false;
+	std::map<const Assert*, bool> verdicts; // an assertion is locally valid if it was valid on every visit
+	bool relative; // whether assertions may be valid relative to earlier ones
+
+	LocalDischargeVisitor(bool relative) : relative(relative) {}
+
+	void command_end() {
+		if (!inside_atomic) {
+			// interference may happen between atomic steps
+			state.active.clear();
+		}
+	}
+
+	void handle_cas(const CompareAndSwap& cas) {
+		for (const auto& elem : cas.elems) {
+			if (auto src = as_pointer_variable(*elem.src)) {
+				state.publish(*src);
+			}
+			if (auto dst = dynamic_cast<const VariableExpression*>(elem.dst.get())) {
+				state.forget(dst->decl);
+			}
+		}
+	}
+
+	void handle_condition(const Expression& expr) {
+		std::vector<const CompareAndSwap*> cas;
+		collect_cas(expr, cas);
+		for (const auto* elem : cas) {
+			handle_cas(*elem);
+		}
+	}
+
+	void handle_call(const std::vector<std::unique_ptr<Expression>>& args) {
+		for (const auto& arg : args) {
+			if (auto var = as_pointer_variable(*arg)) {
+				state.publish(*var);
+			}
+		}
+		// calls may free (e.g. retire), but only published cells
+		state.active.clear();
+	}
+
+	void handle_loop(const Scope& body, const Expression* condition) {
+		auto outer_breaks = std::move(break_states);
+		auto outer_continues = std::move(continue_states);
+		LocalState head = state;
+		while (true) {
+			break_states.clear();
+			continue_states.clear();
+			state = head;
+			if (condition) handle_condition(*condition);
+			body.accept(*this);
+			LocalState next = head;
+			next.join(state);
+			for (const auto& other : continue_states) {
+				next.join(other);
+			}
+			if (next == head) break;
+			head = std::move(next);
+		}
+
+		// exit via condition (if any) or via break
+		LocalState exit = LocalState::bottom();
+		if (condition) {
+			state = head;
+			handle_condition(*condition);
+			exit = std::move(state);
+		}
+		for (const auto& other : break_states) {
+			exit.join(other);
+		}
+		state = std::move(exit);
+		break_states = std::move(outer_breaks);
+		continue_states = std::move(outer_continues);
+	}
+
+	void visit(const VariableDeclaration& /*node*/) override { throw std::logic_error("Unexpected invocation: LocalDischargeVisitor::visit(const VariableDeclaration&)"); }
+	void visit(const Expression& /*node*/) override { throw std::logic_error("Unexpected invocation: LocalDischargeVisitor::visit(const Expression&)"); }
+	void visit(const BooleanValue& /*node*/) override { throw std::logic_error("Unexpected invocation: LocalDischargeVisitor::visit(const BooleanValue&)"); }
+	void visit(const NullValue& /*node*/) override { throw std::logic_error("Unexpected invocation: LocalDischargeVisitor::visit(const NullValue&)"); }
+	void visit(const EmptyValue& /*node*/) override { throw std::logic_error("Unexpected invocation: LocalDischargeVisitor::visit(const EmptyValue&)"); }
+	void visit(const MaxValue& /*node*/) override { throw std::logic_error("Unexpected invocation: LocalDischargeVisitor::visit(const MaxValue&)"); }
+	void visit(const MinValue& /*node*/) override { throw std::logic_error("Unexpected invocation: LocalDischargeVisitor::visit(const MinValue&)"); }
+	void visit(const NDetValue& /*node*/) override { throw std::logic_error("Unexpected invocation: LocalDischargeVisitor::visit(const NDetValue&)"); }
+	void visit(const VariableExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: LocalDischargeVisitor::visit(const VariableExpression&)"); }
+	void visit(const NegatedExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: LocalDischargeVisitor::visit(const NegatedExpression&)"); }
+	void visit(const BinaryExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: LocalDischargeVisitor::visit(const BinaryExpression&)"); }
+	void visit(const Dereference& /*node*/) override { throw std::logic_error("Unexpected invocation: LocalDischargeVisitor::visit(const Dereference&)"); }
+	void visit(const InvariantExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: LocalDischargeVisitor::visit(const InvariantExpression&)"); }
+	void visit(const InvariantActive& /*node*/) override { throw std::logic_error("Unexpected invocation: LocalDischargeVisitor::visit(const InvariantActive&)"); }
+	void visit(const Program& /*node*/) override { throw std::logic_error("Unexpected invocation: LocalDischargeVisitor::visit(const Program&)"); }
+
+	void visit(const Sequence& node) override { node.first->accept(*this); node.second->accept(*this); }
+	void visit(const Scope& node) override {
+		for (const auto& decl : node.variables) {
+			state.forget(*decl);
+		}
+		node.body->accept(*this);
+	}
+	void visit(const Atomic& node) override {
+		bool was_inside_atomic = inside_atomic;
+		inside_atomic = true;
+		node.body->accept(*this);
+		inside_atomic = was_inside_atomic;
+		command_end();
+	}
+	void visit(const Choice& node) override {
+		LocalState pre = state;
+		LocalState post = LocalState::bottom();
+		for (const auto& branch : node.branches) {
+			state = pre;
+			branch->accept(*this);
+			post.join(state);
+		}
+		state = std::move(post);
+	}
+	void visit(const IfThenElse& node) override {
+		handle_condition(*node.expr);
+		command_end();
+		LocalState pre = state;
+		node.ifBranch->accept(*this);
+		LocalState post = std::move(state);
+		state = std::move(pre);
+		node.elseBranch->accept(*this);
+		post.join(state);
+		state = std::move(post);
+	}
+	void visit(const Loop& node) override { handle_loop(*node.body, nullptr); }
+	void visit(const While& node) override { handle_loop(*node.body, node.expr.get()); }
+	void visit(const Skip& /*node*/) override { command_end(); }
+	void visit(const Break& /*node*/) override {
+		break_states.push_back(state);
+		state = LocalState::bottom();
+	}
+	void visit(const Continue& /*node*/) override {
+		continue_states.push_back(state);
+		state = LocalState::bottom();
+	}
+	void visit(const Assume& node) override { handle_condition(*node.expr); command_end(); }
+	void visit(const Assert& node) override {
+		auto invariant = dynamic_cast<const InvariantActive*>(node.inv.get());
+		if (invariant) {
+			auto var = as_pointer_variable(*invariant->expr);
+			bool is_valid = state.unreachable || (var && (relative ? state.is_trivially_active(*var) : state.is_fresh(*var)));
+			auto insertion = verdicts.insert({ &node, is_valid });
+			insertion.first->second &= is_valid;
+			if (var && !state.unreachable) {
+				state.active.insert(var);
+			}
+		}
+		command_end();
+	}
+	void visit(const AngelChoose& /*node*/) override { command_end(); }
+	void visit(const AngelActive& /*node*/) override { command_end(); }
+	void visit(const AngelContains& /*node*/) override { command_end(); }
+	void visit(const Return& /*node*/) override { state = LocalState::bottom(); }
+	void visit(const Malloc& node) override {
+		state.forget(node.lhs);
+		if (!node.lhs.is_shared) {
+			// allocating into a shared variable publishes the cell right away
+			state.fresh[&node.lhs] = &node;
+		}
+		command_end();
+	}
+	void visit(const Assignment& node) override {
+		auto lhs = dynamic_cast<const VariableExpression*>(node.lhs.get());
+		auto rhs = as_pointer_variable(*node.rhs);
+		if (lhs && rhs) {
+			if (lhs->decl.is_shared) state.publish(*rhs);
+			state.copy(lhs->decl, *rhs);
+		} else if (lhs) {
+			state.forget(lhs->decl);
+		} else if (rhs) {
+			// stored into a field
+			state.publish(*rhs);
+		}
+		handle_condition(*node.rhs);
+		command_end();
+	}
+	void visit(const Enter& node) override { handle_call(node.args); command_end(); }
+	void visit(const Exit& /*node*/) override { state.active.clear(); command_end(); }
+	void visit(const Macro& node) override {
+		// macros may do anything to the caller's variables
+		handle_call(node.args);
+		state.fresh.clear();
+		command_end();
+	}
+	void visit(const CompareAndSwap& node) override { handle_cas(node); command_end(); }
+
+	void visit(const Function& function) override {
+		state = LocalState();
+		break_states.clear();
+		continue_states.clear();
+		inside_atomic = false;
+		if (function.body) {
+			function.body->accept(*this);
+		}
+	}
+};
+
+std::set<const Assert*> prtypes::find_locally_valid_assertions(const Program& program, bool relative) {
+	LocalDischargeVisitor visitor(relative);
+	program.initializer->accept(visitor);
+	for (const auto& function : program.functions) {
+		if (function->kind == Function::INTERFACE) {
+			function->accept(visitor);
+		}
+	}
+
+	std::set<const Assert*> result;
+	for (const auto& [assertion, is_valid] : visitor.verdicts) {
+		if (is_valid) {
+			result.insert(assertion);
+		}
+	}
+	return result;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#ifndef PRTYPES_DISCHARGE
+#define PRTYPES_DISCHARGE
+
+#include "cola/ast.hpp"
+#include <set>
+
+
+namespace prtypes {
+
+	/** Finds the 'assert(active(p))' assertions that hold for trivial reasons and thus need not be sent to CAVE.
+	  * Uses an intra-procedural must analysis over the initializer and the interface functions; an assertion is locally valid if
+	  *   - 'p' points to a cell allocated by the executing thread that has not been published (stored into a shared variable or
+	  *     a field, passed to a function, or used in a CAS) since, or
+	  *   - 'p' is an alias of a pointer that was already asserted active earlier within the same atomic block.
+	  * The second case is valid relative to the earlier assertion, which remains subject to the CAVE check;
+	  * it is considered only if 'relative' is set. Unset it if CAVE checks only some of the assertions, as the earlier one may not be among them.
+	  * Variables are fresh only if they are thread-local; other threads may see shared ones.
+	  */
+	std::set<const cola::Assert*> find_locally_valid_assertions(const cola::Program& program, bool relative=true);
+
+} // namespace prtypes
+
+#endif
@@ -0,0 +1,155 @@
+#include "types/effects.hpp"
+
+using namespace cola;
+using namespace prtypes;
+
+
+inline bool dereferences(const ExpressionInfo& info) {
+	if (info.kind == ExpressionInfo::Kind::DEREFERENCE) {
+		return true;
+	}
+	return (info.lhs && dereferences(*info.lhs)) || (info.rhs && dereferences(*info.rhs));
+}
+
+struct EffectVisitor final : public Visitor {
+	EffectTable& table;
+	Effect result;
+	EffectVisitor(EffectTable& table) : table(table) {}
+
+	void add(const Effect& effect) {
+		result.shared_reads.insert(effect.shared_reads.begin(), effect.shared_reads.end());
+		result.shared_writes.insert(effect.shared_writes.begin(), effect.shared_writes.end());
+		result.reads_heap |= effect.reads_heap;
+		result.writes_heap |= effect.writes_heap;
+		result.calls_retire |= effect.calls_retire;
+		result.is_local &= effect.is_local;
+	}
+	void add(const Statement& stmt) {
+		add(table[stmt]);
+	}
+	void read(const Expression& expr) {
+		const ExpressionInfo& info = table.expression_table()[expr];
+		for (const auto* decl : info.variables) {
+			if (decl->is_shared) {
+				result.shared_reads.insert(decl);
+			}
+		}
+		result.reads_heap |= dereferences(info);
+		result.is_local &= info.is_local;
+	}
+	void write(const VariableDeclaration& decl) {
+		if (decl.is_shared) {
+			result.shared_writes.insert(&decl);
+			result.is_local = false;
+		}
+	}
+	void write(const Expression& expr) {
+		if (typeid(expr) == typeid(VariableExpression)) {
+			write(static_cast<const VariableExpression&>(expr).decl);
+		} else if (typeid(expr) == typeid(Dereference)) {
+			read(*static_cast<const Dereference&>(expr).expr);
+			result.writes_heap = true;
+			result.is_local = false;
+		} else {
+			read(expr);
+		}
+	}
+
+	void visit(const Sequence& node) override {
+		add(*node.first);
+		add(*node.second);
+	}
+	void visit(const Scope& node) override { add(*node.body); }
+	void visit(const Atomic& node) override { add(*node.body); }
+	void visit(const Choice& node) override {
+		for (const auto& branch : node.branches) {
+			add(*branch);
+		}
+	}
+	void visit(const IfThenElse& node) override {
+		read(*node.expr);
+		add(*node.ifBranch);
+		add(*node.elseBranch);
+	}
+	void visit(const Loop& node) override { add(*node.body); }
+	void visit(const While& node) override {
+		read(*node.expr);
+		add(*node.body);
+	}
+
+	void visit(const Skip& /*node*/) override { /* do nothing */ }
+	void visit(const Break& /*node*/) override { /* do nothing */ }
+	void visit(const Continue& /*node*/) override { /* do nothing */ }
+	void visit(const Exit& /*node*/) override { /* do nothing */ }
+	void visit(const AngelChoose& /*node*/) override { /* do nothing */ } // TODO: correct?
+	void visit(const AngelActive& /*node*/) override { /* do nothing */ } // TODO: correct?
+	void visit(const AngelContains& /*node*/) override { /* do nothing */ } // TODO: correct?
+	void visit(const Assume& node) override { read(*node.expr); }
+	void visit(const Assert& node) override { read(*node.inv->expr); }
+	void visit(const Return& node) override {
+		if (node.expr) {
+			read(*node.expr);
+		}
+		result.is_local = false; // ends the operation, visible to the observers
+	}
+	void visit(const Malloc& node) override { write(node.lhs); }
+	void visit(const Assignment& node) override {
+		write(*node.lhs);
+		read(*node.rhs);
+	}
+	void visit(const Enter& node) override {
+		for (const auto& arg : node.args) {
+			read(*arg);
+		}
+		if (&node.decl == &table.retire()) {
+			result.calls_retire = true;
+			result.is_local = false;
+		}
+	}
+	void visit(const Macro& node) override {
+		if (node.decl.body) {
+			add(*node.decl.body);
+		}
+		// parameters alias their arguments
+		for (const auto& arg : node.args) {
+			read(*arg);
+			write(*arg);
+		}
+	}
+	void visit(const CompareAndSwap& node) override {
+		for (const auto& elem : node.elems) {
+			write(*elem.dst);
+			read(*elem.dst);
+			read(*elem.cmp);
+			read(*elem.src);
+		}
+	}
+
+	void visit(const VariableDeclaration& /*node*/) override { throw std::logic_error("Unexpected invocation: EffectVisitor::visit(const VariableDeclaration&)"); }
+	void visit(const Expression& /*node*/) override { throw std::logic_error("Unexpected invocation: EffectVisitor::visit(const Expression&)"); }
+	void visit(const BooleanValue& /*node*/) override { throw std::logic_error("Unexpected invocation: EffectVisitor::visit(const BooleanValue&)"); }
+	void visit(const NullValue& /*node*/) override { throw std::logic_error("Unexpected invocation: EffectVisitor::visit(const NullValue&)"); }
+	void visit(const EmptyValue& /*node*/) override { throw std::logic_error("Unexpected invocation: EffectVisitor::visit(const EmptyValue&)"); }
+	void visit(const MaxValue& /*node*/) override { throw std::logic_error("Unexpected invocation: EffectVisitor::visit(const MaxValue&)"); }
+	void visit(const MinValue& /*node*/) override { throw std::logic_error("Unexpected invocation: EffectVisitor::visit(const MinValue&)"); }
+	void visit(const NDetValue& /*node*/) override { throw std::logic_error("Unexpected invocation: EffectVisitor::visit(const NDetValue&)"); }
+	void visit(const VariableExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: EffectVisitor::visit(const VariableExpression&)"); }
+	void visit(const NegatedExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: EffectVisitor::visit(const NegatedExpression&)"); }
+	void visit(const BinaryExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: EffectVisitor::visit(const BinaryExpression&)"); }
+	void visit(const Dereference& /*node*/) override { throw std::logic_error("Unexpected invocation: EffectVisitor::visit(const Dereference&)"); }
+	void visit(const InvariantExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: EffectVisitor::visit(const InvariantExpression&)"); }
+	void visit(const InvariantActive& /*node*/) override { throw std::logic_error("Unexpected invocation: EffectVisitor::visit(const InvariantActive&)"); }
+	void visit(const Function& /*node*/) override { throw std::logic_error("Unexpected invocation: EffectVisitor::visit(const Function&)"); }
+	void visit(const Program& /*node*/) override { throw std::logic_error("Unexpected invocation: EffectVisitor::visit(const Program&)"); }
+};
+
+
+const Effect& EffectTable::operator[](const Statement& stmt) {
+	auto known = _effects.find(&stmt);
+	if (known != _effects.end()) {
+		return known->second;
+	}
+	EffectVisitor visitor(*this);
+	stmt.accept(visitor);
+	return _effects.insert({ &stmt, std::move(visitor.result) }).first->second;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#ifndef PRTYPES_EFFECTS
+#define PRTYPES_EFFECTS
+
+#include "cola/ast.hpp"
+#include "cola/hashcons.hpp"
+#include <set>
+#include <unordered_map>
+
+
+namespace prtypes {
+
+	/** Bottom-up summary of what a statement may do to the state other threads can observe.
+	  * Calls to 'inline' functions are summarized by the body of the callee.
+	  */
+	struct Effect {
+		std::set<const cola::VariableDeclaration*> shared_reads;
+		std::set<const cola::VariableDeclaration*> shared_writes;
+		bool reads_heap = false;
+		bool writes_heap = false;
+		bool calls_retire = false;
+		bool is_local = true; // accesses neither shared variables nor the heap, and does not retire
+	};
+
+	/** Memoizes the 'Effect' of statements, computing each one from the effects of its children.
+	  * Like 'cola::ExpressionTable', results are memoized per node; statements must not be modified after
+	  * their effect was queried (moving them into new parents is fine).
+	  */
+	class EffectTable {
+		private:
+			const cola::Function& retire_function;
+			cola::ExpressionTable& expressions;
+			std::unordered_map<const cola::Statement*, Effect> _effects;
+
+		public:
+			EffectTable(const cola::Function& retire_function, cola::ExpressionTable& expressions) : retire_function(retire_function), expressions(expressions) {}
+
+			const Effect& operator[](const cola::Statement& stmt);
+
+			const cola::Function& retire() const { return retire_function; }
+			cola::ExpressionTable& expression_table() { return expressions; }
+	};
+
+} // namespace prtypes
+
+#endif
@@ -15,6 +15,12 @@ namespace prtypes {
 		virtual const char* what() const noexcept { return cause.c_str(); }
 	};
 
+	struct CaveResourceError : public CaveError {
+		enum Kind { TIMEOUT, MEMORY };
+		const Kind kind;
+		CaveResourceError(Kind kind_, std::string cause) : CaveError("CAVE exceeded its " + cause + "."), kind(kind_) {}
+	};
+
 
 	struct TypeCheckError : public std::exception {
 		const std::string cause;
@@ -71,6 +77,13 @@ namespace prtypes {
 	};
 
 
+	struct TimeoutError : public std::exception {
+		const std::string cause;
+		TimeoutError(std::string cause_) : cause("Time budget exhausted: " + std::move(cause_) + ".") {}
+		virtual const char* what() const noexcept { return cause.c_str(); }
+	};
+
+
 	template<typename ErrorType, typename... ErrorTypeArgs>
 	inline void raise_error(ErrorTypeArgs&&... args) {
 		throw ErrorType(std::forward<ErrorTypeArgs>(args)...);
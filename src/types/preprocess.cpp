@@ -1,7 +1,10 @@
 #include "types/preprocess.hpp"
 #include "cola/util.hpp"
 #include "cola/transform.hpp"
+#include "cola/hashcons.hpp"
+#include "cola/trace.hpp"
 #include "types/error.hpp"
+#include "types/effects.hpp"
 #include <iostream>
 #include <set>
 
@@ -9,23 +12,37 @@ using namespace cola;
 using namespace prtypes;
 
 
+std::map<const VariableDeclaration*, const VariableDeclaration*> make_argument_map(const Macro& call) {
+	conditionally_raise_error<UnsupportedConstructError>(call.decl.return_type != Type::void_type(), "inline functions must have void type");
+	assert(call.args.size() == call.decl.args.size());
+	std::map<const VariableDeclaration*, const VariableDeclaration*> intern2extern;
+	for (std::size_t i = 0; i < call.args.size(); ++i) {
+		const Expression* arg = call.args.at(i).get();
+		conditionally_raise_error<UnsupportedConstructError>(typeid(*arg) != typeid(VariableExpression), "only variables may be passed to inline functions");
+		const VariableDeclaration* external_decl = &static_cast<const VariableExpression*>(arg)->decl;
+		const VariableDeclaration* internal_decl = call.decl.args.at(i).get();
+		conditionally_raise_error<UnsupportedConstructError>(external_decl->type != internal_decl->type, "type missmatch in invocation of inline function '" + call.decl.name + "'");
+		intern2extern.insert({ internal_decl, external_decl });
+	}
+	return intern2extern;
+}
+
+const VariableDeclaration& externalize(const std::map<const VariableDeclaration*, const VariableDeclaration*>& intern2extern, const VariableDeclaration& decl) {
+	if (decl.is_shared) {
+		return decl;
+	}
+	auto search = intern2extern.find(&decl);
+	conditionally_raise_error<std::logic_error>(search == intern2extern.end(), "Unexpected variable '" + decl.name + "'; could not externatlize.");
+	assert(search->second);
+	return *search->second;
+}
+
 struct MacroCopyVisitor final : public Visitor {
 	const Macro& to_copy;
 	std::map<const VariableDeclaration*, const VariableDeclaration*> intern2extern;
 	std::unique_ptr<AstNode> result;
 
-	MacroCopyVisitor(const Macro& to_copy) : to_copy(to_copy) {
-		conditionally_raise_error<UnsupportedConstructError>(to_copy.decl.return_type != Type::void_type(), "inline functions must have void type");
-		assert(to_copy.args.size() == to_copy.decl.args.size());
-		for (std::size_t i = 0; i < to_copy.args.size(); ++i) {
-			const Expression* arg = to_copy.args.at(i).get();
-			conditionally_raise_error<UnsupportedConstructError>(typeid(*arg) != typeid(VariableExpression), "only variables may be passed to inline functions");
-			const VariableDeclaration* external_decl = &static_cast<const VariableExpression*>(arg)->decl;
-			const VariableDeclaration* internal_decl = to_copy.decl.args.at(i).get();
-			conditionally_raise_error<UnsupportedConstructError>(external_decl->type != internal_decl->type, "type missmatch in invocation of inline function '" + to_copy.decl.name + "'");
-			intern2extern.insert({ internal_decl, external_decl });
-		}
-	}
+	MacroCopyVisitor(const Macro& to_copy) : to_copy(to_copy), intern2extern(make_argument_map(to_copy)) {}
 
 	template<typename R>
 	std::unique_ptr<R> copy_node(const AstNode& node) {
@@ -68,16 +85,7 @@ struct MacroCopyVisitor final : public Visitor {
 		result = std::make_unique<NDetValue>();
 	}
 	void visit(const VariableExpression& node) {
-		const VariableDeclaration* decl;
-		if (node.decl.is_shared) {
-			decl = &node.decl;
-		} else {
-			auto search = intern2extern.find(&node.decl);
-			conditionally_raise_error<std::logic_error>(search == intern2extern.end(), "Unexpected variable '" + node.decl.name + "'; could not externatlize.");
-			decl = search->second;
-		}
-		assert(decl);
-		result = std::make_unique<VariableExpression>(*decl);
+		result = std::make_unique<VariableExpression>(externalize(intern2extern, node.decl));
 	}
 	void visit(const NegatedExpression& node) {
 		result = std::make_unique<NegatedExpression>(copy_node<Expression>(*node.expr));
@@ -86,7 +94,7 @@ struct MacroCopyVisitor final : public Visitor {
 		result = std::make_unique<BinaryExpression>(node.op, copy_node<Expression>(*node.lhs), copy_node<Expression>(*node.rhs));
 	}
 	void visit(const Dereference& node) {
-		result = std::make_unique<Dereference>(copy_node<Expression>(*node.expr), node.fieldname);
+		result = std::make_unique<Dereference>(copy_node<Expression>(*node.expr), node.fieldname, node.field_id);
 	}
 	void visit(const InvariantExpression& node) {
 		result = std::make_unique<InvariantExpression>(copy_node<Expression>(*node.expr));
@@ -174,8 +182,143 @@ struct MacroCopyVisitor final : public Visitor {
 	}
 };
 
+struct MacroSubstitutionVisitor final : public NonConstVisitor {
+	// rewrites a macro body in place; performs the same checks as 'MacroCopyVisitor'
+	std::map<const VariableDeclaration*, const VariableDeclaration*> intern2extern;
+	std::unique_ptr<Statement>* owner = nullptr;
+
+	MacroSubstitutionVisitor(const Macro& call) : intern2extern(make_argument_map(call)) {}
+
+	void substitute(std::unique_ptr<Expression>& expr) {
+		assert(expr);
+		const VariableExpression* var = dynamic_cast<const VariableExpression*>(expr.get());
+		if (var) {
+			const VariableDeclaration& decl = externalize(intern2extern, var->decl);
+			if (&decl != &var->decl) {
+				expr = std::make_unique<VariableExpression>(decl);
+			}
+		} else {
+			expr->accept(*this);
+		}
+	}
+
+	void handle_statement(std::unique_ptr<Statement>& stmt) {
+		assert(stmt);
+		const AnnotatedStatement* tmp = dynamic_cast<const AnnotatedStatement*>(stmt.get());
+		conditionally_raise_error<UnsupportedConstructError>(tmp && tmp->annotation, "annotations are not supported in inline functions");
+		owner = &stmt;
+		stmt->accept(*this);
+	}
+
+	void visit(Function& /*node*/) { throw std::logic_error("Unexpected invocation: MacroSubstitutionVisitor::visit(Function&)"); }
+	void visit(Program& /*node*/) { throw std::logic_error("Unexpected invocation: MacroSubstitutionVisitor::visit(Program&)"); }
+	void visit(VariableDeclaration& /*node*/) { throw std::logic_error("Unexpected invocation: MacroSubstitutionVisitor::visit(VariableDeclaration&)"); }
+	void visit(Expression& /*node*/) { throw std::logic_error("Unexpected invocation: MacroSubstitutionVisitor::visit(Expression&)"); }
+	void visit(VariableExpression& /*node*/) { throw std::logic_error("Unexpected invocation: MacroSubstitutionVisitor::visit(VariableExpression&)"); }
+
+	void visit(BooleanValue& /*node*/) { /* do nothing */ }
+	void visit(NullValue& /*node*/) { /* do nothing */ }
+	void visit(EmptyValue& /*node*/) { /* do nothing */ }
+	void visit(MaxValue& /*node*/) { /* do nothing */ }
+	void visit(MinValue& /*node*/) { /* do nothing */ }
+	void visit(NDetValue& /*node*/) { /* do nothing */ }
+	void visit(NegatedExpression& node) {
+		substitute(node.expr);
+	}
+	void visit(BinaryExpression& node) {
+		substitute(node.lhs);
+		substitute(node.rhs);
+	}
+	void visit(Dereference& node) {
+		substitute(node.expr);
+	}
+	void visit(InvariantExpression& node) {
+		substitute(node.expr);
+	}
+	void visit(InvariantActive& node) {
+		substitute(node.expr);
+	}
+
+	void visit(Sequence& node) {
+		handle_statement(node.first);
+		handle_statement(node.second);
+	}
+	void visit(Scope& node) {
+		conditionally_raise_error<UnsupportedConstructError>(!node.variables.empty(), "Cannot copy variables from inline function");
+		handle_statement(node.body);
+	}
+	void visit(Atomic& node) {
+		node.body->accept(*this);
+	}
+	void visit(Choice& node) {
+		for (auto& branch : node.branches) {
+			branch->accept(*this);
+		}
+	}
+	void visit(IfThenElse& node) {
+		substitute(node.expr);
+		node.ifBranch->accept(*this);
+		node.elseBranch->accept(*this);
+	}
+	void visit(Loop& node) {
+		node.body->accept(*this);
+	}
+	void visit(While& node) {
+		substitute(node.expr);
+		node.body->accept(*this);
+	}
+	void visit(Skip& /*node*/) { /* do nothing */ }
+	void visit(Break& /*node*/) { /* do nothing */ }
+	void visit(Continue& /*node*/) { /* do nothing */ }
+	void visit(Assume& node) {
+		substitute(node.expr);
+	}
+	void visit(Assert& node) {
+		node.inv->accept(*this);
+	}
+	void visit(AngelChoose& /*node*/) {
+		raise_error<UnsupportedConstructError>("angels are not supported in inline functions");
+	}
+	void visit(AngelActive& /*node*/) {
+		raise_error<UnsupportedConstructError>("angels are not supported in inline functions");
+	}
+	void visit(AngelContains& node) {
+		assert(owner && owner->get() == &node);
+		const VariableDeclaration& decl = externalize(intern2extern, node.var);
+		if (&decl != &node.var) {
+			*owner = std::make_unique<AngelContains>(decl);
+		}
+	}
+	void visit(Return& /*node*/) {
+		raise_error<UnsupportedConstructError>("'return' is not supported in inline functions");
+	}
+	void visit(Malloc& /*node*/) {
+		raise_error<UnsupportedConstructError>("'malloc' is not supported in inline functions");
+	}
+	void visit(Assignment& node) {
+		substitute(node.lhs);
+		substitute(node.rhs);
+	}
+	void visit(Enter& node) {
+		for (auto& arg : node.args) {
+			substitute(arg);
+		}
+	}
+	void visit(Exit& /*node*/) { /* do nothing */ }
+	void visit(Macro& /*node*/) {
+		raise_error<UnsupportedConstructError>("inline function calls are not supported in inline functions");
+	}
+	void visit(CompareAndSwap& /*node*/) {
+		raise_error<UnsupportedConstructError>("'CAS' not supported in inline functions");
+	}
+};
+
 struct InliningVisitor final : public NonConstVisitor {
+	// Macro bodies are shared copy-on-write: every call but the last receives a copy,
+	// the last call takes over the body itself and only its parameter occurrences are rewritten.
 	std::unique_ptr<Statement>* owner;
+	std::vector<std::unique_ptr<Statement>*> calls;
+	std::map<const Function*, std::size_t> pending_calls;
 
 	void visit(VariableDeclaration& /*node*/) { throw std::logic_error("Unexpected invocation: InliningVisitor::visit(VariableDeclaration&)"); }
 	void visit(Expression& /*node*/) { throw std::logic_error("Unexpected invocation: InliningVisitor::visit(Expression&)"); }
@@ -209,8 +352,23 @@ struct InliningVisitor final : public NonConstVisitor {
 
 	void visit(Macro& node) {
 		assert(owner);
-		MacroCopyVisitor visitor(node);
-		*owner = visitor.copy_node<Scope>(*node.decl.body);
+		calls.push_back(owner);
+		pending_calls[&node.decl]++;
+	}
+
+	void inline_call(std::unique_ptr<Statement>& call, std::map<const Function*, Function*>& macros) {
+		const Macro& node = static_cast<const Macro&>(*call);
+		assert(pending_calls.count(&node.decl) > 0);
+		if (--pending_calls[&node.decl] > 0) {
+			MacroCopyVisitor visitor(node);
+			call = visitor.copy_node<Scope>(*node.decl.body);
+		} else {
+			Function& macro = *macros.at(&node.decl);
+			MacroSubstitutionVisitor visitor(node);
+			assert(macro.body);
+			macro.body->accept(visitor);
+			call = std::move(macro.body);
+		}
 	}
 
 	void handle_statement(std::unique_ptr<Statement>& stmt) {
@@ -252,6 +410,14 @@ struct InliningVisitor final : public NonConstVisitor {
 			function->accept(*this);
 		}
 
+		std::map<const Function*, Function*> macros;
+		for (const auto& function : program.functions) {
+			macros[function.get()] = function.get();
+		}
+		for (auto call : calls) {
+			inline_call(*call, macros);
+		}
+
 		auto functions = std::move(program.functions);
 		for (auto& function : functions) {
 			if (function->kind != Function::MACRO) {
@@ -322,161 +488,13 @@ struct CollectDerefVisitor final : public Visitor {
 	void visit(const Program& /*node*/) { throw std::logic_error("Unexpected invocation: CollectDerefVisitor::visit(const Program&)"); }
 };
 
-struct LocalExpressionVisitor final : public Visitor {
-	bool result = true;
-	std::set<const VariableDeclaration*> decls;
-	void visit(const VariableDeclaration& decl) {
-		if (decl.is_shared) {
-			result = false;
-		}
-		decls.insert(&decl);
-	}
-	void visit(const Dereference& deref) {
-		// memory access may not be local
-		assert(deref.expr);
-		deref.expr->accept(*this);
-		result = false;
-	}
-	void visit(const BooleanValue& /*node*/) { /* do nothing */ }
-	void visit(const NullValue& /*node*/) { /* do nothing */ }
-	void visit(const EmptyValue& /*node*/) { /* do nothing */ }
-	void visit(const MaxValue& /*node*/) { /* do nothing */ }
-	void visit(const MinValue& /*node*/) { /* do nothing */ }
-	void visit(const NDetValue& /*node*/) { /* do nothing */ }
-	void visit(const VariableExpression& expr) {
-		expr.decl.accept(*this);
-	}
-	void visit(const NegatedExpression& expr) {
-		assert(expr.expr);
-		expr.expr->accept(*this);
-	}
-	void visit(const BinaryExpression& expr) {
-		assert(expr.lhs);
-		assert(expr.rhs);
-		expr.lhs->accept(*this);
-		expr.rhs->accept(*this);
-	}
-	
-	void visit(const Expression& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Expression&)"); }
-	void visit(const InvariantExpression& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const InvariantExpression&)"); }
-	void visit(const InvariantActive& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const InvariantActive&)"); }
-	void visit(const Sequence& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Sequence&)"); }
-	void visit(const Scope& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Scope&)"); }
-	void visit(const Atomic& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Atomic&)"); }
-	void visit(const Choice& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Choice&)"); }
-	void visit(const IfThenElse& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const IfThenElse&)"); }
-	void visit(const Loop& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Loop&)"); }
-	void visit(const While& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const While&)"); }
-	void visit(const Skip& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Skip&)"); }
-	void visit(const Break& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Break&)"); }
-	void visit(const Continue& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Continue&)"); }
-	void visit(const Assume& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Assume&)"); }
-	void visit(const Assert& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Assert&)"); }
-	void visit(const AngelChoose& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const AngelChoose&)"); }
-	void visit(const AngelActive& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const AngelActive&)"); }
-	void visit(const AngelContains& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const AngelContains&)"); }
-	void visit(const Return& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Return&)"); }
-	void visit(const Malloc& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Malloc&)"); }
-	void visit(const Assignment& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Assignment&)"); }
-	void visit(const Enter& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Enter&)"); }
-	void visit(const Exit& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Exit&)"); }
-	void visit(const Macro& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Macro&)"); }
-	void visit(const CompareAndSwap& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const CompareAndSwap&)"); }
-	void visit(const Function& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Function&)"); }
-	void visit(const Program& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Program&)"); }
-};
-
-inline bool is_expression_local(const Expression& expr) {
-	LocalExpressionVisitor visitor;
-	expr.accept(visitor);
-	return visitor.result;
-}
-
-struct NeedsAtomicVisitor final : public Visitor {
-	bool result = true;
-	const Function& retire_function;
-	NeedsAtomicVisitor(const Function& retire_function) : retire_function(retire_function) {}
-
-	void visit(const VariableDeclaration& /*node*/) override { throw std::logic_error("Unexpected invocation: NeedsAtomicVisitor::visit(const VariableDeclaration&)"); }
-	void visit(const Expression& /*node*/) override { throw std::logic_error("Unexpected invocation: NeedsAtomicVisitor::visit(const Expression&)"); }
-	void visit(const BooleanValue& /*node*/) override { throw std::logic_error("Unexpected invocation: NeedsAtomicVisitor::visit(const BooleanValue&)"); }
-	void visit(const NullValue& /*node*/) override { throw std::logic_error("Unexpected invocation: NeedsAtomicVisitor::visit(const NullValue&)"); }
-	void visit(const EmptyValue& /*node*/) override { throw std::logic_error("Unexpected invocation: NeedsAtomicVisitor::visit(const EmptyValue&)"); }
-	void visit(const MaxValue& /*node*/) override { throw std::logic_error("Unexpected invocation: NeedsAtomicVisitor::visit(const MaxValue&)"); }
-	void visit(const MinValue& /*node*/) override { throw std::logic_error("Unexpected invocation: NeedsAtomicVisitor::visit(const MinValue&)"); }
-	void visit(const NDetValue& /*node*/) override { throw std::logic_error("Unexpected invocation: NeedsAtomicVisitor::visit(const NDetValue&)"); }
-	void visit(const VariableExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: NeedsAtomicVisitor::visit(const VariableExpression&)"); }
-	void visit(const NegatedExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: NeedsAtomicVisitor::visit(const NegatedExpression&)"); }
-	void visit(const BinaryExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: NeedsAtomicVisitor::visit(const BinaryExpression&)"); }
-	void visit(const Dereference& /*node*/) override { throw std::logic_error("Unexpected invocation: NeedsAtomicVisitor::visit(const Dereference&)"); }
-	void visit(const InvariantExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: NeedsAtomicVisitor::visit(const InvariantExpression&)"); }
-	void visit(const InvariantActive& /*node*/) override { throw std::logic_error("Unexpected invocation: NeedsAtomicVisitor::visit(const InvariantActive&)"); }
-	void visit(const Function& /*node*/) override { throw std::logic_error("Unexpected invocation: NeedsAtomicVisitor::visit(const Function&)"); }
-	void visit(const Program& /*node*/) override { throw std::logic_error("Unexpected invocation: NeedsAtomicVisitor::visit(const Program&)"); }
-
-	void visit(const Sequence& /*node*/) override { /* do nothing */ }
-	void visit(const Scope& /*node*/) override { /* do nothing */ }
-	void visit(const Choice& /*node*/) override { /* do nothing */ }
-	void visit(const IfThenElse& /*node*/) override { /* do nothing */ }
-	void visit(const Loop& /*node*/) override { /* do nothing */ }
-	void visit(const While& /*node*/) override { /* do nothing */ }
-	void visit(const Return& /*node*/) override { /* do nothing */ }
-	void visit(const Macro& /*node*/) override { /* do nothing */ }
-	void visit(const CompareAndSwap& /*node*/) override { /* do nothing */ }
-
-	void visit(const Atomic& /*node*/) override { this->result = false; }
-	void visit(const Skip& /*node*/) override { this->result = false; }
-	void visit(const Break& /*node*/) override { this->result = false; }
-	void visit(const Continue& /*node*/) override { this->result = false; }
-	void visit(const AngelChoose& /*node*/) override { this->result = false; } // TODO: correct?
-	void visit(const AngelActive& /*node*/) override { this->result = false; } // TODO: correct?
-	void visit(const AngelContains& /*node*/) override { this->result = false; } // TODO: correct?
-	void visit(const Assume& node) override {
-		if (is_expression_local(*node.expr)) {
-			this->result = false;
-		}
-	}
-	void visit(const Assert& node) override {
-		if (is_expression_local(*node.inv->expr)) {
-			this->result = false;
-		}
-	}
-	void visit(const Malloc& node) override {
-		if (!node.lhs.is_shared) {
-			this->result = false;
-		}
-	}
-	void visit(const Assignment& node) override {
-		if (is_expression_local(*node.lhs) && is_expression_local(*node.rhs)) {
-			this->result = false;
-		}
-	}
-	void visit(const Enter& node) override {
-		if (&node.decl == &retire_function) {
-			return;
-		}
-		for (const auto& arg : node.args) {
-			if (!is_expression_local(*arg)) {
-				return;
-			}
-		}
-		this->result = false;
-	}
-	void visit(const Exit& /*node*/) override { this->result = false; }
-};
-
-bool needs_atomic(const Statement& stmt, const Function& retire_function) {
-	NeedsAtomicVisitor visitor(retire_function);
-	stmt.accept(visitor);
-	return visitor.result;
-}
-
 struct PreprocessingVisitor final : public NonConstVisitor {
 	bool in_atomic = false;
 	bool found_return = false;
 	bool found_cmd = false;
-	const Function& retire_function;
-	PreprocessingVisitor(const Function& retire_function) : retire_function(retire_function) {}
+	ExpressionTable expressions; // program expressions are not modified during preprocessing, only moved
+	EffectTable effects; // commands are not modified during preprocessing, only moved
+	PreprocessingVisitor(const Function& retire_function) : effects(retire_function, expressions) {}
 
 	void visit(VariableDeclaration& /*node*/) { throw std::logic_error("Unexpected invocation: PreprocessingVisitor::visit(VariableDeclaration&)"); }
 	void visit(Expression& /*node*/) { throw std::logic_error("Unexpected invocation: PreprocessingVisitor::visit(Expression&)"); }
@@ -501,10 +519,12 @@ struct PreprocessingVisitor final : public NonConstVisitor {
 	}
 	void visit(CompareAndSwap& /*node*/) { throw std::logic_error("Unexpected invocation: PreprocessingVisitor::visit(CompareAndSwap&)"); }
 	void visit(Continue& /*node*/) { raise_error<UnsupportedConstructError>("'continue' not supported"); }
-	void visit(Macro& /*node*/) { raise_error<UnsupportedConstructError>("inline functions not supported"); }
 
 	void handle_assume(std::unique_ptr<Statement>& stmt) {
 		assert(stmt);
+		if (!found_cmd || !effects[*stmt].reads_heap) {
+			return;
+		}
 		CollectDerefVisitor visitor;
 		stmt->accept(visitor);
 		if (visitor.is_assume && !visitor.derefs.empty()) {
@@ -525,7 +545,7 @@ struct PreprocessingVisitor final : public NonConstVisitor {
 		assert(stmt);
 		stmt->accept(*this);
 		handle_assume(stmt);
-		if (found_cmd && !in_atomic && needs_atomic(*stmt, retire_function)) {
+		if (found_cmd && !in_atomic && !effects[*stmt].is_local) {
 			stmt = std::make_unique<Atomic>(std::make_unique<Scope>(std::move(stmt)));
 		}
 		found_cmd = false;
@@ -576,6 +596,7 @@ struct PreprocessingVisitor final : public NonConstVisitor {
 	void visit(Assignment& /*node*/) { found_cmd = true; }
 	void visit(Enter& /*node*/) { found_cmd = true; }
 	void visit(Exit& /*node*/) { found_cmd = true; }
+	void visit(Macro& /*node*/) { /* do nothing */ } // body is preprocessed on its own
 
 	void visit(Function& node) {
 		found_return = false;
@@ -592,15 +613,19 @@ struct PreprocessingVisitor final : public NonConstVisitor {
 	}
 };
 
-void prtypes::preprocess(Program& program, const cola::Function& retire_function) {
-	InliningVisitor inliner;
-	program.accept(inliner);
+void prtypes::preprocess(Program& program, const cola::Function& retire_function, bool inline_macros) {
+	if (inline_macros) {
+		TraceScope trace("preprocess", "inline macros");
+		InliningVisitor inliner;
+		program.accept(inliner);
+	}
 
-	cola::remove_cas(program);
-	cola::remove_scoped_variables(program);
-	cola::remove_conditionals(program);
-	cola::remove_useless_scopes(program);
+	{
+		TraceScope trace("preprocess", "desugar");
+		cola::desugar(program);
+	}
 
+	TraceScope trace("preprocess", "insert active assertions");
 	PreprocessingVisitor visitor(retire_function);
 	program.accept(visitor);
 }
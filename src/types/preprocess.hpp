@@ -2,13 +2,21 @@
 #ifndef PRTYPES_PREPROCESS
 #define PRTYPES_PREPROCESS
 
+#include <cstdint>
 #include "cola/ast.hpp"
 #include "types/error.hpp"
 
 
 namespace prtypes {
 
-	void preprocess(cola::Program& program, const cola::Function& retire_function);
+	/** Version of the output of 'preprocess'; to be bumped whenever it changes, as preprocessed programs are cached.
+	  */
+	static const std::uint32_t PREPROCESS_VERSION = 1;
+
+	/** Prepares a program for type checking. Calls to 'inline' functions are inlined unless 'inline_macros' is false;
+	  * then, the type checker summarizes their bodies per call. The translation to CAVE and 'rmraces' require inlining.
+	  */
+	void preprocess(cola::Program& program, const cola::Function& retire_function, bool inline_macros=true);
 
 } // namespace prtypes
 
@@ -1,6 +1,10 @@
 #include "types/rmraces.hpp"
 #include "types/cave.hpp"
+#include "types/deadline.hpp"
 #include "cola/util.hpp"
+#include "cola/hashcons.hpp"
+#include "cola/parents.hpp"
+#include "cola/trace.hpp"
 #include <iostream>
 #include <deque>
 #include <sstream>
@@ -81,240 +85,84 @@ struct NameCollectorVisitor final : public Visitor {
 	}
 };
 
-struct LocalExpressionVisitor final : public Visitor {
-	bool result = true;
-	std::set<const VariableDeclaration*> decls;
-	void visit(const VariableDeclaration& decl) {
-		if (decl.is_shared) {
-			result = false;
-		}
-		decls.insert(&decl);
-	}
-	void visit(const Dereference& deref) {
-		// memory access may not be local
-		assert(deref.expr);
-		deref.expr->accept(*this);
-		result = false;
-	}
-	void visit(const BooleanValue& /*node*/) { /* do nothing */ }
-	void visit(const NullValue& /*node*/) { /* do nothing */ }
-	void visit(const EmptyValue& /*node*/) { /* do nothing */ }
-	void visit(const MaxValue& /*node*/) { /* do nothing */ }
-	void visit(const MinValue& /*node*/) { /* do nothing */ }
-	void visit(const NDetValue& /*node*/) { /* do nothing */ }
-	void visit(const VariableExpression& expr) {
-		expr.decl.accept(*this);
-	}
-	void visit(const NegatedExpression& expr) {
-		assert(expr.expr);
-		expr.expr->accept(*this);
-	}
-	void visit(const BinaryExpression& expr) {
-		assert(expr.lhs);
-		assert(expr.rhs);
-		expr.lhs->accept(*this);
-		expr.rhs->accept(*this);
-	}
-	
-	void visit(const Expression& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Expression&)"); }
-	void visit(const InvariantExpression& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const InvariantExpression&)"); }
-	void visit(const InvariantActive& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const InvariantActive&)"); }
-	void visit(const Sequence& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Sequence&)"); }
-	void visit(const Scope& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Scope&)"); }
-	void visit(const Atomic& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Atomic&)"); }
-	void visit(const Choice& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Choice&)"); }
-	void visit(const IfThenElse& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const IfThenElse&)"); }
-	void visit(const Loop& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Loop&)"); }
-	void visit(const While& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const While&)"); }
-	void visit(const Skip& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Skip&)"); }
-	void visit(const Break& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Break&)"); }
-	void visit(const Continue& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Continue&)"); }
-	void visit(const Assume& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Assume&)"); }
-	void visit(const Assert& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Assert&)"); }
-	void visit(const AngelChoose& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const AngelChoose&)"); }
-	void visit(const AngelActive& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const AngelActive&)"); }
-	void visit(const AngelContains& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const AngelContains&)"); }
-	void visit(const Return& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Return&)"); }
-	void visit(const Malloc& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Malloc&)"); }
-	void visit(const Assignment& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Assignment&)"); }
-	void visit(const Enter& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Enter&)"); }
-	void visit(const Exit& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Exit&)"); }
-	void visit(const Macro& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Macro&)"); }
-	void visit(const CompareAndSwap& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const CompareAndSwap&)"); }
-	void visit(const Function& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Function&)"); }
-	void visit(const Program& /*node*/) { throw std::logic_error("Unexpected invocation: LocalExpressionVisitor::visit(const Program&)"); }
-};
-
 bool is_expression_local(const Expression& expr) {
-	LocalExpressionVisitor visitor;
-	expr.accept(visitor);
-	return visitor.result;
+	ExpressionTable table;
+	return table[expr].is_local;
 }
 
 std::set<const VariableDeclaration*> collect_variables(const Expression& expr) {
-	LocalExpressionVisitor visitor;
-	expr.accept(visitor);
-	return std::move(visitor.decls);
+	ExpressionTable table;
+	return table[expr].variables;
 }
 
-struct AssertionInsertionVisitor : public NonConstVisitor {
-	const Command& to_find;
-	std::unique_ptr<Statement> to_insert;
-	const bool insert_after;
+struct StatementInsertion {
 	Statement* insertion_parent = nullptr; // may come in handy to undo insertion
-	Function* current_function;
-	Function* found_function;
-	Statement* inserted;
-	Statement* found;
-	std::unique_ptr<Statement>* owner_found;
-	std::unique_ptr<Statement>* owner_inserted;
-	AssertionInsertionVisitor(const Command& to_find, std::unique_ptr<Statement> to_insert, bool insert_after) : to_find(to_find), to_insert(std::move(to_insert)), insert_after(insert_after) {}
-
-	void visit(VariableDeclaration& /*node*/) { throw std::logic_error("Unexpected invocation: AssertionInsertionVisitor::visit(VariableDeclaration&)"); }
-	void visit(Expression& /*node*/) { throw std::logic_error("Unexpected invocation: AssertionInsertionVisitor::visit(Expression&)"); }
-	void visit(BooleanValue& /*node*/) { throw std::logic_error("Unexpected invocation: AssertionInsertionVisitor::visit(BooleanValue&)"); }
-	void visit(NullValue& /*node*/) { throw std::logic_error("Unexpected invocation: AssertionInsertionVisitor::visit(NullValue&)"); }
-	void visit(EmptyValue& /*node*/) { throw std::logic_error("Unexpected invocation: AssertionInsertionVisitor::visit(EmptyValue&)"); }
-	void visit(MaxValue& /*node*/) { throw std::logic_error("Unexpected invocation: AssertionInsertionVisitor::visit(MaxValue&)"); }
-	void visit(MinValue& /*node*/) { throw std::logic_error("Unexpected invocation: AssertionInsertionVisitor::visit(MinValue&)"); }
-	void visit(NDetValue& /*node*/) { throw std::logic_error("Unexpected invocation: AssertionInsertionVisitor::visit(NDetValue&)"); }
-	void visit(VariableExpression& /*node*/) { throw std::logic_error("Unexpected invocation: AssertionInsertionVisitor::visit(VariableExpression&)"); }
-	void visit(NegatedExpression& /*node*/) { throw std::logic_error("Unexpected invocation: AssertionInsertionVisitor::visit(NegatedExpression&)"); }
-	void visit(BinaryExpression& /*node*/) { throw std::logic_error("Unexpected invocation: AssertionInsertionVisitor::visit(BinaryExpression&)"); }
-	void visit(Dereference& /*node*/) { throw std::logic_error("Unexpected invocation: AssertionInsertionVisitor::visit(Dereference&)"); }
-	void visit(InvariantExpression& /*node*/) { throw std::logic_error("Unexpected invocation: AssertionInsertionVisitor::visit(InvariantExpression&)"); }
-	void visit(InvariantActive& /*node*/) { throw std::logic_error("Unexpected invocation: AssertionInsertionVisitor::visit(InvariantActive&)"); }
-	
-	void visit(Skip& /*node*/) { /* do nothing */ }
-	void visit(Break& /*node*/) { /* do nothing */ }
-	void visit(Continue& /*node*/) { /* do nothing */ }
-	void visit(Assume& /*node*/) { /* do nothing */ }
-	void visit(Assert& /*node*/) { /* do nothing */ }
-	void visit(AngelChoose& /*node*/) { /* do nothing */ }
-	void visit(AngelActive& /*node*/) { /* do nothing */ }
-	void visit(AngelContains& /*node*/) { /* do nothing */ }
-	void visit(Return& /*node*/) { /* do nothing */ }
-	void visit(Malloc& /*node*/) { /* do nothing */ }
-	void visit(Assignment& /*node*/) { /* do nothing */ }
-	void visit(Enter& /*node*/) { /* do nothing */ }
-	void visit(Exit& /*node*/) { /* do nothing */ }
-	void visit(Macro& /*node*/) { /* do nothing */ }
-	void visit(CompareAndSwap& /*node*/) { /* do nothing */ }
-
-	std::unique_ptr<Sequence> mk_insertion(std::unique_ptr<Statement> found) {
-		assert(found.get() == &to_find);
-		assert(this->to_insert);
-		assert(!this->insertion_parent);
-		this->inserted = this->to_insert.get();
-		this->found = found.get();
-		assert(this->found);
-		std::unique_ptr<Sequence> result;
-		if (this->insert_after) {
-			// insert: to_find - to_insert
-			result = std::make_unique<Sequence>(std::move(found), std::move(this->to_insert));
-			this->owner_found = &result->first;
-			this->owner_inserted = &result->second;
-		} else {
-			// insert: to_insert - to_find
-			result = std::make_unique<Sequence>(std::move(this->to_insert), std::move(found));
-			this->owner_found = &result->second;
-			this->owner_inserted = &result->first;
-		}
-		assert(result);
-		this->insertion_parent = result.get();
-		this->found_function = this->current_function;
-		assert(!this->to_insert);
-		assert(this->insertion_parent);
-		assert(this->found_function);
-		assert(this->owner_found);
-		assert(this->owner_inserted);
-		return result;
-	}
-	void visit(Sequence& seq) {
-		// handle first
-		assert(seq.first);
-		if (seq.first.get() == &this->to_find) {
-			seq.first = mk_insertion(std::move(seq.first));
-		} else {
-			seq.first->accept(*this);
-		}
-		// handle second
-		assert(seq.second);
-		if (seq.second.get() == &this->to_find) {
-			seq.second = mk_insertion(std::move(seq.second));
-		} else {
-			seq.second->accept(*this);
-		}
-	}
-	void visit(Scope& scope) {
-		assert(scope.body);
-		if (scope.body.get() == &this->to_find) {
-			scope.body = mk_insertion(std::move(scope.body));
-		} else {
-			scope.body->accept(*this);
-		}
-	}
-	void visit(Atomic& node) {
-		assert(node.body);
-		node.body->accept(*this);
-	}
-	void visit(Choice& node) {
-		for (const auto& branch : node.branches) {
-			assert(branch);
-			branch->accept(*this);
-		}
-	}
-	void visit(IfThenElse& node) {
-		assert(node.ifBranch);
-		assert(node.elseBranch);
-		node.ifBranch->accept(*this);
-		node.elseBranch->accept(*this);
-	}
-	void visit(Loop& node) {
-		assert(node.body);
-		node.body->accept(*this);
-	}
-	void visit(While& node) {
-		assert(node.body);
-		node.body->accept(*this);
-	}
-	void visit(Function& function) {
-		if (function.kind == Function::SMR) {
-			return;
-		}
-		current_function = &function;
-		assert(function.body);
-		function.body->accept(*this);
-	}
-	void visit(Program& program) {
-		assert(program.initializer);
-		program.initializer->accept(*this);
-		for (const auto& function : program.functions) {
-			assert(function);
-			function->accept(*this);
-		}
+	Function* found_function = nullptr;
+	Statement* inserted = nullptr;
+	Statement* found = nullptr;
+	std::unique_ptr<Statement>* owner_found = nullptr;
+	std::unique_ptr<Statement>* owner_inserted = nullptr;
+
+	void replace(ParentIndex& index, std::unique_ptr<Statement>& owner, std::unique_ptr<Statement> replacement) {
+		owner = std::move(replacement);
+		index.update(owner, insertion_parent, *found_function);
 	}
 };
 
-AssertionInsertionVisitor insert_active_assertion(Program& program, const SmrObserverStore& observer_store, const Command& cmd, const VariableDeclaration& var, bool insert_after_cmd=false, bool no_check=false) {
+StatementInsertion insert_statement(ParentIndex& index, const Command& to_find, std::unique_ptr<Statement> to_insert, bool insert_after) {
+	conditionally_raise_error<RefinementError>(!index.contains(to_find), "could not locate command in program");
+	StatementLocation location = index[to_find];
+	conditionally_raise_error<RefinementError>(!location.owner, "could not locate command in program");
+	std::unique_ptr<Statement>& slot = *location.owner;
+	assert(slot.get() == &to_find);
+	assert(to_insert);
+	assert(location.function);
+
+	StatementInsertion result;
+	result.inserted = to_insert.get();
+	result.found = slot.get();
+	result.found_function = location.function;
+	std::unique_ptr<Sequence> sequence;
+	if (insert_after) {
+		// insert: to_find - to_insert
+		sequence = std::make_unique<Sequence>(std::move(slot), std::move(to_insert));
+		result.owner_found = &sequence->first;
+		result.owner_inserted = &sequence->second;
+	} else {
+		// insert: to_insert - to_find
+		sequence = std::make_unique<Sequence>(std::move(to_insert), std::move(slot));
+		result.owner_found = &sequence->second;
+		result.owner_inserted = &sequence->first;
+	}
+	result.insertion_parent = sequence.get();
+	slot = std::move(sequence);
+	index.update(slot, location.parent, *location.function);
+	return result;
+}
+
+StatementInsertion insert_active_assertion(Program& program, ParentIndex& index, const SmrObserverStore& observer_store, const Command& cmd, const VariableDeclaration& var, bool insert_after_cmd=false, bool no_check=false) {
 	// make insertion to insert
 	auto assertion = std::make_unique<Assert>(std::make_unique<InvariantActive>(std::make_unique<VariableExpression>(var)));
 	Assert& inserted_assertion = *assertion.get();
 
 	// patch program
-	AssertionInsertionVisitor visitor(cmd, std::move(assertion), insert_after_cmd);
-	program.accept(visitor);
-	assert(!visitor.to_insert);
+	StatementInsertion visitor = insert_statement(index, cmd, std::move(assertion), insert_after_cmd);
 
 	if (no_check || (ASSUME_SHARED_ACTIVE && var.is_shared)) {
 		return visitor;
 	}
 
 	// check added assertion for validity
-	bool is_inserted_assertion_valid = prtypes::discharge_assertions(program, observer_store, { inserted_assertion });
+	bool is_inserted_assertion_valid;
+	try {
+		is_inserted_assertion_valid = prtypes::discharge_assertions(program, observer_store, { inserted_assertion });
+	} catch (const CaveResourceError& /*err*/) {
+		// an assertion CAVE cannot confirm within its limits is no better than an invalid one
+		is_inserted_assertion_valid = false;
+	}
 	if (!is_inserted_assertion_valid) {
 		// roll back insertion, then fail
-		*visitor.owner_inserted = std::make_unique<Skip>();
+		visitor.replace(index, *visitor.owner_inserted, std::make_unique<Skip>());
 		raise_error<RefinementError>("could not infer valid assertion to fix pointer race");
 	}
 	return visitor;
@@ -379,23 +227,25 @@ struct InsertionLocationFinderVisitor final : public Visitor {
 	bool path_reset = false;
 	std::vector<const Command*> path;
 	std::vector<const Statement*> full_path;
+	ExpressionTable expressions;
 	InsertionLocationFinderVisitor(std::set<const VariableDeclaration*> vars, const Command& end) : variables(std::move(vars)), end(end) {}
 
-	struct Heureka : public std::exception {
-		virtual const char* what() const noexcept { return "HEUREKA"; }
-	};
+	bool found = false;
 
-	std::optional<std::vector<const Command*>> get_path(const Program& program) {
-		try {
-			program.accept(*this);
-		} catch (Heureka) {
+	std::optional<std::vector<const Command*>> get_path(const ParentIndex& index) {
+		// only the function containing 'end' contributes to the path
+		if (index.contains(end)) {
+			assert(index[end].function);
+			index[end].function->accept(*this);
+		}
+		if (found) {
 			return this->path;
 		}
 		return std::nullopt;
 	}
 
-	std::vector<const Command*> get_path_or_raise(const Program& program) {
-		auto path_opt = get_path(program);
+	std::vector<const Command*> get_path_or_raise(const ParentIndex& index) {
+		auto path_opt = get_path(index);
 		if (path_opt.has_value()) {
 			return *path_opt;
 		} else {
@@ -403,15 +253,11 @@ struct InsertionLocationFinderVisitor final : public Visitor {
 		}
 	}
 
-	std::vector<const Statement*> get_full_path_or_raise(const Program& program) {
-		get_path_or_raise(program);
+	std::vector<const Statement*> get_full_path_or_raise(const ParentIndex& index) {
+		get_path_or_raise(index);
 		return full_path;
 	}
 
-	void abort() {
-		throw Heureka();
-	}
-
 	void visit(const VariableDeclaration& /*node*/) override { throw std::logic_error("Unexpected invocation: InsertionLocationFinderVisitor::visit(const VariableDeclaration&)"); }
 	void visit(const Expression& /*node*/) override { throw std::logic_error("Unexpected invocation: InsertionLocationFinderVisitor::visit(const Expression&)"); }
 	void visit(const BooleanValue& /*node*/) override { throw std::logic_error("Unexpected invocation: InsertionLocationFinderVisitor::visit(const BooleanValue&)"); }
@@ -470,7 +316,7 @@ struct InsertionLocationFinderVisitor final : public Visitor {
 	}
 	void visit(const Assume& assume) override {
 		assert(assume.expr);
-		if (on_path && !is_expression_local(*assume.expr)) {
+		if (on_path && !expressions[*assume.expr].is_local) {
 			path.push_back(&assume);
 		}
 		if (on_path) {
@@ -482,25 +328,28 @@ struct InsertionLocationFinderVisitor final : public Visitor {
 		// handle first
 		assert(seq.first);
 		if (seq.first.get() == &this->end) {
-			abort();
-		} else {
-			seq.first->accept(*this);
+			found = true;
+			return;
+		}
+		seq.first->accept(*this);
+		if (found) {
+			return;
 		}
 		// handle second
 		assert(seq.second);
 		if (seq.second.get() == &this->end) {
-			abort();
-		} else {
-			seq.second->accept(*this);
+			found = true;
+			return;
 		}
+		seq.second->accept(*this);
 	}
 	void visit(const Scope& scope) override {
 		assert(scope.body);
 		if (scope.body.get() == &this->end) {
-			abort();
-		} else {
-			scope.body->accept(*this);
+			found = true;
+			return;
 		}
+		scope.body->accept(*this);
 	}
 	void visit(const Atomic& node) override {
 		assert(node.body);
@@ -514,6 +363,9 @@ struct InsertionLocationFinderVisitor final : public Visitor {
 		for (const auto& branch : node.branches) {
 			assert(branch);
 			branch->accept(*this);
+			if (found) {
+				return;
+			}
 
 			path = copy_path;
 			full_path = copy_full_path;
@@ -534,6 +386,9 @@ struct InsertionLocationFinderVisitor final : public Visitor {
 		
 		assert(node.body);
 		node.body->accept(*this);
+		if (found) {
+			return;
+		}
 
 		path = std::move(copy_path);
 		on_path = copy_on;
@@ -554,6 +409,9 @@ struct InsertionLocationFinderVisitor final : public Visitor {
 		
 		assert(node.body);
 		node.body->accept(*this);
+		if (found) {
+			return;
+		}
 
 		path = std::move(copy_path);
 		on_path = copy_on;
@@ -569,14 +427,7 @@ struct InsertionLocationFinderVisitor final : public Visitor {
 		assert(function.body);
 		function.body->accept(*this);
 	}
-	void visit(const Program& program) override {
-		assert(program.initializer);
-		program.initializer->accept(*this);
-		for (const auto& function : program.functions) {
-			assert(function);
-			function->accept(*this);
-		}
-	}
+	void visit(const Program& /*program*/) override { throw std::logic_error("Unexpected invocation: InsertionLocationFinderVisitor::visit(const Program&)"); }
 };
 
 struct RightMovernessVisitor final : public Visitor {
@@ -584,6 +435,7 @@ struct RightMovernessVisitor final : public Visitor {
 	bool moves = true;
 	const Function& retire_function;
 	std::vector<std::reference_wrapper<const Command>> events;
+	ExpressionTable expressions;
 
 	public:
 	RightMovernessVisitor(const Function& retire) : retire_function(retire) {}
@@ -629,7 +481,7 @@ struct RightMovernessVisitor final : public Visitor {
 	void visit(const Loop& /*node*/) override { throw RefinementError("Unsupported construct: loop"); }
 
 	void visit(const Assume& node) override {
-		if (!is_expression_local(*node.expr)) {
+		if (!expressions[*node.expr].is_local) {
 			this->moves = false;
 		}
 	}
@@ -646,7 +498,7 @@ struct RightMovernessVisitor final : public Visitor {
 		}
 	}
 	void visit(const Assignment& node) override {
-		if (!is_expression_local(*node.lhs) || !is_expression_local(*node.rhs)) {
+		if (!expressions[*node.lhs].is_local || !expressions[*node.rhs].is_local) {
 			this->moves = false;
 		}
 	}
@@ -694,11 +546,11 @@ std::unique_ptr<Statement> make_sequence_from_path(std::vector<const Statement*>
 }
 
 
-void try_fix_local_unsafe_assume(Program& program, const SmrObserverStore& observer_store, const UnsafeAssumeError& error) {
+void try_fix_local_unsafe_assume(Program& program, ParentIndex& index, const SmrObserverStore& observer_store, const UnsafeAssumeError& error) {
 	std::cout << "Trying to remove local unsafe assume by moving it to an earlier program location." << std::endl;
 
 	InsertionLocationFinderVisitor visitor(collect_variables(*error.pc.expr), error.pc);
-	auto path = visitor.get_path_or_raise(program);
+	auto path = visitor.get_path_or_raise(index);
 	conditionally_raise_error<RefinementError>(path.size() == 0, "could not find locations to move assume to; cannot recover");
 
 	std::cout << "Promising control flow locations for moving assume statement to: " << std::endl;
@@ -708,6 +560,7 @@ void try_fix_local_unsafe_assume(Program& program, const SmrObserverStore& obser
 	}
 
 	for (auto it = path.begin(); it != path.end(); ++it) {
+		check_deadline(); // every candidate may cost a CAVE query
 		const bool no_check = (it+1 == path.end()) && !CHECK_SINGLETON_PATH;
 		if (no_check) {
 			std::cout << "Moving assume here: ";
@@ -720,7 +573,7 @@ void try_fix_local_unsafe_assume(Program& program, const SmrObserverStore& obser
 
 		// try to insert assertion in path; move assume if possible
 		try {
-			auto visitor = insert_active_assertion(program, observer_store, **it, error.var, true /* insert after */, no_check);
+			auto visitor = insert_active_assertion(program, index, observer_store, **it, error.var, true /* insert after */, no_check);
 			if (!no_check) {
 				std::cout << " ==> inserting assertion here" << std::endl;
 			}
@@ -744,14 +597,12 @@ void try_fix_local_unsafe_assume(Program& program, const SmrObserverStore& obser
 			auto assume = std::make_unique<Assume>(std::make_unique<BinaryExpression>(BinaryExpression::Operator::EQ, std::make_unique<VariableExpression>(tmp), std::make_unique<BooleanValue>(true)));
 
 			// add new assume, replace old assume with an assertion with the same condition (to maintain type information gained by assume)
-			AssertionInsertionVisitor insert_assume_visitor(error.pc, std::move(assume), false /* insert before */);
-			program.accept(insert_assume_visitor);
+			auto insert_assume_visitor = insert_statement(index, error.pc, std::move(assume), false /* insert before */);
 			assert(insert_assume_visitor.owner_found);
-			*insert_assume_visitor.owner_found = std::make_unique<Assert>(std::make_unique<InvariantExpression>(cola::copy(*error.pc.expr)));
+			insert_assume_visitor.replace(index, *insert_assume_visitor.owner_found, std::make_unique<Assert>(std::make_unique<InvariantExpression>(cola::copy(*error.pc.expr))));
 
 			// insert update of tmp
-			AssertionInsertionVisitor insert_update_visitor(*static_cast<Command*>(visitor.inserted), std::move(choice), true);
-			program.accept(insert_update_visitor);
+			insert_statement(index, *static_cast<Command*>(visitor.inserted), std::move(choice), true);
 
 			// done
 			return;
@@ -771,11 +622,11 @@ std::string expr_to_string(const Expression& expr) {
 	return result.str();
 }
 
-void try_remove_unsafe_assume(Program& program, const SmrObserverStore& observer_store, const UnsafeAssumeError& error) {
+void try_remove_unsafe_assume(ParentIndex& index, const SmrObserverStore& observer_store, const UnsafeAssumeError& error) {
 	std::cout << "Trying to remove unsafe assume statement by repeating commands." << std::endl;
 
 	InsertionLocationFinderVisitor visitor(collect_variables(*error.pc.expr), error.pc);
-	auto full_path = visitor.get_full_path_or_raise(program);
+	auto full_path = visitor.get_full_path_or_raise(index);
 	conditionally_raise_error<RefinementError>(full_path.size() == 0, "could not find commands to be repeated");
 
 	std::cout << "Commands to be repeated: " << std::endl;
@@ -851,20 +702,19 @@ void try_remove_unsafe_assume(Program& program, const SmrObserverStore& observer
 
 	// copy full path and add after offending assume, add active assertion for offending variable
 	auto new_code = make_sequence_from_path(full_path);
-	AssertionInsertionVisitor insertion(error.pc, std::move(new_code), true /* insert after */);
-	program.accept(insertion);
+	auto insertion = insert_statement(index, error.pc, std::move(new_code), true /* insert after */);
 
 	// delete offending assume 
-	*insertion.owner_found = std::make_unique<Skip>();
+	insertion.replace(index, *insertion.owner_found, std::make_unique<Skip>());
 	std::cout << " ==> replaced unsafe assume with a repetition of the commands" << std::endl;
 }
 
-void try_fix_nonlocal_unsafe_assume(Program& program, const SmrObserverStore& observer_store, const UnsafeAssumeError& error) {
+void try_fix_nonlocal_unsafe_assume(Program& program, ParentIndex& index, const SmrObserverStore& observer_store, const UnsafeAssumeError& error) {
 	std::cout << "Trying to fix unsafe assume statement by inserting an appropriate assertion earlier in the program." << std::endl;
 	std::cout << "(Beware, this might not fix the problem but I cannot check this)" << std::endl;
 
 	InsertionLocationFinderVisitor visitor(collect_variables(*error.pc.expr), error.pc);
-	auto path = visitor.get_path_or_raise(program);
+	auto path = visitor.get_path_or_raise(index);
 	conditionally_raise_error<RefinementError>(path.size() == 0, "could not find locations to insert assertions; cannot recover");
 
 	std::cout << "Promising control flow locations for assertion insertion: " << std::endl;
@@ -874,6 +724,7 @@ void try_fix_nonlocal_unsafe_assume(Program& program, const SmrObserverStore& ob
 	}
 
 	for (auto it = path.begin(); it != path.end(); ++it) {
+		check_deadline();
 		const bool no_check = (it+1 == path.end()) && !CHECK_SINGLETON_PATH;
 		if (no_check) {
 			std::cout << "Inserting assertion here: ";
@@ -886,7 +737,7 @@ void try_fix_nonlocal_unsafe_assume(Program& program, const SmrObserverStore& ob
 
 		// try to insert assertion in path; move assume if possible
 		try {
-			insert_active_assertion(program, observer_store, **it, error.var, true /* insert after */, no_check);
+			insert_active_assertion(program, index, observer_store, **it, error.var, true /* insert after */, no_check);
 			if (!no_check) {
 				std::cout << " ==> inserting assertion here" << std::endl;
 			}
@@ -902,11 +753,11 @@ void try_fix_nonlocal_unsafe_assume(Program& program, const SmrObserverStore& ob
 	raise_error<RefinementError>("could not infer valid move to try fix pointer race");
 }
 
-void try_fix_local_unsafe_dereference(Program& program, const SmrObserverStore& observer_store, const UnsafeDereferenceError& error) {
+void try_fix_local_unsafe_dereference(Program& program, ParentIndex& index, const SmrObserverStore& observer_store, const UnsafeDereferenceError& error) {
 	std::cout << "Trying to fix unsafe dereference of local pointer by inserting an appropriate assertion earlier in the program." << std::endl;
 
 	InsertionLocationFinderVisitor visitor({ &error.var }, error.pc);
-	auto path = visitor.get_path_or_raise(program);
+	auto path = visitor.get_path_or_raise(index);
 	conditionally_raise_error<RefinementError>(path.size() == 0, "could not find locations to insert assertions; cannot recover");
 
 	std::cout << "Promising control flow locations for assertion insertion: " << std::endl;
@@ -916,6 +767,7 @@ void try_fix_local_unsafe_dereference(Program& program, const SmrObserverStore&
 	}
 
 	for (auto it = path.begin(); it != path.end(); ++it) {
+		check_deadline();
 		const bool no_check = (it+1 == path.end()) && !CHECK_SINGLETON_PATH;
 		if (no_check) {
 			std::cout << "Inserting assertion here: ";
@@ -928,7 +780,7 @@ void try_fix_local_unsafe_dereference(Program& program, const SmrObserverStore&
 
 		// try to insert assertion in path; move assume if possible
 		try {
-			insert_active_assertion(program, observer_store, **it, error.var, true /* insert after */, no_check);
+			insert_active_assertion(program, index, observer_store, **it, error.var, true /* insert after */, no_check);
 			if (!no_check) {
 				std::cout << " ==> inserting assertion here" << std::endl;
 			}
@@ -946,9 +798,11 @@ void try_fix_local_unsafe_dereference(Program& program, const SmrObserverStore&
 
 
 void prtypes::try_fix_pointer_race(Program& program, const SmrObserverStore& observer_store, const UnsafeAssumeError& error, bool avoid_reoffending) {
+	TraceScope trace("rewrite", "fix unsafe assume");
+	ParentIndex index(program);
 	try {
 		// insert assertion for offending command
-		insert_active_assertion(program, observer_store, error.pc, error.var);
+		insert_active_assertion(program, index, observer_store, error.pc, error.var);
 		std::cout << " ==> inserted active assertion for variable '" << error.var.name << "'" << std::endl;
 
 	} catch (RefinementError err) {
@@ -959,16 +813,16 @@ void prtypes::try_fix_pointer_race(Program& program, const SmrObserverStore& obs
 		// try to move the offending assertion
 		assert(error.pc.expr);
 		if (is_expression_local(*error.pc.expr)) {
-			try_fix_local_unsafe_assume(program, observer_store, error);
+			try_fix_local_unsafe_assume(program, index, observer_store, error);
 		} else {
 			try {
-				try_remove_unsafe_assume(program, observer_store, error);
+				try_remove_unsafe_assume(index, observer_store, error);
 			} catch (RefinementError suberr) {
 				if (avoid_reoffending) {
 					throw std::move(suberr);
 				} else {
 					std::cout << suberr.what() << std::endl;
-					try_fix_nonlocal_unsafe_assume(program, observer_store, error);
+					try_fix_nonlocal_unsafe_assume(program, index, observer_store, error);
 				}
 			}
 		}
@@ -977,11 +831,13 @@ void prtypes::try_fix_pointer_race(Program& program, const SmrObserverStore& obs
 }
 
 void prtypes::try_fix_pointer_race(cola::Program& program, const SmrObserverStore& observer_store, const UnsafeCallError& error) {
+	TraceScope trace("rewrite", "fix unsafe call");
+	ParentIndex index(program);
 	if (&error.pc.decl == &observer_store.retire_function) {
 		assert(error.pc.args.size() == 1);
 		assert(error.pc.args.at(0));
 		const VariableExpression& expr = *static_cast<const VariableExpression*>(error.pc.args.at(0).get()); // TODO: unhack this
-		insert_active_assertion(program, observer_store, error.pc, expr.decl);
+		insert_active_assertion(program, index, observer_store, error.pc, expr.decl);
 		std::cout << " ==> inserted active assertion for variable '" << expr.decl.name << "'" << std::endl;
 
 	} else {
@@ -990,9 +846,11 @@ void prtypes::try_fix_pointer_race(cola::Program& program, const SmrObserverStor
 }
 
 void prtypes::try_fix_pointer_race(cola::Program& program, const SmrObserverStore& observer_store, const UnsafeDereferenceError& error) {
+	TraceScope trace("rewrite", "fix unsafe dereference");
+	ParentIndex index(program);
 	try {
 		// insert assertion for offending command
-		insert_active_assertion(program, observer_store, error.pc, error.var);
+		insert_active_assertion(program, index, observer_store, error.pc, error.var);
 		std::cout << " ==> inserted active assertion for variable '" << error.var.name << "'" << std::endl;
 
 	} catch (RefinementError err) {
@@ -1002,7 +860,7 @@ void prtypes::try_fix_pointer_race(cola::Program& program, const SmrObserverStor
 
 		if (!error.var.is_shared) {
 			// dereferences of local pointers should be guarded by SMR; try find earlier point where it is safe
-			try_fix_local_unsafe_dereference(program, observer_store, error);
+			try_fix_local_unsafe_dereference(program, index, observer_store, error);
 		} else {
 			throw std::move(err);
 		}
@@ -2,6 +2,8 @@
 #include "types/util.hpp"
 #include "types/error.hpp"
 #include "types/assumption.hpp"
+#include "types/deadline.hpp"
+#include "cola/trace.hpp"
 #include "z3++.h"
 #include <set>
 #include <string>
@@ -176,7 +178,7 @@ std::vector<const State*> abstract_post(const Observer& observer, const State& t
 
 			translation.solver.push();
 			translation.solver.add(trans_enc);
-			auto check_result = translation.solver.check();
+			auto check_result = check_within_deadline(translation.solver);
 			translation.solver.pop();
 
 			switch (check_result) {
@@ -191,7 +193,7 @@ std::vector<const State*> abstract_post(const Observer& observer, const State& t
 					if (!definitely_has_post) {
 						translation.solver.push();
 						translation.solver.add(!trans_enc);
-						auto check_post_result = translation.solver.check();
+						auto check_post_result = check_within_deadline(translation.solver);
 						translation.solver.pop();
 						definitely_has_post |= (check_post_result == z3::unsat);
 					}
@@ -282,6 +284,7 @@ bool simulation_holds(const Observer& observer, const SimulationEngine::Simulati
 // }
 
 void SimulationEngine::compute_simulation(const Observer& observer) {
+	TraceScope trace("observer", "simulation");
 	prtypes::raise_if_assumption_unsatisfied(observer);
 	SimulationEngine::SimulationRelation result;
 
@@ -0,0 +1,237 @@
+#include "types/slice.hpp"
+#include <stdexcept>
+
+using namespace cola;
+using namespace prtypes;
+
+
+struct ExpressionVariableVisitor final : public Visitor {
+	std::set<const VariableDeclaration*> variables;
+	bool has_dereference = false;
+
+	void visit(const VariableDeclaration& node) override { variables.insert(&node); }
+	void visit(const BooleanValue& /*node*/) override { /* do nothing */ }
+	void visit(const NullValue& /*node*/) override { /* do nothing */ }
+	void visit(const EmptyValue& /*node*/) override { /* do nothing */ }
+	void visit(const MaxValue& /*node*/) override { /* do nothing */ }
+	void visit(const MinValue& /*node*/) override { /* do nothing */ }
+	void visit(const NDetValue& /*node*/) override { /* do nothing */ }
+	void visit(const VariableExpression& node) override { variables.insert(&node.decl); }
+	void visit(const NegatedExpression& node) override { node.expr->accept(*this); }
+	void visit(const BinaryExpression& node) override { node.lhs->accept(*this); node.rhs->accept(*this); }
+	void visit(const Dereference& node) override { has_dereference = true; node.expr->accept(*this); }
+	void visit(const InvariantExpression& node) override { node.expr->accept(*this); }
+	void visit(const InvariantActive& node) override { node.expr->accept(*this); }
+	void visit(const CompareAndSwap& node) override {
+		has_dereference = true;
+		for (const auto& elem : node.elems) {
+			elem.dst->accept(*this);
+			elem.cmp->accept(*this);
+			elem.src->accept(*this);
+		}
+	}
+
+	void visit(const Expression& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Expression&)"); }
+	void visit(const Sequence& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Sequence&)"); }
+	void visit(const Scope& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Scope&)"); }
+	void visit(const Atomic& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Atomic&)"); }
+	void visit(const Choice& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Choice&)"); }
+	void visit(const IfThenElse& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const IfThenElse&)"); }
+	void visit(const Loop& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Loop&)"); }
+	void visit(const While& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const While&)"); }
+	void visit(const Skip& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Skip&)"); }
+	void visit(const Break& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Break&)"); }
+	void visit(const Continue& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Continue&)"); }
+	void visit(const Assume& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Assume&)"); }
+	void visit(const Assert& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Assert&)"); }
+	void visit(const AngelChoose& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const AngelChoose&)"); }
+	void visit(const AngelActive& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const AngelActive&)"); }
+	void visit(const AngelContains& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const AngelContains&)"); }
+	void visit(const Return& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Return&)"); }
+	void visit(const Malloc& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Malloc&)"); }
+	void visit(const Assignment& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Assignment&)"); }
+	void visit(const Enter& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Enter&)"); }
+	void visit(const Exit& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Exit&)"); }
+	void visit(const Macro& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Macro&)"); }
+	void visit(const Function& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Function&)"); }
+	void visit(const Program& /*node*/) override { throw std::logic_error("Unexpected invocation: ExpressionVariableVisitor::visit(const Program&)"); }
+};
+
+
+struct RelevanceVisitor final : public Visitor {
+	struct Candidate {
+		const Assignment& assignment;
+		const VariableDeclaration& lhs;
+		std::set<const VariableDeclaration*> rhs;
+		Candidate(const Assignment& assignment, const VariableDeclaration& lhs, std::set<const VariableDeclaration*> rhs) : assignment(assignment), lhs(lhs), rhs(std::move(rhs)) {}
+	};
+
+	const std::set<const Assert*>* whitelist;
+	std::set<const VariableDeclaration*> declared;
+	std::set<const VariableDeclaration*> relevant;
+	std::vector<Candidate> candidates;
+
+	RelevanceVisitor(const std::set<const Assert*>* whitelist) : whitelist(whitelist) {}
+
+	template<typename T>
+	ExpressionVariableVisitor collect(const T& expr) {
+		ExpressionVariableVisitor visitor;
+		expr.accept(visitor);
+		return visitor;
+	}
+
+	template<typename T>
+	void mark_relevant(const T& expr) {
+		auto variables = collect(expr).variables;
+		relevant.insert(variables.begin(), variables.end());
+	}
+
+	void handle_declaration(const VariableDeclaration& decl) {
+		declared.insert(&decl);
+		if (decl.type.sort == Sort::PTR) {
+			relevant.insert(&decl);
+		}
+	}
+
+	void visit(const VariableDeclaration& /*node*/) override { throw std::logic_error("Unexpected invocation: RelevanceVisitor::visit(const VariableDeclaration&)"); }
+	void visit(const Expression& /*node*/) override { throw std::logic_error("Unexpected invocation: RelevanceVisitor::visit(const Expression&)"); }
+	void visit(const BooleanValue& /*node*/) override { throw std::logic_error("Unexpected invocation: RelevanceVisitor::visit(const BooleanValue&)"); }
+	void visit(const NullValue& /*node*/) override { throw std::logic_error("Unexpected invocation: RelevanceVisitor::visit(const NullValue&)"); }
+	void visit(const EmptyValue& /*node*/) override { throw std::logic_error("Unexpected invocation: RelevanceVisitor::visit(const EmptyValue&)"); }
+	void visit(const MaxValue& /*node*/) override { throw std::logic_error("Unexpected invocation: RelevanceVisitor::visit(const MaxValue&)"); }
+	void visit(const MinValue& /*node*/) override { throw std::logic_error("Unexpected invocation: RelevanceVisitor::visit(const MinValue&)"); }
+	void visit(const NDetValue& /*node*/) override { throw std::logic_error("Unexpected invocation: RelevanceVisitor::visit(const NDetValue&)"); }
+	void visit(const VariableExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: RelevanceVisitor::visit(const VariableExpression&)"); }
+	void visit(const NegatedExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: RelevanceVisitor::visit(const NegatedExpression&)"); }
+	void visit(const BinaryExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: RelevanceVisitor::visit(const BinaryExpression&)"); }
+	void visit(const Dereference& /*node*/) override { throw std::logic_error("Unexpected invocation: RelevanceVisitor::visit(const Dereference&)"); }
+	void visit(const InvariantExpression& /*node*/) override { throw std::logic_error("Unexpected invocation: RelevanceVisitor::visit(const InvariantExpression&)"); }
+	void visit(const InvariantActive& /*node*/) override { throw std::logic_error("Unexpected invocation: RelevanceVisitor::visit(const InvariantActive&)"); }
+
+	void visit(const Sequence& node) override { node.first->accept(*this); node.second->accept(*this); }
+	void visit(const Scope& node) override {
+		for (const auto& decl : node.variables) {
+			handle_declaration(*decl);
+		}
+		node.body->accept(*this);
+	}
+	void visit(const Atomic& node) override { node.body->accept(*this); }
+	void visit(const Choice& node) override {
+		for (const auto& branch : node.branches) {
+			branch->accept(*this);
+		}
+	}
+	void visit(const IfThenElse& node) override {
+		mark_relevant(*node.expr);
+		node.ifBranch->accept(*this);
+		node.elseBranch->accept(*this);
+	}
+	void visit(const Loop& node) override { node.body->accept(*this); }
+	void visit(const While& node) override {
+		mark_relevant(*node.expr);
+		node.body->accept(*this);
+	}
+	void visit(const Skip& /*node*/) override { /* do nothing */ }
+	void visit(const Break& /*node*/) override { /* do nothing */ }
+	void visit(const Continue& /*node*/) override { /* do nothing */ }
+	void visit(const Assume& node) override { mark_relevant(*node.expr); }
+	void visit(const Assert& node) override {
+		if (!whitelist || whitelist->count(&node) > 0) {
+			mark_relevant(*node.inv);
+		}
+	}
+	void visit(const AngelChoose& /*node*/) override { /* do nothing */ }
+	void visit(const AngelActive& /*node*/) override { /* do nothing */ }
+	void visit(const AngelContains& node) override { relevant.insert(&node.var); }
+	void visit(const Return& node) override {
+		if (node.expr) {
+			mark_relevant(*node.expr);
+		}
+	}
+	void visit(const Malloc& node) override { relevant.insert(&node.lhs); }
+	void visit(const Assignment& node) override {
+		auto lhs = collect(*node.lhs);
+		auto rhs = collect(*node.rhs);
+		bool is_candidate = !lhs.has_dereference && !rhs.has_dereference && lhs.variables.size() == 1 && node.lhs->sort() != Sort::PTR;
+		if (is_candidate) {
+			candidates.emplace_back(node, **lhs.variables.begin(), std::move(rhs.variables));
+		} else {
+			relevant.insert(lhs.variables.begin(), lhs.variables.end());
+			relevant.insert(rhs.variables.begin(), rhs.variables.end());
+		}
+	}
+	void visit(const Enter& node) override {
+		for (const auto& arg : node.args) {
+			mark_relevant(*arg);
+		}
+	}
+	void visit(const Exit& /*node*/) override { /* do nothing */ }
+	void visit(const Macro& node) override {
+		for (const auto& arg : node.args) {
+			mark_relevant(*arg);
+		}
+	}
+	void visit(const CompareAndSwap& node) override {
+		for (const auto& elem : node.elems) {
+			mark_relevant(*elem.dst);
+			mark_relevant(*elem.cmp);
+			mark_relevant(*elem.src);
+		}
+	}
+
+	void visit(const Function& function) override {
+		for (const auto& decl : function.args) {
+			// arguments are part of the signature
+			relevant.insert(decl.get());
+		}
+		if (function.body) {
+			function.body->accept(*this);
+		}
+	}
+
+	void visit(const Program& program) override {
+		for (const auto& decl : program.variables) {
+			handle_declaration(*decl);
+		}
+		program.initializer->accept(*this);
+		for (const auto& function : program.functions) {
+			if (function->kind != Function::SMR) {
+				function->accept(*this);
+			}
+		}
+	}
+
+	void compute_fixed_point() {
+		bool changed = true;
+		while (changed) {
+			changed = false;
+			for (const auto& candidate : candidates) {
+				if (relevant.count(&candidate.lhs) == 0) {
+					continue;
+				}
+				for (const auto* decl : candidate.rhs) {
+					changed |= relevant.insert(decl).second;
+				}
+			}
+		}
+	}
+};
+
+CaveSlice prtypes::compute_cave_slice(const Program& program, const std::set<const Assert*>* whitelist) {
+	RelevanceVisitor visitor(whitelist);
+	program.accept(visitor);
+	visitor.compute_fixed_point();
+
+	CaveSlice result;
+	for (const auto& candidate : visitor.candidates) {
+		if (visitor.relevant.count(&candidate.lhs) == 0) {
+			result.assignments.insert(&candidate.assignment);
+		}
+	}
+	for (const auto* decl : visitor.declared) {
+		if (visitor.relevant.count(decl) == 0) {
+			result.variables.insert(decl);
+		}
+	}
+	return result;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#ifndef PRTYPES_SLICE
+#define PRTYPES_SLICE
+
+#include "cola/ast.hpp"
+#include <set>
+
+
+namespace prtypes {
+
+	/** Parts of a program that are irrelevant for the CAVE memory safety check, i.e., that influence neither
+	  * the pointer shape, nor control flow, nor any (whitelisted) assertion. The translation to CAVE omits them.
+	  */
+	struct CaveSlice {
+		std::set<const cola::Assignment*> assignments;
+		std::set<const cola::VariableDeclaration*> variables;
+
+		bool is_sliced(const cola::Assignment& assignment) const { return assignments.count(&assignment) > 0; }
+		bool is_sliced(const cola::VariableDeclaration& variable) const { return variables.count(&variable) > 0; }
+	};
+
+	/** Computes the assignments/variables that can be dropped from the CAVE input.
+	  * Only assignments to non-pointer variables whose value never flows (transitively) into a pointer,
+	  * a condition (assume, if, while), a return value, a call argument, or an assertion in 'whitelist'
+	  * (all assertions if 'whitelist' is 'nullptr') are sliced. Assignments containing dereferences are kept
+	  * since CAVE checks them for memory safety.
+	  */
+	CaveSlice compute_cave_slice(const cola::Program& program, const std::set<const cola::Assert*>* whitelist=nullptr);
+
+} // namespace prtypes
+
+#endif
@@ -5,6 +5,8 @@
 #include <list>
 #include "types/error.hpp"
 #include "types/assumption.hpp"
+#include "types/deadline.hpp"
+#include "cola/trace.hpp"
 
 using namespace cola;
 using namespace prtypes;
@@ -61,15 +63,44 @@ class CombinationMaker {
 };
 
 
+//
+// tracking solver
+//
+TrackingSolver::TrackingSolver(z3::context& context) : _solver(context) {
+}
+
+z3::expr TrackingSolver::track(const z3::expr& formula) {
+	auto id = formula.id();
+	auto find = _literals.find(id);
+	if (find != _literals.end()) {
+		return find->second;
+	}
+	// the assertion keeps 'formula' alive, so its id is not reused
+	std::string name = "__track_" + std::to_string(id);
+	z3::expr literal = _solver.ctx().bool_const(name.c_str());
+	_solver.add(z3::implies(literal, formula));
+	_literals.emplace(id, literal);
+	return literal;
+}
+
+z3::check_result TrackingSolver::check(const std::vector<z3::expr>& formulas) {
+	z3::expr_vector assumptions(_solver.ctx());
+	for (const auto& formula : formulas) {
+		assumptions.push_back(track(formula));
+	}
+	return check_within_deadline(_solver, assumptions);
+}
+
+
 //
 // common helpers
 //
 struct Context {
 	const SymbolicObserver& observer;
 	z3::context& context;
-	z3::solver& solver;
+	TrackingSolver& solver;
 
-	Context(SymbolicObserver& observer, z3::context& context, z3::solver& solver) : observer(observer), context(context), solver(solver) {}
+	Context(SymbolicObserver& observer, z3::context& context, TrackingSolver& solver) : observer(observer), context(context), solver(solver) {}
 };
 
 inline bool could_be_sat(z3::check_result result) {
@@ -121,11 +152,7 @@ inline bool has_nonempty_intersection(const std::vector<const State*>& states, c
 // SymbolicObserver construction
 //
 inline bool needs_closure(Context context, const SymbolicTransition& transition) {
-	context.solver.push();
-	context.solver.add(transition.guard);
-	context.solver.add(context.observer.selfparam != context.observer.threadvar);
-	auto check_result = context.solver.check();
-	context.solver.pop();
+	auto check_result = context.solver.check({ transition.guard, context.observer.selfparam != context.observer.threadvar });
 	return could_be_sat(check_result);
 }
 
@@ -277,9 +304,7 @@ inline std::map<const State*, std::list<HalfWaySymbolicTransition>> make_complet
 
 			// add transition completion (if necessary)
 			z3::expr remaining_guard = z3::mk_and(remaining);
-			context.solver.push();
-			auto check_result = context.solver.check();
-			context.solver.pop();
+			auto check_result = context.solver.check({});
 			if (could_be_sat(check_result)) {
 				transitions.emplace_back(*state, *label, kind, remaining_guard);
 			}
@@ -371,7 +396,7 @@ struct CrossProductMaker {
 			while (combinator.available()) {
 				// compute possible transition in cross product
 				std::vector<const HalfWaySymbolicTransition*> combination = combinator.get_next();
-				z3::expr_vector guards(context.context);
+				std::vector<z3::expr> guards;
 				std::vector<const State*> post;
 				for (const HalfWaySymbolicTransition* transition : combination) {
 					guards.push_back(transition->guard);
@@ -379,14 +404,16 @@ struct CrossProductMaker {
 				}
 
 				// check if new transition is required (guard sat?)
-				z3::expr new_guard = z3::mk_and(guards);
-				context.solver.push();
-				context.solver.add(new_guard);
-				auto check_result = context.solver.check();
-				context.solver.pop();
+				// the guards are checked separately, they recur across combinations
+				auto check_result = context.solver.check(guards);
 				
 				if (could_be_sat(check_result)) {
 					// add new transition
+					z3::expr_vector conjuncts(context.context);
+					for (const auto& guard : guards) {
+						conjuncts.push_back(guard);
+					}
+					z3::expr new_guard = z3::mk_and(conjuncts);
 					SymbolicState& post_state = *add_or_get_state(std::move(post));
 					state.transitions.push_back(std::make_unique<SymbolicTransition>(post_state, *label, kind, new_guard));
 				}
@@ -486,6 +513,7 @@ inline std::vector<std::unique_ptr<SymbolicState>> make_states(const SmrObserver
 		}
 	}
 
+	TraceScope trace("observer", "cross product");
 	CrossProductMaker maker(store, context, active_states);
 	maker.compute_cross_product();
 	return std::move(maker.states);
@@ -506,6 +534,7 @@ SymbolicObserver::SymbolicObserver(const SmrObserverStore& store) : solver(conte
 	this->states = make_states(store, my_context);
 
 	// compute closures
+	TraceScope trace("observer", "closures");
 	for (auto& state : this->states) {
 		state->closure = compute_closure(my_context, { state.get() });
 	}
@@ -576,23 +605,17 @@ SymbolicStateSet prtypes::symbolic_post(const SymbolicState& state, const Comman
 	auto& observer = state.observer;
 
 	const auto& [label, kind, constraint] = prepare(observer, observer.context, command, variable);
-	observer.solver.push();
-	observer.solver.add(constraint);
 
 	SymbolicStateSet result;
 	for (const auto& transition : state.transitions) {
 		if (matches(*transition, label, kind) && result.count(&transition->dst) == 0) {
-			observer.solver.push();
-			observer.solver.add(transition->guard);
-			auto check_result = observer.solver.check();
-			observer.solver.pop();
+			auto check_result = observer.solver.check({ constraint, transition->guard });
 			if (could_be_sat(check_result)) {
 				result.insert(&transition->dst);
 			}
 		}
 	}
 
-	observer.solver.pop();
 	return result;
 }
 
@@ -3,6 +3,7 @@
 #define PRTYPES_OBSERVER
 
 #include <memory>
+#include <unordered_map>
 #include <vector>
 #include "cola/ast.hpp"
 #include "cola/observer.hpp"
@@ -38,10 +39,30 @@ namespace prtypes {
 		SymbolicState(const SymbolicObserver& observer, bool is_final, bool is_active);
 	};
 
+	/** Solver for many small queries over a recurring set of formulas (guards and command constraints).
+	  * Each formula is asserted once, behind a fresh tracking literal; queries assume the literals of the formulas
+	  * they need instead of pushing and popping them, so that z3 keeps what it learned across queries.
+	  * Formulas are identified by their (hash-consed) z3 AST.
+	  */
+	class TrackingSolver {
+		private:
+			z3::solver _solver;
+			std::unordered_map<unsigned, z3::expr> _literals; // AST id of formula -> tracking literal
+
+			z3::expr track(const z3::expr& formula);
+
+		public:
+			TrackingSolver(z3::context& context);
+
+			/** Checks the conjunction of 'formulas' (see 'check_within_deadline').
+			  */
+			z3::check_result check(const std::vector<z3::expr>& formulas);
+	};
+
 	struct SymbolicObserver {
 		private:
 			mutable z3::context context;
-			mutable z3::solver solver;
+			mutable TrackingSolver solver;
 			friend SymbolicStateSet symbolic_post(const SymbolicState& state, const cola::Command& command, const cola::VariableDeclaration& variable);
 
 		public:
@@ -0,0 +1,453 @@
+#include <memory>
+#include <array>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <filesystem>
+#include "tclap/CmdLine.h"
+
+#include "cola/parse.hpp"
+#include "cola/ast.hpp"
+#include "cola/observer.hpp"
+#include "cola/util.hpp"
+
+#include "types/preprocess.hpp"
+#include "types/rmraces.hpp"
+#include "types/check.hpp"
+#include "types/types.hpp"
+#include "types/cave.hpp"
+
+#include "Generators.hpp"
+#include "Json.hpp"
+
+using namespace TCLAP;
+using namespace cola;
+using namespace prtypes;
+
+using timepoint_t = std::chrono::steady_clock::time_point;
+using duration_t = std::chrono::duration<double, std::milli>;
+
+
+struct BenchConfig {
+	std::size_t repetitions, warmup;
+	bool rewrite_and_retry;
+	bool check_annotations, check_linearizability;
+	bool summarize_macros;
+	ParserFrontend parser;
+	std::string json_path, csv_path;
+} config;
+
+struct BenchPair {
+	std::string program_path, observer_path;
+	bool simple; // no rewriting&retrying upon type errors
+	std::string program_source, observer_source; // generated pairs are parsed from these, paths are labels
+};
+
+enum Phase { PARSE, PREPROCESS, SMR, TYPES, ANNOTATIONS, LINEARIZABILITY, TOTAL, NUMBER_OF_PHASES };
+
+static const std::string PHASE_NAMES[NUMBER_OF_PHASES] = { "parse", "preprocess", "smr", "types", "annotations", "linearizability", "total" };
+
+using Sample = std::array<double, NUMBER_OF_PHASES>; // in ms; negative if the phase did not run
+
+enum Verdict { NONE, SUCCESSFUL, FAILED }; // only checking phases have one
+
+using Verdicts = std::array<Verdict, NUMBER_OF_PHASES>;
+
+static const std::string VERDICT_NAMES[] = { "", "successful", "failed" };
+
+struct Run {
+	Sample sample;
+	Verdicts verdicts;
+};
+
+
+static std::vector<BenchPair> default_pairs(std::string examples) {
+	// the table of benchmark.py
+	std::vector<BenchPair> result;
+	for (std::string name : { "TreiberStack", "TreiberOptimizedStack", "MichaelScottQueue", "DGLM", "VechevDCasSet", "VechevCasSet", "OHearnSet", "MichaelSet" }) {
+		result.push_back({ examples + "/HP/" + name + "_transformed.cola", examples + "/hp.smr", true, "", "" });
+	}
+	for (std::string name : { "TreiberStack", "MichaelScottQueue", "DGLM", "VechevDCasSet", "VechevCasSet", "OHearnSet", "MichaelSet" }) {
+		result.push_back({ examples + "/EBR/" + name + ".cola", examples + "/ebr.smr", false, "", "" });
+	}
+	return result;
+}
+
+static std::vector<BenchPair> scaling_pairs(std::string axis, std::size_t max, synthetic::SmrFamily family) {
+	// vary one parameter, keep the others at their defaults
+	if (axis == "slots") family = synthetic::SmrFamily::HP;
+	if (axis == "epochs") family = synthetic::SmrFamily::EBR;
+	std::string prefix = "synthetic/" + std::string(family == synthetic::SmrFamily::HP ? "hp" : "ebr") + "_" + axis;
+
+	std::vector<BenchPair> result;
+	for (std::size_t value = axis == "locals" ? 2 : 1; value <= max; ++value) {
+		synthetic::ProgramShape shape;
+		std::size_t slots = 2, epochs = 1;
+		if (axis == "functions") shape.functions = value;
+		else if (axis == "depth") shape.depth = value;
+		else if (axis == "locals") shape.locals = value;
+		else if (axis == "calls") shape.calls = value;
+		else if (axis == "slots") slots = value;
+		else if (axis == "epochs") epochs = value;
+
+		BenchPair pair;
+		pair.program_path = prefix + std::to_string(value) + ".cola";
+		pair.observer_path = prefix + std::to_string(value) + ".smr";
+		pair.simple = family == synthetic::SmrFamily::HP; // like the HP examples, generated programs need no rewriting
+		pair.program_source = synthetic::generate_program(shape, family, slots);
+		pair.observer_source = family == synthetic::SmrFamily::HP ? synthetic::generate_hp_observer(slots) : synthetic::generate_ebr_observer(epochs);
+		result.push_back(std::move(pair));
+	}
+	return result;
+}
+
+static void emit_pairs(const std::vector<BenchPair>& pairs, std::string directory) {
+	for (const auto& pair : pairs) {
+		auto program = std::filesystem::path(directory) / std::filesystem::path(pair.program_path).filename();
+		auto observer = std::filesystem::path(directory) / std::filesystem::path(pair.observer_path).filename();
+		std::filesystem::create_directories(directory);
+		std::ofstream(program) << pair.program_source;
+		std::ofstream(observer) << pair.observer_source;
+	}
+}
+
+struct NullBuffer : public std::streambuf {
+	int overflow(int chr) override { return chr; }
+};
+
+struct Stopwatch {
+	timepoint_t begin = std::chrono::steady_clock::now();
+	double lap() {
+		auto now = std::chrono::steady_clock::now();
+		double result = std::chrono::duration_cast<duration_t>(now - begin).count();
+		begin = now;
+		return result;
+	}
+};
+
+template<typename ErrorClass, typename... Targs>
+static bool try_fix(Program& program, const SmrObserverStore& store, const ErrorClass& err, Targs... args) {
+	if (!config.rewrite_and_retry) {
+		return false;
+	}
+	prtypes::try_fix_pointer_race(program, store, err, args...);
+	return true;
+}
+
+static bool type_check_with_rewrites(Program& program, const SmrObserverStore& store, const TypeContext& context) {
+	// same loop as 'seal', without its bookkeeping; rewrite time is part of the type check
+	while (true) {
+		try {
+			return prtypes::type_check(program, context);
+		} catch (const UnsafeCallError& err) {
+			if (!try_fix(program, store, err)) return false;
+		} catch (const UnsafeDereferenceError& err) {
+			if (!try_fix(program, store, err)) return false;
+		} catch (const UnsafeAssumeError& err) {
+			if (!try_fix(program, store, err, false)) return false; // like 'seal', never treated as reoffending
+		}
+	}
+}
+
+static Verdict to_verdict(bool holds) {
+	return holds ? SUCCESSFUL : FAILED;
+}
+
+static Run run_once(const BenchPair& pair) {
+	Sample result;
+	result.fill(-1);
+	Verdicts verdicts;
+	verdicts.fill(NONE);
+	Stopwatch total, watch;
+
+	std::shared_ptr<Program> program;
+	std::vector<std::unique_ptr<Observer>> observers;
+	if (pair.program_source.empty()) {
+		program = cola::parse_program(pair.program_path, config.parser);
+		observers = cola::parse_observer(pair.observer_path, *program, config.parser);
+	} else {
+		std::istringstream program_source(pair.program_source), observer_source(pair.observer_source);
+		program = cola::parse_program(program_source, config.parser);
+		observers = cola::parse_observer(observer_source, *program, config.parser);
+	}
+	result[PARSE] = watch.lap();
+
+	ArenaScope arena_scope(program->arena);
+	const Function& retire = [&]() -> const Function& {
+		for (const auto& function : program->functions) {
+			if (function->name == "retire") return *function;
+		}
+		throw std::logic_error("Failed to find function 'retire'.");
+	}();
+	prtypes::preprocess(*program, retire, !config.summarize_macros);
+	result[PREPROCESS] = watch.lap();
+
+	SmrObserverStore store(*program, retire);
+	for (auto& observer : observers) {
+		store.add_impl_observer(std::move(observer));
+	}
+	TypeContext context(store);
+	result[SMR] = watch.lap();
+
+	bool type_safe = type_check_with_rewrites(*program, store, context);
+	result[TYPES] = watch.lap();
+	verdicts[TYPES] = to_verdict(type_safe);
+
+	if (type_safe && config.check_annotations) {
+		verdicts[ANNOTATIONS] = to_verdict(discharge_assertions(*program, store));
+		result[ANNOTATIONS] = watch.lap();
+	}
+	if (type_safe && config.check_linearizability) {
+		verdicts[LINEARIZABILITY] = to_verdict(prtypes::check_linearizability(*program));
+		result[LINEARIZABILITY] = watch.lap();
+	}
+
+	result[TOTAL] = total.lap();
+	return { result, verdicts };
+}
+
+
+struct Statistics {
+	std::size_t count = 0;
+	double median = 0, p95 = 0, mean = 0, variance = 0, min = 0, max = 0;
+};
+
+static Statistics get_statistics(std::vector<double> values) {
+	Statistics result;
+	result.count = values.size();
+	if (values.empty()) {
+		return result;
+	}
+	std::sort(values.begin(), values.end());
+	std::size_t size = values.size();
+	result.median = size % 2 == 1 ? values.at(size / 2) : (values.at(size / 2 - 1) + values.at(size / 2)) / 2;
+	result.p95 = values.at((std::size_t) std::ceil(0.95 * size) - 1); // nearest rank
+	result.min = values.front();
+	result.max = values.back();
+	for (double value : values) {
+		result.mean += value;
+	}
+	result.mean /= size;
+	for (double value : values) {
+		result.variance += (value - result.mean) * (value - result.mean);
+	}
+	result.variance = size > 1 ? result.variance / (size - 1) : 0; // sample variance
+	return result;
+}
+
+struct PairResult {
+	const BenchPair& pair;
+	std::string error;
+	std::array<Statistics, NUMBER_OF_PHASES> phases;
+	Verdicts verdicts;
+};
+
+static PairResult bench(const BenchPair& pair) {
+	PairResult result{ pair, "", {}, {} };
+	result.verdicts.fill(NONE);
+	std::vector<Sample> samples;
+	config.rewrite_and_retry = !pair.simple;
+	if (config.summarize_macros && config.rewrite_and_retry) {
+		result.error = "Summarizing inline functions requires a simple pair; rewriting needs them inlined.";
+		return result;
+	}
+	try {
+		for (std::size_t index = 0; index < config.warmup + config.repetitions; ++index) {
+			Run run = run_once(pair);
+			if (index > 0 && run.verdicts != result.verdicts) {
+				throw std::logic_error("Verdicts differ between runs.");
+			}
+			result.verdicts = run.verdicts;
+			if (index >= config.warmup) {
+				samples.push_back(run.sample);
+			}
+		}
+	} catch (const std::exception& err) {
+		result.error = err.what();
+		return result;
+	}
+	for (std::size_t phase = 0; phase < NUMBER_OF_PHASES; ++phase) {
+		std::vector<double> values;
+		for (const auto& sample : samples) {
+			if (sample[phase] >= 0) {
+				values.push_back(sample[phase]);
+			}
+		}
+		result.phases[phase] = get_statistics(std::move(values));
+	}
+	return result;
+}
+
+
+static void write_json(const std::vector<PairResult>& results) {
+	std::ofstream file(config.json_path);
+	file << "{" << std::endl;
+	file << "\t\"repetitions\": " << config.repetitions << "," << std::endl;
+	file << "\t\"warmup\": " << config.warmup << "," << std::endl;
+	file << "\t\"unit\": \"ms\"," << std::endl;
+	file << "\t\"results\": [" << std::endl;
+	for (std::size_t index = 0; index < results.size(); ++index) {
+		const auto& result = results.at(index);
+		file << "\t\t{" << std::endl;
+		file << "\t\t\t\"program\": \"" << json::escape(result.pair.program_path) << "\"," << std::endl;
+		file << "\t\t\t\"observer\": \"" << json::escape(result.pair.observer_path) << "\"," << std::endl;
+		if (!result.error.empty()) {
+			file << "\t\t\t\"error\": \"" << json::escape(result.error) << "\"," << std::endl;
+		}
+		file << "\t\t\t\"phases\": {";
+		bool first = true;
+		for (std::size_t phase = 0; phase < NUMBER_OF_PHASES; ++phase) {
+			const auto& stats = result.phases[phase];
+			if (stats.count == 0) {
+				continue;
+			}
+			file << (first ? "" : ",") << std::endl;
+			file << "\t\t\t\t\"" << PHASE_NAMES[phase] << "\": { ";
+			file << "\"count\": " << stats.count << ", \"median\": " << stats.median << ", \"p95\": " << stats.p95 << ", ";
+			file << "\"mean\": " << stats.mean << ", \"variance\": " << stats.variance << ", \"min\": " << stats.min << ", \"max\": " << stats.max;
+			if (result.verdicts[phase] != NONE) {
+				file << ", \"verdict\": \"" << VERDICT_NAMES[result.verdicts[phase]] << "\"";
+			}
+			file << " }";
+			first = false;
+		}
+		file << std::endl << "\t\t\t}" << std::endl;
+		file << "\t\t}" << (index+1 < results.size() ? "," : "") << std::endl;
+	}
+	file << "\t]" << std::endl;
+	file << "}" << std::endl;
+}
+
+static void write_csv(const std::vector<PairResult>& results) {
+	std::ofstream file(config.csv_path);
+	file << "program,observer,phase,count,median_ms,p95_ms,mean_ms,variance_ms2,min_ms,max_ms,verdict" << std::endl;
+	for (const auto& result : results) {
+		for (std::size_t phase = 0; phase < NUMBER_OF_PHASES; ++phase) {
+			const auto& stats = result.phases[phase];
+			if (stats.count == 0) {
+				continue;
+			}
+			file << result.pair.program_path << "," << result.pair.observer_path << "," << PHASE_NAMES[phase] << ",";
+			file << stats.count << "," << stats.median << "," << stats.p95 << "," << stats.mean << "," << stats.variance << "," << stats.min << "," << stats.max << ",";
+			file << VERDICT_NAMES[result.verdicts[phase]] << std::endl;
+		}
+	}
+}
+
+static void print_result(const PairResult& result) {
+	std::cout << std::filesystem::path(result.pair.program_path).filename().string() << " (" << std::filesystem::path(result.pair.observer_path).filename().string() << ")" << std::endl;
+	if (!result.error.empty()) {
+		std::cout << "    error: " << result.error << std::endl;
+		return;
+	}
+	for (std::size_t phase = 0; phase < NUMBER_OF_PHASES; ++phase) {
+		const auto& stats = result.phases[phase];
+		if (stats.count == 0) {
+			continue;
+		}
+		std::stringstream line;
+		line.setf(std::ios::fixed);
+		line.precision(1);
+		line << "    " << PHASE_NAMES[phase] << ": median " << stats.median << "ms, p95 " << stats.p95 << "ms, stddev " << std::sqrt(stats.variance) << "ms";
+		if (result.verdicts[phase] != NONE) {
+			line << ", " << VERDICT_NAMES[result.verdicts[phase]];
+		}
+		std::cout << line.str() << std::endl;
+	}
+}
+
+
+int main(int argc, char** argv) {
+	std::vector<BenchPair> pairs;
+
+	// parse command line arguments
+	try {
+		CmdLine cmd("Benchmark harness for SEAL reporting per-phase timing statistics", ' ', "0.9");
+		ValueArg<std::size_t> repetitions_arg("r", "repetitions", "Number of measured runs per program/observer pair", false, 5, "number", cmd);
+		ValueArg<std::size_t> warmup_arg("w", "warmup", "Number of unmeasured runs per program/observer pair preceding the measured ones", false, 1, "number", cmd);
+		SwitchArg annotation_switch("a", "checkannotations", "Include the annotation check (CAVE)", cmd, false);
+		SwitchArg linearizability_switch("l", "checklinearizability", "Include the linearizability check (CAVE)", cmd, false);
+		std::vector<std::string> parser_values = { "antlr", "native" };
+		ValuesConstraint<std::string> parser_constraint(parser_values);
+		ValueArg<std::string> parser_arg("", "parser", "Parser front end", false, "antlr", &parser_constraint, cmd);
+		std::vector<std::string> macro_values = { "inline", "summarize" };
+		ValuesConstraint<std::string> macro_constraint(macro_values);
+		ValueArg<std::string> macro_arg("", "macros", "Type check calls to 'inline' functions by inlining them or by summaries per call", false, "inline", &macro_constraint, cmd);
+		ValueArg<std::string> examples_arg("", "examples", "Examples folder for the default pairs, those of benchmark.py", false, "examples", "path", cmd);
+		ValueArg<std::string> json_arg("", "json", "Output file for the statistics in JSON", false, "", "path", cmd);
+		ValueArg<std::string> csv_arg("", "csv", "Output file for the statistics in CSV", false, "", "path", cmd);
+		std::vector<std::string> scale_values = { "functions", "depth", "locals", "calls", "slots", "epochs" };
+		ValuesConstraint<std::string> scale_constraint(scale_values);
+		ValueArg<std::string> scale_arg("", "scale", "Instead of the given pairs, run generated programs/observers scaling the given parameter from 1 to '--scalemax'", false, "", &scale_constraint, cmd);
+		ValueArg<std::size_t> scale_max_arg("", "scalemax", "Largest parameter value of a scaling curve", false, 8, "number", cmd);
+		std::vector<std::string> family_values = { "hp", "ebr" };
+		ValuesConstraint<std::string> family_constraint(family_values);
+		ValueArg<std::string> family_arg("", "family", "SMR family of generated programs; implied by scaling 'slots' (HP) and 'epochs' (EBR)", false, "hp", &family_constraint, cmd);
+		ValueArg<std::string> emit_arg("", "emit", "Directory to which generated programs and observers are written", false, "", "path", cmd);
+		SwitchArg simple_switch("s", "simple", "No rewriting&retrying upon type errors for the given pairs", cmd, false);
+		UnlabeledMultiArg<std::string> files_arg("files", "Pairs of program and observer files; defaults to the pairs of benchmark.py", false, "program observer", cmd);
+
+		cmd.parse(argc, argv);
+		config.repetitions = repetitions_arg.getValue();
+		config.warmup = warmup_arg.getValue();
+		config.check_annotations = annotation_switch.getValue();
+		config.check_linearizability = linearizability_switch.getValue();
+		config.parser = parser_arg.getValue() == "native" ? ParserFrontend::NATIVE : ParserFrontend::ANTLR;
+		config.summarize_macros = macro_arg.getValue() == "summarize";
+		config.json_path = json_arg.getValue();
+		config.csv_path = csv_arg.getValue();
+
+		auto files = files_arg.getValue();
+		if (files.size() % 2 != 0) {
+			throw SpecificationException("Files must be given as pairs of program and observer.", "files");
+		}
+		for (std::size_t index = 0; index < files.size(); index += 2) {
+			pairs.push_back({ files.at(index), files.at(index+1), simple_switch.getValue(), "", "" });
+		}
+		if (scale_arg.isSet()) {
+			if (!pairs.empty()) {
+				throw SpecificationException("Scaling curves cannot be combined with given pairs.", "scale");
+			}
+			auto family = family_arg.getValue() == "hp" ? synthetic::SmrFamily::HP : synthetic::SmrFamily::EBR;
+			pairs = scaling_pairs(scale_arg.getValue(), scale_max_arg.getValue(), family);
+			if (emit_arg.isSet()) {
+				emit_pairs(pairs, emit_arg.getValue());
+			}
+		}
+		if (pairs.empty()) {
+			pairs = default_pairs(examples_arg.getValue());
+		}
+		if (config.repetitions == 0) {
+			throw SpecificationException("Number of repetitions must be positive.", "repetitions");
+		}
+		if (config.summarize_macros && (config.check_annotations || config.check_linearizability)) {
+			throw SpecificationException("Annotation and linearizability check need inline functions inlined.", "macros");
+		}
+
+	} catch (ArgException &e) {
+		std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+		return 1;
+	}
+	// end: parse command line arguments
+
+	std::vector<PairResult> results;
+	for (const auto& pair : pairs) {
+		// the library is chatty; its output would dominate the measurement
+		NullBuffer null;
+		auto* buffer = std::cout.rdbuf(&null);
+		results.push_back(bench(pair));
+		std::cout.rdbuf(buffer);
+		print_result(results.back());
+	}
+
+	if (!config.json_path.empty()) {
+		write_json(results);
+	}
+	if (!config.csv_path.empty()) {
+		write_csv(results);
+	}
+	return 0;
+}
@@ -0,0 +1,247 @@
+#include "Generators.hpp"
+#include <sstream>
+#include <algorithm>
+
+using namespace synthetic;
+
+
+struct SourceWriter {
+	std::stringstream stream;
+	std::size_t indent = 0;
+
+	void line(std::string text="") {
+		if (!text.empty()) {
+			stream << std::string(indent, '\t') << text;
+		}
+		stream << std::endl;
+	}
+	void open(std::string text) {
+		line(text + " {");
+		indent++;
+	}
+	void close(std::string text="}") {
+		indent--;
+		line(text);
+	}
+};
+
+inline std::string local(std::size_t index) {
+	return "p" + std::to_string(index);
+}
+
+inline std::string protect(std::size_t slot) {
+	return "protect" + std::to_string(slot + 1);
+}
+
+static void write_unlink(SourceWriter& out, const std::string& ptr, const std::string& next, bool assert_active) {
+	out.line(next + " = " + ptr + "->next;");
+	out.open("atomic");
+	if (assert_active) {
+		out.line("assert(active(Head));");
+	}
+	out.open("if (CAS(Head, " + ptr + ", " + next + "))");
+	out.line("retire(" + ptr + ");");
+	out.line("flag = true;");
+	out.close("} else {");
+	out.indent++;
+	out.line("flag = false;");
+	out.close();
+	out.close();
+	out.open("if (flag)");
+	out.line("result = " + ptr + "->val;");
+	out.close();
+}
+
+static void write_access_hp(SourceWriter& out, const std::string& ptr, const std::string& next, std::size_t slot) {
+	out.line(ptr + " = Head;");
+	out.line(protect(slot) + "(" + ptr + ");");
+	out.open("choose");
+	out.open("atomic");
+	out.line(ptr + " = Head; // atomicity abstraction");
+	out.line("assume(" + ptr + " != NULL);");
+	out.line(protect(slot) + "(" + ptr + ");");
+	out.line("assert(active(" + ptr + "));");
+	out.close();
+	write_unlink(out, ptr, next, true);
+	out.close("}{");
+	out.indent++;
+	out.line("skip;");
+	out.close();
+}
+
+static void write_access_ebr(SourceWriter& out, const std::string& ptr, const std::string& next) {
+	out.line(ptr + " = Head;");
+	out.open("if (" + ptr + " != NULL)");
+	out.line("angel(member(" + ptr + "));");
+	write_unlink(out, ptr, next, false);
+	out.close();
+}
+
+static void write_function(SourceWriter& out, std::size_t index, const ProgramShape& shape, SmrFamily family, std::size_t slots) {
+	std::size_t locals = std::max(shape.locals, (std::size_t) 2);
+	std::string declaration = "Node* ";
+	for (std::size_t var = 0; var < locals; ++var) {
+		declaration += (var == 0 ? "" : ", ") + local(var);
+	}
+
+	out.open("data_t op" + std::to_string(index) + "()");
+	out.line(declaration + ";");
+	out.line("data_t result;");
+	out.line("bool flag;");
+	out.line();
+	if (family == SmrFamily::EBR) {
+		out.open("atomic");
+		out.line("angel(choose active);");
+		out.line("leaveQ();");
+		out.close();
+	}
+	out.line("result = EMPTY;");
+
+	for (std::size_t level = 0; level < shape.depth; ++level) {
+		out.open("while (true)");
+	}
+	for (std::size_t call = 0; call < shape.calls; ++call) {
+		// consecutive accesses use different variables and slots
+		std::string ptr = local((2 * call) % locals);
+		std::string next = local((2 * call + 1) % locals);
+		if (family == SmrFamily::HP) {
+			write_access_hp(out, ptr, next, (index + call) % std::max(slots, (std::size_t) 1));
+		} else {
+			write_access_ebr(out, ptr, next);
+		}
+	}
+	for (std::size_t level = 0; level < shape.depth; ++level) {
+		out.open("choose");
+		out.line("break;");
+		out.close("}{");
+		out.indent++;
+		out.line("skip;");
+		out.close();
+		out.close();
+	}
+
+	if (family == SmrFamily::EBR) {
+		out.line("enterQ();");
+	}
+	out.line("return result;");
+	out.close();
+	out.line();
+}
+
+std::string synthetic::generate_program(const ProgramShape& shape, SmrFamily family, std::size_t slots) {
+	SourceWriter out;
+	std::string smr = family == SmrFamily::HP ? "HP" : "EBR";
+	out.line("#name \"Synthetic " + smr + " program (functions=" + std::to_string(shape.functions) + ", depth=" + std::to_string(shape.depth)
+		+ ", locals=" + std::to_string(shape.locals) + ", calls=" + std::to_string(shape.calls) + ")\"");
+	out.line("#smr \"" + smr + "\"");
+	out.line();
+	out.open("struct Node");
+	out.line("data_t val;");
+	out.line("Node* next;");
+	out.close();
+	out.line();
+	out.line("Node* Head;");
+	out.line();
+	out.line("extern void retire(Node* ptr);");
+	if (family == SmrFamily::HP) {
+		for (std::size_t slot = 0; slot < std::max(slots, (std::size_t) 1); ++slot) {
+			out.line("extern void " + protect(slot) + "(Node* ptr);");
+		}
+	} else {
+		out.line("extern void enterQ();");
+		out.line("extern void leaveQ();");
+	}
+	out.line();
+	out.line();
+	out.open("void init()");
+	out.line("Head = NULL;");
+	out.close();
+	out.line();
+	for (std::size_t index = 0; index < shape.functions; ++index) {
+		write_function(out, index, shape, family, slots);
+	}
+	return out.stream.str();
+}
+
+std::string synthetic::generate_hp_observer(std::size_t slots) {
+	SourceWriter out;
+	for (std::size_t slot = 0; slot < slots; ++slot) {
+		std::string name = "HP" + std::to_string(slot + 1);
+		std::string enter = "enter " + protect(slot);
+		out.open("observer HazardPointer_" + std::to_string(slot + 1) + " [negative]");
+		out.line();
+		out.line("variables:");
+		out.indent++;
+		out.line("thread T;");
+		out.line("pointer P;");
+		out.indent--;
+		out.line();
+		out.line("states:");
+		out.indent++;
+		out.line("s1(" + name + "_init)[initial];");
+		out.line("s2(" + name + "_invoked);");
+		out.line("s3(" + name + "_protected);");
+		out.line("s4(" + name + "_retired);");
+		out.line("s5(" + name + "_fail)[final];");
+		out.indent--;
+		out.line();
+		out.line("transitions:");
+		out.indent++;
+		out.line("s1 -- " + enter + "(T, P) >> s2;");
+		out.line("s2 -- exit " + protect(slot) + "(T) >> s3;");
+		out.line("s3 -- enter retire(*, P) >> s4;");
+		out.line("s4 -- free(*, P) >> s5;");
+		out.line();
+		out.line("s2 -- " + enter + "(T, !P) >> s1;");
+		out.line("s3 -- " + enter + "(T, !P) >> s1;");
+		out.line("s4 -- " + enter + "(T, !P) >> s1;");
+		out.indent--;
+		out.line();
+		out.close();
+		out.line();
+	}
+	return out.stream.str();
+}
+
+std::string synthetic::generate_ebr_observer(std::size_t epochs) {
+	// states: init, protected and retired for every remaining epoch, fail
+	auto protected_state = [](std::size_t epoch) { return "p" + std::to_string(epoch); };
+	auto retired_state = [](std::size_t epoch) { return "r" + std::to_string(epoch); };
+
+	SourceWriter out;
+	out.open("observer EpochBasedReclamation [negative]");
+	out.line();
+	out.line("variables:");
+	out.indent++;
+	out.line("thread T;");
+	out.line("pointer P;");
+	out.indent--;
+	out.line();
+	out.line("states:");
+	out.indent++;
+	out.line("s0(EBR_init)[initial];");
+	for (std::size_t epoch = 1; epoch <= epochs; ++epoch) {
+		out.line(protected_state(epoch) + "(EBR_protected_" + std::to_string(epoch) + ");");
+		out.line(retired_state(epoch) + "(EBR_retired_" + std::to_string(epoch) + ");");
+	}
+	out.line("sF(EBR_fail)[final];");
+	out.indent--;
+	out.line();
+	out.line("transitions:");
+	out.indent++;
+	out.line("s0 -- exit leaveQ(T) >> " + protected_state(1) + ";");
+	for (std::size_t epoch = 1; epoch <= epochs; ++epoch) {
+		out.line(protected_state(epoch) + " -- enter retire(*, P) >> " + retired_state(epoch) + ";");
+		out.line(retired_state(epoch) + " -- free(*, P) >> sF;");
+	}
+	out.line();
+	for (std::size_t epoch = 1; epoch <= epochs; ++epoch) {
+		bool last = epoch == epochs;
+		out.line(protected_state(epoch) + " -- enter enterQ(T) >> " + (last ? "s0" : protected_state(epoch + 1)) + ";");
+		out.line(retired_state(epoch) + " -- enter enterQ(T) >> " + (last ? "s0" : retired_state(epoch + 1)) + ";");
+	}
+	out.indent--;
+	out.line();
+	out.close();
+	return out.stream.str();
+}
@@ -0,0 +1,41 @@
+#pragma once
+#ifndef SEAL_GENERATORS
+#define SEAL_GENERATORS
+
+#include <string>
+
+
+namespace synthetic {
+
+	enum struct SmrFamily { HP, EBR };
+
+	/** Size parameters of a generated program. Every function nests 'depth' loops (0 for straight-line code)
+	  * around 'calls' accesses to a shared stack; each access protects (HP) or guards (EBR) the top of stack
+	  * and may pop and retire it. Accesses cycle through 'locals' pointer variables (at least 2).
+	  */
+	struct ProgramShape {
+		std::size_t functions = 2;
+		std::size_t depth = 1;
+		std::size_t locals = 2;
+		std::size_t calls = 1;
+	};
+
+	/** CoLa program of the given shape. For HP, accesses cycle through the 'slots' functions 'protect1' to 'protect<slots>';
+	  * the accesses follow the (manually transformed) Treiber stack of the examples so that programs remain type safe.
+	  * For EBR, 'slots' is ignored.
+	  */
+	std::string generate_program(const ProgramShape& shape, SmrFamily family, std::size_t slots);
+
+	/** Hazard pointer specification with 'slots' hazard pointers, one observer per slot.
+	  * Generalizes 'hp_no_transfer.smr' (protections are not transferred between slots).
+	  */
+	std::string generate_hp_observer(std::size_t slots);
+
+	/** Epoch-based reclamation specification in which a thread's protection outlives 'epochs' critical sections:
+	  * it ends with the 'epochs'-th call of 'enterQ' after 'leaveQ'. For 'epochs == 1', this is 'ebr.smr'.
+	  */
+	std::string generate_ebr_observer(std::size_t epochs);
+
+} // namespace synthetic
+
+#endif
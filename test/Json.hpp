@@ -0,0 +1,37 @@
+#pragma once
+#ifndef SEAL_JSON
+#define SEAL_JSON
+
+#include <string>
+#include <cstdio>
+
+
+namespace json {
+
+	/** Escapes 'text' for use inside a JSON string literal (without the enclosing quotes).
+	  */
+	inline std::string escape(const std::string& text) {
+		std::string result;
+		for (char chr : text) {
+			switch (chr) {
+				case '"': result += "\\\""; break;
+				case '\\': result += "\\\\"; break;
+				case '\n': result += "\\n"; break;
+				case '\r': result += "\\r"; break;
+				case '\t': result += "\\t"; break;
+				default:
+					if ((unsigned char) chr < 0x20) {
+						char code[7];
+						std::snprintf(code, sizeof(code), "\\u%04x", (unsigned) (unsigned char) chr);
+						result += code;
+					} else {
+						result += chr;
+					}
+			}
+		}
+		return result;
+	}
+
+} // namespace json
+
+#endif
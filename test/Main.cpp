@@ -2,17 +2,48 @@
 #include <iostream>
 #include <fstream>
 #include <chrono>
+#include <future>
+#include <filesystem>
+#include <sstream>
+#include <type_traits>
+#include <map>
+#include <set>
+#include <deque>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include "tclap/CmdLine.h"
 
 #include "cola/parse.hpp"
 #include "cola/ast.hpp"
 #include "cola/observer.hpp"
 #include "cola/util.hpp"
+#include "cola/transform.hpp"
+#include "cola/serialize.hpp"
+#include "cola/trace.hpp"
 
 #include "types/preprocess.hpp"
 #include "types/rmraces.hpp"
 #include "types/check.hpp"
+#include "types/types.hpp"
 #include "types/cave.hpp"
+#include "types/deadline.hpp"
+#include "z3++.h"
+
+#include "Json.hpp"
+#include "Memory.hpp"
 
 using namespace TCLAP;
 using namespace cola;
@@ -46,6 +77,11 @@ std::string to_s(duration_t duration) {
 	return std::to_string(seconds) + "." + std::to_string(milli) + "s";
 }
 
+std::string to_mb(std::size_t bytes) {
+	static const std::size_t MB = 1024 * 1024;
+	return std::to_string((bytes + MB - 1) / MB) + "MB";
+}
+
 
 struct IsRegularFileConstraint : public Constraint<std::string> {
 	std::string id = "path";
@@ -70,14 +106,169 @@ static void fail_if(bool condition, CmdLine& cmd, std::string description="undef
 
 struct LeapConfig {
 	std::string program_path, observer_path, output_path;
+	std::string batch_path, batch_report_path;
+	std::string serve_path, client_path;
+	std::size_t batch_workers, batch_timeout;
 	bool check_types, check_annotations, check_linearizability;
 	bool rewrite_and_retry;
 	bool interactive, eager;
 	bool quiet, verbose;
+	bool json;
 	bool print_gist;
 	bool output;
+	std::size_t cave_jobs;
+	CaveSplit cave_split;
+	std::size_t cave_split_size;
+	bool cave_slicing;
+	bool cave_local_discharge;
+	std::size_t annotation_timeout, linearizability_timeout;
+	std::size_t type_timeout, rewrite_timeout;
+	std::size_t annotation_budget, linearizability_budget;
+	std::size_t cave_memory;
+	std::size_t memory_budget;
+	std::string cache_path;
+	ParserFrontend parser;
+	bool parser_crosscheck;
+	bool summarize_macros, macro_crosscheck;
+	std::string trace_path;
 } config;
 
+//
+// output
+//
+
+static bool write_all(int fd, const void* data, std::size_t size) {
+	const char* buffer = static_cast<const char*>(data);
+	while (size > 0) {
+		ssize_t count = write(fd, buffer, size);
+		if (count < 0 && errno == EINTR) continue;
+		if (count <= 0) return false;
+		buffer += count;
+		size -= count;
+	}
+	return true;
+}
+
+static const std::array<int, 8> FATAL_SIGNALS = { SIGABRT, SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGINT, SIGTERM, SIGHUP };
+
+/** Buffer for 'std::cout' writing to stdout in large blocks. Flushes are ignored unless stdout is a terminal:
+  * the library ends every line with 'std::endl', which would otherwise cost a system call per line.
+  * Instead, the buffer is written at exit, on uncaught exceptions, before forking, and on fatal signals (see 'install_output').
+  * Signal handlers may interrupt the buffer at any point; they write only what the last flush published, see 'drain_published'.
+  */
+class OutputBuffer : public std::streambuf {
+	private:
+		std::array<char, 64 * 1024> _buffer;
+		bool _interactive;
+		std::atomic<std::size_t> _published{0}; // length of the complete lines at the start of '_buffer'
+		std::atomic<bool> _busy{false}; // set while the buffer is written; a signal handler never releases it
+		static_assert(std::atomic<std::size_t>::is_always_lock_free && std::atomic<bool>::is_always_lock_free, "signal handlers need lock-free atomics");
+
+	public:
+		OutputBuffer() : _interactive(isatty(STDOUT_FILENO)) {
+			setp(_buffer.data(), _buffer.data() + _buffer.size());
+		}
+
+		bool drain() {
+			// a handler in this thread must not interrupt the write; one in another thread finds the buffer busy
+			sigset_t fatal, previous;
+			sigemptyset(&fatal);
+			for (int number : FATAL_SIGNALS) {
+				sigaddset(&fatal, number);
+			}
+			pthread_sigmask(SIG_BLOCK, &fatal, &previous);
+			bool success = true;
+			if (!_busy.exchange(true)) {
+				success = write_all(STDOUT_FILENO, pbase(), pptr() - pbase());
+				setp(_buffer.data(), _buffer.data() + _buffer.size());
+				_published.store(0);
+				_busy.store(false);
+			} // else a handler in another thread writes the published output and ends the process
+			pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+			return success;
+		}
+
+		/** Async-signal-safe variant of 'drain'. Does not touch the put area, which the interrupted code may be changing,
+		  * and writes the published lines at most once, even if 'drain' runs concurrently in another thread.
+		  */
+		void drain_published() {
+			if (!_busy.exchange(true)) {
+				write_all(STDOUT_FILENO, _buffer.data(), _published.load());
+			}
+		}
+
+	protected:
+		int overflow(int chr) override {
+			if (!drain()) {
+				return traits_type::eof();
+			}
+			if (!traits_type::eq_int_type(chr, traits_type::eof())) {
+				*pptr() = traits_type::to_char_type(chr);
+				pbump(1);
+			}
+			return traits_type::not_eof(chr);
+		}
+
+		int sync() override {
+			if (_interactive) {
+				return drain() ? 0 : -1;
+			}
+			_published.store(pptr() - pbase());
+			return 0;
+		}
+} stdout_buffer;
+
+struct NullBuffer : public std::streambuf {
+	int overflow(int chr) override { return chr; }
+} null_buffer;
+
+/** Writes everything buffered for stdout; required before forking and before leaving without 'exit'.
+  */
+static void flush_output() {
+	if (std::cout.rdbuf() == &stdout_buffer) {
+		stdout_buffer.drain();
+	}
+}
+
+/** Mutes 'std::cout', including all output of the library, for its lifetime if 'mute' holds.
+  */
+struct OutputMute {
+	std::streambuf* target;
+	OutputMute(bool mute) : target(std::cout.rdbuf()) {
+		if (mute) {
+			std::cout.rdbuf(&null_buffer);
+		}
+	}
+	~OutputMute() {
+		std::cout.rdbuf(target);
+	}
+};
+
+static void install_output() {
+	static std::streambuf* original_buffer = std::cout.rdbuf(&stdout_buffer);
+	static std::terminate_handler previous_handler = std::set_terminate([]() {
+		// keep the output leading up to an uncaught exception
+		flush_output();
+		previous_handler();
+	});
+	std::atexit([]() {
+		flush_output();
+		std::cout.rdbuf(original_buffer); // 'stdout_buffer' is destroyed before 'std::cout' is flushed for the last time
+	});
+
+	// 'abort' (e.g., failed assertions) and fatal signals bypass 'atexit', e.g., when benchmark.py interrupts a run
+	struct sigaction action = {};
+	action.sa_handler = [](int number) {
+		stdout_buffer.drain_published(); // output after the last flush (i.e., the last 'std::endl') is lost
+		signal(number, SIG_DFL);
+		raise(number); // delivered with the default action once the handler returns
+	};
+	sigemptyset(&action.sa_mask);
+	for (int number : FATAL_SIGNALS) {
+		sigaction(number, &action, nullptr);
+	}
+}
+
 enum SmrType { SMR_HP, SMR_EBR };
 
 std::string smr_to_string(SmrType type) {
@@ -87,12 +278,51 @@ std::string smr_to_string(SmrType type) {
 	}
 }
 
+struct SmrUnit {
+	std::shared_ptr<Program> program; // declares the SMR functions the observers refer to
+	std::string observer_path, observer_source;
+	std::unique_ptr<SmrObserverStore> store;
+	std::unique_ptr<TypeContext> context; // built on the first type check
+};
+
+// compiled SMR automata, shared by all jobs with the same observer file (and content) and SMR functions
+std::map<std::string, SmrUnit> smr_units;
+
+struct WarmProgram {
+	std::string key;
+	std::string preprocessed; // serialized
+};
+
+// preprocessed programs by path, kept while serving requests
+std::map<std::string, WarmProgram> warm_programs;
+
 struct ParseUnit {
 	std::shared_ptr<Program> program;
-	std::unique_ptr<SmrObserverStore> store;
+	SmrUnit* smr = nullptr;
 } input;
 
-enum AnalysisResult { SAFE, FAIL, UDEF };
+enum AnalysisResult { SAFE, FAIL, UDEF, TIMEOUT, MEMOUT };
+
+inline AnalysisResult to_result(const CaveResourceError& err) {
+	return err.kind == CaveResourceError::TIMEOUT ? TIMEOUT : MEMOUT;
+}
+
+inline std::string verdict_to_string(AnalysisResult result) {
+	switch (result) {
+		case SAFE: return "successful";
+		case FAIL: return "failed";
+		case UDEF: return "undefined";
+		case TIMEOUT: return "timeout";
+		case MEMOUT: return "out of memory";
+	}
+	return "undefined";
+}
+
+struct PhaseMemory {
+	std::size_t heap_peak = 0; // bytes allocated through 'new' by the entire process
+	std::size_t rss_peak = 0;
+	std::size_t allocations = 0;
+};
 
 struct AnalysisOutput {
 	AnalysisResult type_safe = UDEF;
@@ -104,8 +334,58 @@ struct AnalysisOutput {
 	duration_t time_annotations = ZERO_DURATION;
 	duration_t time_linearizability = ZERO_DURATION;
 	std::size_t number_rewrites = 0;
+	PhaseMemory memory_input;
+	PhaseMemory memory_types; // including rewrites
+	PhaseMemory memory_annotations;
+	PhaseMemory memory_linearizability;
 } output;
 
+/** Records the peak memory of a phase over its lifetime. Phases running concurrently see their combined peak.
+  * The memory budget is enforced while at least one phase is metered, so that reporting an exhausted budget succeeds.
+  * Memory of CAVE instances is not included; it is limited separately by '--cavememory'.
+  */
+struct MemoryMeter {
+	static inline std::atomic<std::size_t> active{0};
+	PhaseMemory& memory;
+	std::size_t allocations_before;
+	MemoryMeter(PhaseMemory& memory) : memory(memory), allocations_before(accounting::get_heap_statistics().allocations) {
+		accounting::reset_heap_peak();
+		accounting::reset_peak_rss();
+		if (active++ == 0) {
+			accounting::set_memory_limit(config.memory_budget * 1024 * 1024);
+		}
+	}
+	~MemoryMeter() {
+		if (--active == 0) {
+			accounting::set_memory_limit(0);
+		}
+		auto statistics = accounting::get_heap_statistics();
+		memory.heap_peak = std::max(memory.heap_peak, statistics.peak);
+		memory.rss_peak = std::max(memory.rss_peak, accounting::get_peak_rss());
+		memory.allocations += statistics.allocations - allocations_before;
+	}
+};
+
+/** Verdict of a phase aborted by 'error' due to an exhausted budget; 'std::nullopt' for any other error.
+  */
+static std::optional<AnalysisResult> get_abort_verdict(std::exception_ptr error) {
+	// the memory budget is enforced by 'new'; z3 may still run out of memory on its own
+	try {
+		std::rethrow_exception(error);
+	} catch (const TimeoutError& /*err*/) {
+		return TIMEOUT;
+	} catch (const std::bad_alloc& /*err*/) {
+		return MEMOUT;
+	} catch (const z3::exception& err) {
+		if (std::string(err.msg()).find("memory") != std::string::npos) {
+			return MEMOUT;
+		}
+		return std::nullopt;
+	} catch (...) {
+		return std::nullopt;
+	}
+}
+
 
 inline std::optional<std::reference_wrapper<const Function>> find_function(const Program& program, std::string name) {
 	for (const auto& function : program.functions) {
@@ -129,25 +409,178 @@ inline std::pair<const Function&, const Function&> lookup_functions(const Progra
 	return { find_function_or_fail(program, name1), find_function_or_fail(program, name2) };
 }
 
+template<typename T>
+static std::string crosscheck_fingerprint(const T& parsed) {
+	std::stringstream result;
+	if constexpr (std::is_same_v<T, Program>) {
+		cola::serialize(parsed, result);
+	} else {
+		for (const auto& observer : parsed) {
+			cola::print(*observer, result);
+		}
+	}
+	return result.str();
+}
+
+template<typename T>
+static void crosscheck_parser(const T& parsed, const T& reference, std::string path) {
+	// both front ends must yield the same AST; ids are not part of the fingerprint
+	if (crosscheck_fingerprint(parsed) != crosscheck_fingerprint(reference)) {
+		throw std::logic_error("Parser cross-check failed: native and ANTLR front end disagree on '" + path + "'.");
+	}
+}
+
+static std::shared_ptr<Program> read_program() {
+	auto result = cola::parse_program(config.program_path, config.parser);
+	if (config.parser_crosscheck) {
+		auto reference = cola::parse_program(config.program_path, ParserFrontend::ANTLR);
+		crosscheck_parser(*result, *reference, config.program_path);
+	}
+	return result;
+}
+
+static std::vector<std::unique_ptr<Observer>> read_observers(const Program& program) {
+	auto result = cola::parse_observer(config.observer_path, program, config.parser);
+	if (config.parser_crosscheck) {
+		auto reference = cola::parse_observer(config.observer_path, program, ParserFrontend::ANTLR);
+		crosscheck_parser(result, reference, config.observer_path);
+	}
+	return result;
+}
+
+static std::string read_source(const std::string& path) {
+	std::ifstream file(path);
+	std::stringstream source;
+	source << file.rdbuf();
+	return source.str();
+}
+
+static std::string get_smr_key(const Program& program, const std::string& observer_source) {
+	// key: observer path and source, and signatures of the SMR functions the observer is parsed against
+	std::string result = config.observer_path + '\0' + observer_source;
+	for (const auto& function : program.functions) {
+		if (function->kind == Function::SMR) {
+			result += '\0' + function->name + '(';
+			for (const auto& arg : function->args) {
+				result += arg->type.name + ',';
+			}
+			result += ')';
+		}
+	}
+	return result;
+}
+
 static void create_smr_observer(const Program& program, const Function& retire) {
 	std::cout << std::endl << "Preparing SMR automaton..." << std::flush;
-	auto observers = cola::parse_observer(config.observer_path, program);
-	input.store = std::make_unique<SmrObserverStore>(program, retire);
+	TraceScope trace("observer", "prepare SMR automaton");
+	auto observers = read_observers(program);
+	input.smr->store = std::make_unique<SmrObserverStore>(program, retire);
 	for (auto& observer : observers) {
-		input.store->add_impl_observer(std::move(observer));
+		input.smr->store->add_impl_observer(std::move(observer));
+	}
+	std::cout << "done" << std::endl;
+	if (!config.quiet) {
+		std::cout << "The SMR observer is the cross-product of (.dot): " << std::endl;
+		cola::print(*input.smr->store->base_observer, std::cout);
+		for (const auto& observer : input.smr->store->impl_observer) {
+			cola::print(*observer, std::cout);
+		}
+	}
+}
+
+static void rebind_smr_functions(Program& program) {
+	// the observers refer to the SMR functions of the program they were parsed against
+	std::map<const Function*, const Function*> rebinding;
+	for (const auto& function : program.functions) {
+		if (function->kind == Function::SMR) {
+			rebinding[function.get()] = &find_function_or_fail(*input.smr->program, function->name);
+		}
+	}
+	cola::rebind_functions(program, rebinding);
+}
+
+static void reuse_smr_observer(Program& program) {
+	std::cout << std::endl << "Reusing SMR automaton of '" << input.smr->program->name << "'." << std::endl;
+	rebind_smr_functions(program);
+}
+
+static std::string get_program_key() {
+	// program path (relative includes, e.g. specifications) and program source
+	return config.program_path + '\0' + read_source(config.program_path);
+}
+
+static std::string get_cache_file() {
+	// entries depend on the binary format and on how the program was preprocessed
+	std::string tag = "colab" + std::to_string(cola::SERIALIZATION_VERSION) + ";preprocess" + std::to_string(prtypes::PREPROCESS_VERSION);
+	tag += config.summarize_macros ? ";summarize" : ";inline";
+	std::size_t key = std::hash<std::string>{}(tag + '\0' + get_program_key());
+	std::string name = std::to_string(key) + ".v" + std::to_string(cola::SERIALIZATION_VERSION) + ".colab";
+	return (std::filesystem::path(config.cache_path) / name).string();
+}
+
+static bool load_cached_program(const std::string& cache_file) {
+	std::cout << std::endl << "Loading preprocessed program from cache... " << std::flush;
+	TraceScope trace("parse", "load cached program");
+	try {
+		input.program = cola::deserialize_program(cache_file);
+	} catch (const std::logic_error& err) {
+		// e.g., written by a different version; treated as a miss, the entry is replaced
+		std::cout << "failed: " << err.what() << std::endl;
+		return false;
 	}
 	std::cout << "done" << std::endl;
-	std::cout << "The SMR observer is the cross-product of (.dot): " << std::endl;
-	cola::print(*input.store->base_observer, std::cout);
-	for (const auto& observer : input.store->impl_observer) {
-		cola::print(*observer, std::cout);
+	return true;
+}
+
+static void store_cached_program(const Program& program, const std::string& cache_file) {
+	// written aside and renamed, so that interrupted or concurrent runs never leave a torn entry behind
+	std::string temporary = cache_file + ".tmp" + std::to_string(getpid());
+	auto discard = [&temporary](const std::exception& err) {
+		std::error_code ignored;
+		std::filesystem::remove(temporary, ignored);
+		std::cerr << "Could not cache preprocessed program: " << err.what() << std::endl;
+	};
+	try {
+		std::filesystem::create_directories(config.cache_path);
+		{
+			std::ofstream file(temporary, std::ios::binary);
+			cola::serialize(program, file);
+			file.close();
+			if (!file) {
+				throw std::logic_error("Could not write '" + temporary + "'.");
+			}
+		}
+		std::filesystem::rename(temporary, cache_file);
+	} catch (const std::logic_error& err) {
+		discard(err);
+	} catch (const std::filesystem::filesystem_error& err) {
+		discard(err);
 	}
 }
 
 static void read_input() {
-	// parse program
-	input.program = cola::parse_program(config.program_path);
+	bool serving = !config.serve_path.empty();
+	std::string warm_key = serving ? get_program_key() : "";
+	auto warm = warm_programs.find(config.program_path);
+	bool warmed = serving && warm != warm_programs.end() && warm->second.key == warm_key;
+	std::string cache_file = config.cache_path.empty() || warmed ? "" : get_cache_file();
+	bool cached = warmed || (!cache_file.empty() && std::filesystem::exists(cache_file));
+
+	// parse program, or load the preprocessed one from memory or the cache
+	if (warmed) {
+		std::cout << std::endl << "Reusing preprocessed program of an earlier request... " << std::flush;
+		TraceScope trace("parse", "load warm program");
+		std::istringstream stream(warm->second.preprocessed);
+		input.program = cola::deserialize_program(stream);
+		std::cout << "done" << std::endl;
+	} else if (cached) {
+		cached = load_cached_program(cache_file);
+	}
+	if (!cached) {
+		input.program = read_program();
+	}
 	Program& program = *input.program;
+	ArenaScope arena_scope(program.arena);
 
 	// query retire
 	auto search_retire = find_function(program, "retire");
@@ -155,15 +588,47 @@ static void read_input() {
 	const Function& retire = *search_retire;
 	
 	// preprocess program
-	std::cout << std::endl << "Preprocessing program... " << std::flush;
-	prtypes::preprocess(program, retire);
-	program.name += " (preprocessed)";
-	std::cout << "done" << std::endl;
-	std::cout << "Preprocessed program: " << std::endl;
-	cola::print(program, std::cout);
+	if (!cached) {
+		std::cout << std::endl << "Preprocessing program... " << std::flush;
+		prtypes::preprocess(program, retire, !config.summarize_macros);
+		program.name += " (preprocessed)";
+		std::cout << "done" << std::endl;
+		if (!cache_file.empty()) {
+			store_cached_program(program, cache_file);
+		}
+	}
+	if (serving && !warmed) {
+		std::ostringstream stream;
+		cola::serialize(program, stream);
+		warm_programs[config.program_path] = { warm_key, stream.str() };
+	}
+	if (!config.quiet) {
+		std::cout << "Preprocessed program: " << std::endl;
+		cola::print(program, std::cout);
+	}
 
-	// init SMR
-	create_smr_observer(program, retire);
+	// init SMR, or share the one of a previous job
+	std::string observer_source = read_source(config.observer_path);
+	auto [unit, is_new] = smr_units.try_emplace(get_smr_key(program, observer_source));
+	input.smr = &unit->second;
+	if (is_new) {
+		// automata of earlier versions of the observer file are of no further use
+		for (auto it = smr_units.begin(); it != smr_units.end();) {
+			bool outdated = it->second.observer_path == config.observer_path && it->second.observer_source != observer_source;
+			it = outdated ? smr_units.erase(it) : std::next(it);
+		}
+		input.smr->program = input.program;
+		input.smr->observer_path = config.observer_path;
+		input.smr->observer_source = observer_source;
+		try {
+			create_smr_observer(program, retire);
+		} catch (...) {
+			smr_units.erase(unit); // later jobs must not pick up a half-built store
+			throw;
+		}
+	} else {
+		reuse_smr_observer(program);
+	}
 }
 
 template<typename ErrorClass, typename... Targs>
@@ -177,11 +642,36 @@ void try_fix(ErrorClass& err, Targs... args) {
 	} else {
 		output.number_rewrites++;
 		auto begin = get_time();
-		prtypes::try_fix_pointer_race(*input.program, *input.store, err, args...);
+		prtypes::try_fix_pointer_race(*input.program, *input.smr->store, err, args...);
 		output.time_rewrite += get_elapsed(begin);
+		if (config.verbose) {
+			std::cout << "Program after rewrite " << output.number_rewrites << ": " << std::endl;
+			cola::print(*input.program, std::cout);
+		}
 	}
 }
 
+static void crosscheck_macros(bool type_safe) {
+	// preprocessing inlined the program in place; summarizing needs a fresh copy
+	std::cout << std::endl << "Cross-checking summaries of inline functions... " << std::flush;
+	TraceScope trace("types", "macro cross-check");
+	auto program = cola::parse_program(config.program_path, config.parser);
+	ArenaScope arena_scope(program->arena);
+	prtypes::preprocess(*program, find_function_or_fail(*program, "retire"), false);
+	rebind_smr_functions(*program);
+
+	bool summarized_safe;
+	try {
+		summarized_safe = prtypes::type_check(*program, *input.smr->context);
+	} catch (const PointerRaceError& /*err*/) {
+		summarized_safe = false;
+	}
+	if (summarized_safe != type_safe) {
+		throw std::logic_error("Macro cross-check failed: inlining and summarizing inline functions disagree on '" + config.program_path + "'.");
+	}
+	std::cout << "done" << std::endl;
+}
+
 static void do_type_check() {
 	std::unique_ptr<UnsafeAssumeError> previous_unsafe_assume_error;
 	auto is_reoffending = [&](const UnsafeAssumeError& error) {
@@ -193,39 +683,69 @@ static void do_type_check() {
 		}
 	};
 
-	bool type_safe;
-	do {
-		std::cout << std::endl << "Checking typing..." << std::endl;
-		auto begin = get_time();
-		try {
-			type_safe = prtypes::type_check(*input.program, *input.store);
-			output.time_types_total += get_elapsed(begin);
-			output.time_types_last = get_elapsed(begin);
+	bool type_safe = false; // if not fixed, a pointer race fails the type check
+	timepoint_t begin = get_time();
+	duration_t total_before = output.time_types_total;
+	try {
+		MemoryMeter meter(output.memory_types);
+		if (!input.smr->context) {
+			TraceScope trace("observer", "prepare type context");
+			input.smr->context = std::make_unique<TypeContext>(*input.smr->store);
+		}
 
-		} catch (UnsafeCallError err) {
-			output.time_types_total += get_elapsed(begin);
-			output.time_types_last = get_elapsed(begin);
-			try_fix(err);
+		DeadlineScope rewrite_deadline(std::chrono::seconds(config.rewrite_timeout));
+		do {
+			std::cout << std::endl << "Checking typing..." << std::endl;
+			begin = get_time();
+			total_before = output.time_types_total;
+			try {
+				TraceScope trace("types", "type check");
+				DeadlineScope run_deadline(std::chrono::seconds(config.type_timeout));
+				type_safe = prtypes::type_check(*input.program, *input.smr->context);
+				output.time_types_total += get_elapsed(begin);
+				output.time_types_last = get_elapsed(begin);
 
-		} catch (UnsafeDereferenceError err) {
-			output.time_types_total += get_elapsed(begin);
-			output.time_types_last = get_elapsed(begin);
-			try_fix(err);
+			} catch (UnsafeCallError err) {
+				output.time_types_total += get_elapsed(begin);
+				output.time_types_last = get_elapsed(begin);
+				try_fix(err);
 
-		} catch (UnsafeAssumeError err) {
-			output.time_types_total += get_elapsed(begin);
-			output.time_types_last = get_elapsed(begin);
-			bool reoffending = is_reoffending(err);
-			try_fix(err, reoffending);
-		}
+			} catch (UnsafeDereferenceError err) {
+				output.time_types_total += get_elapsed(begin);
+				output.time_types_last = get_elapsed(begin);
+				try_fix(err);
 
-	} while (!type_safe && config.rewrite_and_retry);
+			} catch (UnsafeAssumeError err) {
+				output.time_types_total += get_elapsed(begin);
+				output.time_types_last = get_elapsed(begin);
+				bool reoffending = is_reoffending(err);
+				try_fix(err, reoffending);
+			}
+
+		} while (!type_safe && config.rewrite_and_retry);
+
+		if (config.macro_crosscheck) {
+			crosscheck_macros(type_safe);
+		}
+	} catch (...) {
+		auto verdict = get_abort_verdict(std::current_exception());
+		if (!verdict) {
+			throw;
+		}
+		output.time_types_last = get_elapsed(begin);
+		output.time_types_total = total_before + output.time_types_last;
+		std::cout << "** Type check: " << verdict_to_string(*verdict) << " **" << std::endl << std::endl;
+		output.type_safe = *verdict;
+		return;
+	}
 
 	// print program after modifications
 	if (config.rewrite_and_retry) {
-		std::cout << "Transformed program: " << std::endl;
 		input.program->name += " (transformed)";
-		cola::print(*input.program, std::cout);
+		if (!config.quiet) {
+			std::cout << "Transformed program: " << std::endl;
+			cola::print(*input.program, std::cout);
+		}
 	}
 
 	std::cout << "** Type check " << (type_safe ? "succeeded" : "failed") << " **" << std::endl << std::endl;
@@ -233,27 +753,84 @@ static void do_type_check() {
 	else output.type_safe = FAIL;
 }
 
-static void do_annotation_check() {
-	std::cout << std::endl << "Checking assertions... " << std::flush;
-	bool assertions_safe = false;
+static void run_annotation_check() {
+	TraceScope trace("seal", "annotation check");
+	MemoryMeter meter(output.memory_annotations);
+	DeadlineScope deadline(std::chrono::seconds(config.annotation_budget));
 	auto begin = get_time();
-	assertions_safe = discharge_assertions(*input.program, *input.store);
+	try {
+		bool assertions_safe = discharge_assertions(*input.program, *input.smr->store, config.cave_split, config.cave_split_size);
+		if (assertions_safe) output.annotations_hold = SAFE;
+		else output.annotations_hold = FAIL;
+	} catch (const CaveResourceError& err) {
+		output.annotations_hold = to_result(err);
+	} catch (...) {
+		auto verdict = get_abort_verdict(std::current_exception());
+		if (!verdict) {
+			throw;
+		}
+		output.annotations_hold = *verdict;
+	}
 	output.time_annotations = get_elapsed(begin);
+}
+
+static void report_annotation_check() {
+	std::cout << "** Assertion check: " << (output.annotations_hold == SAFE ? "succeeded" : (output.annotations_hold == FAIL ? "failed" : verdict_to_string(output.annotations_hold))) << " **" << std::endl << std::endl;
+}
+
+static void do_annotation_check() {
+	std::cout << std::endl << "Checking assertions... " << std::flush;
+	run_annotation_check();
 	std::cout << "done" << std::endl;
-	std::cout << "** Assertion check: " << (assertions_safe ? "succeeded" : "failed") << " **" << std::endl << std::endl;
-	if (assertions_safe) output.annotations_hold = SAFE;
-	else output.annotations_hold = FAIL;
+	report_annotation_check();
 }
 
-static void do_linearizability_check() {
-	std::cout << std::endl << "Checking linearizability under GC... " << std::flush;
+static void run_linearizability_check() {
+	TraceScope trace("seal", "linearizability check");
+	MemoryMeter meter(output.memory_linearizability);
+	DeadlineScope deadline(std::chrono::seconds(config.linearizability_budget));
 	auto begin = get_time();
-	bool linearizable = prtypes::check_linearizability(*input.program);
+	try {
+		bool linearizable = prtypes::check_linearizability(*input.program);
+		if (linearizable) output.linearizable = SAFE;
+		else output.linearizable = FAIL;
+	} catch (const CaveResourceError& err) {
+		output.linearizable = to_result(err);
+	} catch (...) {
+		auto verdict = get_abort_verdict(std::current_exception());
+		if (!verdict) {
+			throw;
+		}
+		output.linearizable = *verdict;
+	}
 	output.time_linearizability = get_elapsed(begin);
+}
+
+static void report_linearizability_check() {
+	std::cout << "** Linearizability check: " << (output.linearizable == SAFE ? "succeeded" : (output.linearizable == FAIL ? "failed" : verdict_to_string(output.linearizable))) << " **" << std::endl << std::endl;
+}
+
+static void do_linearizability_check() {
+	std::cout << std::endl << "Checking linearizability under GC... " << std::flush;
+	run_linearizability_check();
+	std::cout << "done" << std::endl;
+	report_linearizability_check();
+}
+
+static void do_concurrent_checks() {
+	// both checks are independent CAVE runs; the linearizability result is discarded if the annotations do not hold
+	std::cout << std::endl << "Checking assertions and linearizability under GC concurrently... " << std::flush;
+	auto annotations = std::async(std::launch::async, run_annotation_check);
+	auto linearizability = std::async(std::launch::async, run_linearizability_check);
+	annotations.get();
+	linearizability.get();
 	std::cout << "done" << std::endl;
-	std::cout << "** Linearizability check: " << (linearizable ? "succeeded" : "failed") << " **" << std::endl << std::endl;
-	if (linearizable) output.linearizable = SAFE;
-	else output.linearizable = FAIL;
+	report_annotation_check();
+	if (output.annotations_hold != FAIL) {
+		report_linearizability_check();
+	} else {
+		output.linearizable = UDEF;
+	}
 }
 
 static void print_summary() {
@@ -274,7 +851,7 @@ static void print_summary() {
 	};
 	auto summary_types = [&]() -> std::string {
 		if (config.check_types) {
-			std::string verdict = output.type_safe == SAFE ? "successful" : "failed";
+			std::string verdict = output.type_safe == SAFE ? "successful" : (output.type_safe == FAIL ? "failed" : verdict_to_string(output.type_safe));
 			std::string addition = output.number_rewrites == 0 ? "" : " (total " + to_s(output.time_types_total) + ")";
 			return verdict + " after " + to_s(output.time_types_last) + addition;
 		} else {
@@ -282,21 +859,29 @@ static void print_summary() {
 		}
 	};
 	auto summary_annotations = [&]() -> std::string {
-		if (config.check_annotations && output.type_safe != FAIL) {
-			std::string verdict = output.annotations_hold == SAFE ? "successful" : "failed";
+		if (config.check_annotations && output.annotations_hold != UDEF) {
+			std::string verdict = verdict_to_string(output.annotations_hold);
 			return verdict + " after " + to_s(output.time_annotations);
 		} else {
 			return "--skipped--";
 		}
 	};
 	auto summary_linearizability  = [&]() -> std::string {
-		if (config.check_linearizability && output.type_safe != FAIL && output.annotations_hold != FAIL) {
-			std::string verdict = output.linearizable == SAFE ? "successful" : "failed";
+		if (config.check_linearizability && output.linearizable != UDEF) {
+			std::string verdict = verdict_to_string(output.linearizable);
 			return verdict + " after " + to_s(output.time_linearizability);
 		} else {
 			return "--skipped--";
 		}
 	};
+	auto summary_memory = [&](bool performed, const PhaseMemory& memory) -> std::string {
+		// peaks are process-wide, including the program and SMR automaton
+		if (performed) {
+			return to_mb(memory.heap_peak) + " heap, " + to_mb(memory.rss_peak) + " RSS, " + std::to_string(memory.allocations) + " allocations";
+		} else {
+			return "--skipped--";
+		}
+	};
 
 	std::cout << std::endl << std::endl;
 	std::cout << "# Summary:" << std::endl;
@@ -305,38 +890,911 @@ static void print_summary() {
 	std::cout << "# Rewrites:               " << summary_rewrite() << std::endl;
 	std::cout << "# Annotation Check:       " << summary_annotations() << std::endl;
 	std::cout << "# Linearizability Check:  " << summary_linearizability() << std::endl;
+	std::cout << "# Memory Input:           " << summary_memory(true, output.memory_input) << std::endl;
+	std::cout << "# Memory Type Check:      " << summary_memory(config.check_types, output.memory_types) << std::endl;
+	std::cout << "# Memory Annotations:     " << summary_memory(config.check_annotations && output.annotations_hold != UDEF, output.memory_annotations) << std::endl;
+	std::cout << "# Memory Linearizability: " << summary_memory(config.check_linearizability && output.linearizable != UDEF, output.memory_linearizability) << std::endl;
 }
 
-void print_gist() {
-	if (!config.print_gist) {
-		return;
-	}
-	auto mk_status = [](bool enabled, AnalysisResult result, duration_t time) -> std::string {
+static std::string make_gist(const LeapConfig& config, const AnalysisOutput& output) {
+	auto mk_status = [](bool enabled, AnalysisResult result, duration_t time, const PhaseMemory& memory) -> std::string {
 		if (!enabled) {
-			return "-:-";
+			return "-:-:-";
 		}
 		std::string verdict;
 		switch (result) {
 			case SAFE: verdict = "1"; break;
 			case FAIL: verdict = "0"; break;
 			case UDEF: verdict = "?"; break;
+			case TIMEOUT: verdict = "to"; break;
+			case MEMOUT: verdict = "mo"; break;
 		}
-		return verdict + ":" + to_s(time);;
+		return verdict + ":" + to_s(time) + ":" + to_mb(memory.heap_peak);
 	};
+	return mk_status(config.check_types, output.type_safe, output.time_types_last, output.memory_types) + ";"
+	     + mk_status(config.check_annotations, output.annotations_hold, output.time_annotations, output.memory_annotations) + ";"
+	     + mk_status(config.check_linearizability, output.linearizable, output.time_linearizability, output.memory_linearizability);
+}
+
+void print_gist() {
+	if (!config.print_gist) {
+		return;
+	}
 	std::cout << std::endl << std::endl;
-	std::cout << "#gist=";
-	std::cout << mk_status(config.check_types, output.type_safe, output.time_types_last) << ";";
-	std::cout << mk_status(config.check_annotations, output.annotations_hold, output.time_annotations) << ";";
-	std::cout << mk_status(config.check_linearizability, output.linearizable, output.time_linearizability) << std::endl;
+	std::cout << "#gist=" << make_gist(config, output) << std::endl;
+}
+
+static void print_json() {
+	// one line per job, so that batches yield JSON lines
+	auto mk_memory = [](const PhaseMemory& memory) -> std::string {
+		return "{ \"heap_peak\": " + std::to_string(memory.heap_peak) + ", \"rss_peak\": " + std::to_string(memory.rss_peak)
+		     + ", \"allocations\": " + std::to_string(memory.allocations) + " }";
+	};
+	auto mk_phase = [&](bool performed, AnalysisResult result, duration_t time, const PhaseMemory& memory) -> std::string {
+		if (!performed) {
+			return "null";
+		}
+		return "{ \"verdict\": \"" + verdict_to_string(result) + "\", \"time_ms\": " + std::to_string(time.count()) + ", \"memory\": " + mk_memory(memory) + " }";
+	};
+	bool performed_annotations = config.check_annotations && output.annotations_hold != UDEF;
+	bool performed_linearizability = config.check_linearizability && output.linearizable != UDEF;
+	std::cout << "{ \"program\": \"" << json::escape(config.program_path) << "\", ";
+	std::cout << "\"observer\": \"" << json::escape(config.observer_path) << "\", ";
+	std::cout << "\"input_memory\": " << mk_memory(output.memory_input) << ", ";
+	std::cout << "\"types\": " << mk_phase(config.check_types, output.type_safe, output.time_types_last, output.memory_types) << ", ";
+	std::cout << "\"types_total_ms\": " << output.time_types_total.count() << ", ";
+	std::cout << "\"rewrites\": " << output.number_rewrites << ", ";
+	std::cout << "\"rewrites_ms\": " << output.time_rewrite.count() << ", ";
+	std::cout << "\"annotations\": " << mk_phase(performed_annotations, output.annotations_hold, output.time_annotations, output.memory_annotations) << ", ";
+	std::cout << "\"linearizability\": " << mk_phase(performed_linearizability, output.linearizable, output.time_linearizability, output.memory_linearizability) << ", ";
+	std::cout << "\"gist\": \"" << make_gist(config, output) << "\" }" << std::endl;
+}
+
+static void write_output() {
+	std::ofstream file(config.output_path);
+	cola::print(*input.program, file);
+	if (!file) {
+		throw std::runtime_error("Could not write program to '" + config.output_path + "'.");
+	}
+}
+
+static void complete_config(LeapConfig& conf) {
+	if (!conf.check_types && !conf.check_annotations && !conf.check_linearizability) {
+		conf.check_types = conf.check_annotations = conf.check_linearizability = true;
+	}
+}
+
+static void run_checks() {
+	OutputMute mute(config.quiet);
+
+	// parse program, observer
+	try {
+		MemoryMeter meter(output.memory_input);
+		read_input();
+	} catch (...) {
+		auto verdict = get_abort_verdict(std::current_exception());
+		if (!verdict) {
+			throw;
+		}
+		std::cout << "** Reading input: " << verdict_to_string(*verdict) << " **" << std::endl << std::endl;
+		if (config.check_types) output.type_safe = *verdict;
+		if (config.check_annotations) output.annotations_hold = *verdict;
+		if (config.check_linearizability) output.linearizable = *verdict;
+		return;
+	}
+	ArenaScope arena_scope(input.program->arena); // rewrites allocate next to the program
+
+	// do type check
+	if (config.check_types) {
+		do_type_check();
+	}
+
+	// check annotations and linearizability
+	bool types_passed = output.type_safe == SAFE || output.type_safe == UDEF; // UDEF: not checked
+	bool run_annotations = config.check_annotations && types_passed;
+	bool run_linearizability = config.check_linearizability && types_passed;
+	if (run_annotations && run_linearizability && config.cave_jobs > 1) {
+		do_concurrent_checks();
+
+	} else {
+		if (run_annotations) {
+			do_annotation_check();
+		}
+		if (run_linearizability && output.annotations_hold != FAIL) {
+			do_linearizability_check();
+		}
+	}
+}
+
+static void run_job() {
+	run_checks();
+
+	if (config.output) {
+		write_output();
+	}
+	if (config.json) {
+		print_json();
+	} else {
+		print_summary();
+		print_gist();
+	}
+}
+
+struct BatchJob {
+	std::string program_path, observer_path;
+	std::vector<std::string> flags;
+};
+
+static std::string quote_path(const std::string& path) {
+	// inverse of 'split_job'
+	std::string result = "\"";
+	for (char chr : path) {
+		if (chr == '"' || chr == '\\') result += '\\';
+		result += chr == '\n' ? std::string("\\n") : std::string(1, chr);
+	}
+	return result + "\"";
+}
+
+static std::optional<std::vector<std::string>> split_job(const std::string& line, std::string& error) {
+	// blank separated tokens; '"' quotes blanks and '#', in quotes '\' escapes the next character ('\n' a line break)
+	std::vector<std::string> result;
+	std::size_t pos = 0;
+	while (true) {
+		while (pos < line.size() && std::isspace(static_cast<unsigned char>(line[pos]))) ++pos;
+		if (pos == line.size() || line[pos] == '#') {
+			return result;
+		}
+		std::string token;
+		bool quoted = false;
+		for (; pos < line.size() && (quoted || (!std::isspace(static_cast<unsigned char>(line[pos])) && line[pos] != '#')); ++pos) {
+			if (line[pos] == '"') {
+				quoted = !quoted;
+			} else if (quoted && line[pos] == '\\' && pos+1 < line.size()) {
+				++pos;
+				token += line[pos] == 'n' ? '\n' : line[pos];
+			} else {
+				token += line[pos];
+			}
+		}
+		if (quoted) {
+			error = "Job '" + line + "' lacks a closing quote.";
+			return std::nullopt;
+		}
+		result.push_back(std::move(token));
+	}
+}
+
+static std::optional<BatchJob> parse_job(const std::string& line, const std::filesystem::path& base, std::string& error) {
+	// <program> <observer> [flags]; paths are relative to 'base', '#' starts a comment
+	static const std::set<std::string> supported_flags = { "-s", "-t", "-a", "-l", "-e", "-g", "-q", "-v", "--json" };
+	auto tokens = split_job(line, error);
+	if (!tokens || tokens->empty()) {
+		return std::nullopt;
+	}
+	if (tokens->size() < 2) {
+		error = "Job '" + line + "' lacks an observer.";
+		return std::nullopt;
+	}
+	BatchJob job;
+	IsRegularFileConstraint is_file;
+	job.program_path = (base / tokens->at(0)).string();
+	job.observer_path = (base / tokens->at(1)).string();
+	if (!is_file.check(job.program_path)) {
+		error = "Job program '" + job.program_path + "' is not a regular file.";
+		return std::nullopt;
+	}
+	if (!is_file.check(job.observer_path)) {
+		error = "Job observer '" + job.observer_path + "' is not a regular file.";
+		return std::nullopt;
+	}
+	for (auto flag = tokens->begin() + 2; flag != tokens->end(); ++flag) {
+		if (supported_flags.count(*flag) == 0) {
+			error = "Unsupported flag '" + *flag + "' in job '" + line + "'.";
+			return std::nullopt;
+		}
+		job.flags.push_back(*flag);
+	}
+	return job;
+}
+
+static std::vector<BatchJob> read_batch(CmdLine& cmd) {
+	// one job per line; paths are relative to the manifest
+	std::vector<BatchJob> result;
+	std::filesystem::path base = std::filesystem::path(config.batch_path).parent_path();
+	std::ifstream file(config.batch_path);
+	std::string line;
+	while (std::getline(file, line)) {
+		std::string error;
+		auto job = parse_job(line, base, error);
+		fail_if(!error.empty(), cmd, "Batch: " + error, "batch");
+		if (job) {
+			result.push_back(std::move(*job));
+		}
+	}
+	return result;
+}
+
+static LeapConfig make_job_config(const LeapConfig& base, const BatchJob& job) {
+	LeapConfig result = base;
+	result.program_path = job.program_path;
+	result.observer_path = job.observer_path;
+	for (const auto& flag : job.flags) {
+		if (flag == "-s") result.rewrite_and_retry = false;
+		else if (flag == "-t") result.check_types = true;
+		else if (flag == "-a") result.check_annotations = true;
+		else if (flag == "-l") result.check_linearizability = true;
+		else if (flag == "-e") result.eager = true;
+		else if (flag == "-g") result.print_gist = true;
+		else if (flag == "-q") result.quiet = true;
+		else if (flag == "-v") result.verbose = true;
+		else if (flag == "--json") result.json = result.quiet = true;
+	}
+	result.verbose &= !result.quiet;
+	complete_config(result);
+	return result;
+}
+
+struct BatchResult {
+	bool aborted = false;
+	bool timed_out = false;
+	duration_t time = ZERO_DURATION;
+	AnalysisOutput output;
+};
+
+static_assert(std::is_trivially_copyable_v<BatchResult>, "batch results are sent through pipes");
+
+static std::string batch_verdict(const BatchResult& result) {
+	if (result.aborted) return "aborted";
+	if (result.timed_out) return "timeout";
+	bool failed = result.output.type_safe == FAIL || result.output.annotations_hold == FAIL || result.output.linearizable == FAIL;
+	return failed ? "failed" : "done";
+}
+
+static std::string batch_flags(const BatchJob& job) {
+	std::string result;
+	for (const auto& flag : job.flags) {
+		result += (result.empty() ? "" : " ") + flag;
+	}
+	return result;
+}
+
+static BatchResult run_isolated_job(const LeapConfig& base, const BatchJob& job, const std::string& label) {
+	config = make_job_config(base, job);
+	input = ParseUnit();
+	output = AnalysisOutput();
+	if (!config.quiet) {
+		std::cout << std::endl << std::endl;
+		std::cout << "# " << label << ": " << config.program_path << " " << config.observer_path << std::endl;
+	}
+	auto begin = get_time();
+	BatchResult result;
+	try {
+		TraceScope trace("batch", [&]{ return label + ": " + job.program_path; });
+		run_job();
+	} catch (const std::exception& err) {
+		// a broken job must not take the remaining ones down
+		if (config.json) {
+			std::cout << "{ \"program\": \"" << json::escape(config.program_path) << "\", \"observer\": \"" << json::escape(config.observer_path) << "\", ";
+			std::cout << "\"aborted\": \"" << json::escape(err.what()) << "\" }" << std::endl;
+		} else {
+			std::cout << std::endl << "Job aborted: " << err.what() << std::endl;
+		}
+		result.aborted = true;
+	}
+	result.time = get_elapsed(begin);
+	result.output = output;
+	return result;
+}
+
+static BatchResult run_batch_job(const LeapConfig& base, const std::vector<BatchJob>& jobs, std::size_t index) {
+	return run_isolated_job(base, jobs.at(index), "Batch job " + std::to_string(index+1) + "/" + std::to_string(jobs.size()));
+}
+
+static std::vector<BatchResult> run_batch_sequentially(const LeapConfig& base, const std::vector<BatchJob>& jobs) {
+	std::vector<BatchResult> result;
+	for (std::size_t index = 0; index < jobs.size(); ++index) {
+		result.push_back(run_batch_job(base, jobs, index));
+	}
+	return result;
+}
+
+
+//
+// parallel batch: forked workers
+//
+
+static std::string read_json_string(const std::string& line, const std::string& key) {
+	// only understands what 'write_batch_report' writes
+	auto pos = line.find("\"" + key + "\": \"");
+	if (pos == std::string::npos) {
+		return "";
+	}
+	std::string result;
+	for (pos += key.size() + 5; pos < line.size() && line[pos] != '"'; ++pos) {
+		if (line[pos] == '\\') ++pos;
+		if (pos < line.size()) result += line[pos];
+	}
+	return result;
+}
+
+static std::string batch_history_key(const std::string& program, const std::string& observer, const std::string& flags) {
+	return program + '\0' + observer + '\0' + flags;
+}
+
+static std::map<std::string, duration_t> read_batch_history(const std::string& path) {
+	// timings of a previous report; jobs that timed out record the limit, a lower bound
+	std::map<std::string, duration_t> result;
+	std::ifstream file(path);
+	std::string line;
+	while (std::getline(file, line)) {
+		auto pos = line.find("\"time_ms\": ");
+		if (pos == std::string::npos || line.find("\"program\"") == std::string::npos) {
+			continue;
+		}
+		auto key = batch_history_key(read_json_string(line, "program"), read_json_string(line, "observer"), read_json_string(line, "flags"));
+		result[key] = std::chrono::milliseconds(std::stoll(line.substr(pos + 11)));
+	}
+	return result;
+}
+
+static void write_batch_report(const std::string& path, const LeapConfig& base, const std::vector<BatchJob>& jobs, const std::vector<BatchResult>& results, duration_t time) {
+	std::ofstream file(path);
+	file << "{" << std::endl;
+	file << "\t\"workers\": " << base.batch_workers << "," << std::endl;
+	file << "\t\"time_ms\": " << time.count() << "," << std::endl;
+	file << "\t\"jobs\": [" << std::endl;
+	for (std::size_t index = 0; index < jobs.size(); ++index) {
+		const auto& job = jobs.at(index);
+		const auto& result = results.at(index);
+		file << "\t\t{ ";
+		file << "\"program\": \"" << json::escape(job.program_path) << "\", ";
+		file << "\"observer\": \"" << json::escape(job.observer_path) << "\", ";
+		file << "\"flags\": \"" << json::escape(batch_flags(job)) << "\", ";
+		file << "\"verdict\": \"" << batch_verdict(result) << "\", ";
+		file << "\"gist\": \"" << (result.aborted || result.timed_out ? "" : make_gist(make_job_config(base, job), result.output)) << "\", ";
+		file << "\"rewrites\": " << result.output.number_rewrites << ", ";
+		file << "\"time_ms\": " << result.time.count();
+		file << " }" << (index+1 < jobs.size() ? "," : "") << std::endl;
+	}
+	file << "\t]" << std::endl;
+	file << "}" << std::endl;
+}
+
+static bool read_all(int fd, void* data, std::size_t size) {
+	char* buffer = static_cast<char*>(data);
+	while (size > 0) {
+		ssize_t count = read(fd, buffer, size);
+		if (count < 0 && errno == EINTR) continue;
+		if (count <= 0) return false;
+		buffer += count;
+		size -= count;
+	}
+	return true;
+}
+
+struct BatchWorker {
+	pid_t pid = -1;
+	int requests = -1; // parent -> worker: job indices
+	int results = -1; // worker -> parent: result and captured output
+	std::deque<std::size_t> queue;
+	std::optional<std::size_t> job;
+	timepoint_t started;
+	std::set<std::string> observers; // SMR automata the worker process has built
+	bool cold = false; // the job builds its SMR automaton
+};
+
+[[noreturn]] static void run_batch_worker(const LeapConfig& base, const std::vector<BatchJob>& jobs, int requests, int results) {
+	// the output of a job is sent to the parent in one piece, so that jobs do not interleave
+	std::stringstream captured;
+	std::cout.rdbuf(captured.rdbuf());
+	std::size_t index;
+	while (read_all(requests, &index, sizeof(index))) {
+		captured.str("");
+		BatchResult result = run_batch_job(base, jobs, index);
+		std::string text = captured.str();
+		std::size_t length = text.size();
+		if (!write_all(results, &result, sizeof(result)) || !write_all(results, &length, sizeof(length)) || !write_all(results, text.data(), length)) {
+			break;
+		}
+	}
+	_exit(0);
+}
+
+template<typename Run>
+static void spawn_worker(std::vector<BatchWorker>& workers, std::size_t slot, Run run) {
+	// 'run(requests, results)' must not return
+	int requests[2], results[2];
+	if (pipe(requests) != 0 || pipe(results) != 0) {
+		throw std::runtime_error("Could not create pipe for worker: " + std::string(strerror(errno)) + ".");
+	}
+	flush_output();
+	pid_t pid = fork();
+	if (pid < 0) {
+		throw std::runtime_error("Could not fork worker: " + std::string(strerror(errno)) + ".");
+	}
+	if (pid == 0) {
+		// keep only the own channels; otherwise siblings would never see end of file
+		for (const auto& other : workers) {
+			if (other.requests >= 0) close(other.requests);
+			if (other.results >= 0) close(other.results);
+		}
+		close(requests[1]);
+		close(results[0]);
+		run(requests[0], results[1]);
+	}
+	close(requests[0]);
+	close(results[1]);
+	auto& worker = workers.at(slot);
+	worker.pid = pid;
+	worker.requests = requests[1];
+	worker.results = results[0];
+	worker.job.reset();
+	worker.observers.clear();
+}
+
+static void spawn_batch_worker(std::vector<BatchWorker>& workers, std::size_t slot, const LeapConfig& base, const std::vector<BatchJob>& jobs) {
+	spawn_worker(workers, slot, [&](int requests, int results) { run_batch_worker(base, jobs, requests, results); });
+}
+
+static int stop_batch_worker(BatchWorker& worker, bool force) {
+	// returns the exit status of the worker
+	if (force) {
+		kill(worker.pid, SIGKILL);
+	}
+	close(worker.requests);
+	close(worker.results);
+	int status = 0;
+	while (waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) {}
+	worker.pid = worker.requests = worker.results = -1;
+	return status;
+}
+
+static std::vector<BatchResult> run_batch_forked(const LeapConfig& base, const std::vector<BatchJob>& jobs) {
+	// expected cost: history of a previous report; unknown jobs are assumed to be as expensive as the most expensive known one
+	auto history = base.batch_report_path.empty() ? std::map<std::string, duration_t>() : read_batch_history(base.batch_report_path);
+	duration_t unknown = ZERO_DURATION;
+	for (const auto& [key, time] : history) {
+		unknown = std::max(unknown, time);
+	}
+	std::vector<duration_t> expected;
+	std::vector<bool> known;
+	for (const auto& job : jobs) {
+		auto search = history.find(batch_history_key(job.program_path, job.observer_path, batch_flags(job)));
+		expected.push_back(search != history.end() ? search->second : unknown);
+		known.push_back(search != history.end());
+	}
+	auto longest_first = [&](std::size_t job, std::size_t other) { return expected.at(job) > expected.at(other); };
+
+	// seed one queue per worker: jobs of the same observer go to the same worker, so they share its SMR automaton
+	std::vector<BatchWorker> workers(std::min(base.batch_workers, jobs.size()));
+	std::map<std::string, std::vector<std::size_t>> groups;
+	for (std::size_t index = 0; index < jobs.size(); ++index) {
+		groups[jobs.at(index).observer_path].push_back(index);
+	}
+	std::vector<std::pair<duration_t, std::vector<std::size_t>>> sorted_groups;
+	for (auto& [observer, group] : groups) {
+		duration_t cost = ZERO_DURATION;
+		for (auto index : group) cost += expected.at(index);
+		sorted_groups.push_back({ cost, std::move(group) });
+	}
+	std::stable_sort(sorted_groups.begin(), sorted_groups.end(), [](const auto& group, const auto& other) { return group.first > other.first; });
+	std::vector<duration_t> load(workers.size(), ZERO_DURATION);
+	// without history all costs are zero; the number of jobs spreads the groups then
+	auto seeded = [&](std::size_t slot) { return std::make_pair(load.at(slot), workers.at(slot).queue.size()); };
+	for (const auto& [cost, group] : sorted_groups) {
+		std::size_t slot = 0;
+		for (std::size_t other = 1; other < workers.size(); ++other) {
+			if (seeded(other) < seeded(slot)) slot = other;
+		}
+		load.at(slot) += cost;
+		workers.at(slot).queue.insert(workers.at(slot).queue.end(), group.begin(), group.end());
+	}
+	for (auto& worker : workers) {
+		std::stable_sort(worker.queue.begin(), worker.queue.end(), longest_first);
+	}
+
+	auto remaining = [&](const BatchWorker& worker) {
+		duration_t result = ZERO_DURATION;
+		for (auto index : worker.queue) result += expected.at(index);
+		return result;
+	};
+	// jobs building their SMR automaton (cold) take longer than jobs of a worker that has it already (warm)
+	struct ObserverTiming {
+		duration_t cold = ZERO_DURATION, warm = ZERO_DURATION;
+		int colds = 0, warms = 0;
+	};
+	std::map<std::string, ObserverTiming> timings;
+	duration_t unknown_time = ZERO_DURATION;
+	int unknown_count = 0;
+	auto build_cost = [&](const std::string& observer) -> std::optional<duration_t> {
+		auto search = timings.find(observer);
+		if (search == timings.end() || search->second.colds == 0) {
+			return std::nullopt;
+		}
+		const auto& timing = search->second;
+		duration_t cold = timing.cold / timing.colds;
+		return timing.warms == 0 ? cold : std::max(ZERO_DURATION, cold - timing.warm / timing.warms);
+	};
+	auto expected_build = [&](const BatchWorker& worker, std::size_t index) -> std::optional<duration_t> {
+		// unknown until a job building the automaton finished
+		const auto& observer = jobs.at(index).observer_path;
+		return worker.observers.count(observer) != 0 ? ZERO_DURATION : build_cost(observer);
+	};
+	auto take = [&](BatchWorker& worker, BatchWorker& victim, std::size_t pos) {
+		std::size_t result = victim.queue.at(pos);
+		victim.queue.erase(victim.queue.begin() + pos);
+		worker.cold = worker.observers.insert(jobs.at(result).observer_path).second;
+		return result;
+	};
+	auto next_job = [&](BatchWorker& worker) -> std::optional<std::size_t> {
+		if (!worker.queue.empty()) {
+			return take(worker, worker, 0);
+		}
+		// steal the longest job of the most loaded worker whose SMR automaton the thief has already built;
+		// other jobs only if the thief finishes them, building their automaton again, before their worker would
+		for (bool built : { true, false }) {
+			BatchWorker* victim = nullptr;
+			duration_t victim_load = ZERO_DURATION;
+			std::size_t victim_pos = 0;
+			for (auto& other : workers) {
+				duration_t load = remaining(other);
+				if (other.job) {
+					load += std::max(ZERO_DURATION, expected.at(*other.job) - get_elapsed(other.started));
+				}
+				if (victim && load <= victim_load) {
+					continue;
+				}
+				auto candidate = std::find_if(other.queue.begin(), other.queue.end(), [&](std::size_t index) {
+					if (built) return worker.observers.count(jobs.at(index).observer_path) != 0;
+					auto build = expected_build(worker, index);
+					return build && *build + expected.at(index) < load;
+				});
+				if (candidate != other.queue.end()) {
+					victim = &other;
+					victim_load = load;
+					victim_pos = candidate - other.queue.begin();
+				}
+			}
+			if (victim) {
+				return take(worker, *victim, victim_pos);
+			}
+		}
+		return std::nullopt;
+	};
+
+	std::vector<BatchResult> results(jobs.size());
+	std::size_t finished = 0;
+	auto finish = [&](BatchWorker& worker, BatchResult result, const std::string& text) {
+		std::size_t index = *worker.job;
+		result.time = get_elapsed(worker.started);
+		results.at(index) = result;
+		if (!result.aborted && !result.timed_out) {
+			auto& timing = timings[jobs.at(index).observer_path];
+			(worker.cold ? timing.cold : timing.warm) += result.time;
+			++(worker.cold ? timing.colds : timing.warms);
+			if (!known.at(index) && !worker.cold) {
+				// without history, the measured jobs tell what to expect from the others
+				unknown_time += result.time;
+				unknown = unknown_time / ++unknown_count;
+				for (std::size_t other = 0; other < jobs.size(); ++other) {
+					if (!known.at(other)) expected.at(other) = unknown;
+				}
+			}
+		}
+		std::cout << text;
+		++finished;
+		if (!base.quiet) std::cout << std::endl << "# Batch job " << index+1 << "/" << jobs.size() << " " << batch_verdict(result) << " after " << to_s(result.time) << " (" << finished << " of " << jobs.size() << " finished)" << std::endl;
+		worker.job.reset();
+	};
+	auto restart = [&](std::size_t slot) {
+		stop_batch_worker(workers.at(slot), true);
+		spawn_batch_worker(workers, slot, base, jobs);
+	};
+
+	signal(SIGPIPE, SIG_IGN); // dead workers are detected by failing reads/writes
+	for (std::size_t slot = 0; slot < workers.size(); ++slot) {
+		spawn_batch_worker(workers, slot, base, jobs);
+	}
+	auto timeout = std::chrono::duration_cast<duration_t>(std::chrono::seconds(base.batch_timeout));
+	while (finished < jobs.size()) {
+		for (std::size_t slot = 0; slot < workers.size(); ++slot) {
+			auto& worker = workers.at(slot);
+			if (!worker.job) {
+				auto job = next_job(worker);
+				if (job && !write_all(worker.requests, &*job, sizeof(std::size_t))) {
+					restart(slot);
+					write_all(worker.requests, &*job, sizeof(std::size_t));
+				}
+				worker.job = job;
+				worker.started = get_time();
+			}
+		}
+
+		std::vector<struct pollfd> requests;
+		std::vector<std::size_t> slots;
+		int wait_ms = -1;
+		for (std::size_t slot = 0; slot < workers.size(); ++slot) {
+			if (workers.at(slot).job) {
+				requests.push_back({ workers.at(slot).results, POLLIN, 0 });
+				slots.push_back(slot);
+				if (timeout.count() > 0) {
+					auto left = std::max(ZERO_DURATION, timeout - get_elapsed(workers.at(slot).started));
+					wait_ms = wait_ms < 0 ? left.count() : std::min<int>(wait_ms, left.count());
+				}
+			}
+		}
+		if (poll(requests.data(), requests.size(), wait_ms) < 0 && errno != EINTR) {
+			throw std::runtime_error("Could not wait for batch workers: " + std::string(strerror(errno)) + ".");
+		}
+
+		for (std::size_t pos = 0; pos < requests.size(); ++pos) {
+			std::size_t slot = slots.at(pos);
+			auto& worker = workers.at(slot);
+			if (requests.at(pos).revents != 0) {
+				BatchResult result;
+				std::size_t length;
+				std::string text;
+				bool received = read_all(worker.results, &result, sizeof(result)) && read_all(worker.results, &length, sizeof(length));
+				if (received) {
+					text.resize(length);
+					received = read_all(worker.results, text.data(), length);
+				}
+				if (received) {
+					finish(worker, result, text);
+				} else {
+					// worker died, e.g., by an assertion failure; the job is lost, the worker replaced
+					BatchResult crashed;
+					crashed.aborted = true;
+					finish(worker, crashed, "\nJob aborted: batch worker terminated unexpectedly.\n");
+					restart(slot);
+				}
+			} else if (timeout.count() > 0 && get_elapsed(worker.started) >= timeout) {
+				BatchResult timed_out;
+				timed_out.timed_out = true;
+				finish(worker, timed_out, "\nJob exceeded the batch timeout of " + std::to_string(base.batch_timeout) + "s.\n");
+				restart(slot);
+			}
+		}
+	}
+
+	for (auto& worker : workers) {
+		stop_batch_worker(worker, false);
+	}
+	return results;
+}
+
+static void run_batch(const std::vector<BatchJob>& jobs) {
+	LeapConfig base = config;
+	auto begin = get_time();
+	bool forked = base.batch_workers > 1 || base.batch_timeout > 0;
+	auto results = forked ? run_batch_forked(base, jobs) : run_batch_sequentially(base, jobs);
+	auto time = get_elapsed(begin);
+
+	if (!base.quiet) {
+		std::cout << std::endl << std::endl;
+		std::cout << "# Batch Summary:" << std::endl;
+		std::cout << "# ==============" << std::endl;
+		for (std::size_t index = 0; index < jobs.size(); ++index) {
+			std::cout << "# " << jobs.at(index).program_path << " " << jobs.at(index).observer_path << ": " << batch_verdict(results.at(index)) << " after " << to_s(results.at(index).time) << std::endl;
+		}
+		if (forked) {
+			std::cout << "# " << jobs.size() << " jobs on " << std::min(base.batch_workers, jobs.size()) << " workers in " << to_s(time) << std::endl;
+		} else {
+			std::cout << "# " << jobs.size() << " jobs sharing " << smr_units.size() << " SMR automata in " << to_s(time) << std::endl;
+		}
+	}
+
+	if (!base.batch_report_path.empty()) {
+		write_batch_report(base.batch_report_path, base, jobs, results, time);
+	}
+}
+
+//
+// daemon: verification requests over a Unix socket
+//
+
+static sockaddr_un make_socket_address(const std::string& path) {
+	sockaddr_un result;
+	std::memset(&result, 0, sizeof(result));
+	result.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(result.sun_path)) {
+		throw std::runtime_error("Socket path '" + path + "' is too long.");
+	}
+	std::strncpy(result.sun_path, path.c_str(), sizeof(result.sun_path) - 1);
+	return result;
+}
+
+static int connect_socket(const std::string& path) {
+	auto address = make_socket_address(path);
+	int result = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (result >= 0 && connect(result, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+		close(result);
+		result = -1;
+	}
+	return result;
+}
+
+static const std::chrono::seconds REQUEST_TIMEOUT(5);
+
+static std::optional<std::string> read_request(int fd) {
+	// a request is a single line; it must arrive within REQUEST_TIMEOUT, otherwise a silent client would block the daemon
+	static const std::size_t MAX_REQUEST_SIZE = 64 * 1024;
+	std::string result;
+	char chr;
+	auto begin = get_time();
+	while (result.size() < MAX_REQUEST_SIZE) {
+		auto left = REQUEST_TIMEOUT - get_elapsed(begin);
+		struct pollfd request = { fd, POLLIN, 0 };
+		int ready = left > ZERO_DURATION ? poll(&request, 1, left.count()) : 0;
+		if (ready < 0 && errno == EINTR) continue;
+		if (ready == 0) return std::nullopt;
+		ssize_t count = ready < 0 ? -1 : read(fd, &chr, 1);
+		if (count < 0 && errno == EINTR) continue;
+		if (count <= 0 || chr == '\n') break;
+		result += chr;
+	}
+	return result;
+}
+
+static std::string answer_request(const LeapConfig& base, const std::string& request, std::size_t number) {
+	std::string error;
+	auto job = parse_job(request, "", error);
+	if (!job) {
+		return "error: " + (error.empty() ? "Request '" + request + "' contains no job." : error) + "\n";
+	}
+	std::stringstream captured;
+	auto buffer = std::cout.rdbuf(captured.rdbuf());
+	run_isolated_job(base, *job, "Request " + std::to_string(number));
+	std::cout.rdbuf(buffer);
+	return captured.str();
+}
+
+struct ServeAnswer {
+	std::size_t programs = 0, automata = 0; // warm after the request
+	std::size_t length = 0; // of the output that follows
+};
+
+[[noreturn]] static void run_serve_worker(const LeapConfig& base, int requests, int results) {
+	// the warm state lives here: a request crashing the worker takes it down, but not the daemon
+	std::size_t number, length;
+	while (read_all(requests, &number, sizeof(number)) && read_all(requests, &length, sizeof(length))) {
+		std::string request(length, '\0');
+		if (!read_all(requests, request.data(), length)) {
+			break;
+		}
+		std::string response = answer_request(base, request, number);
+		ServeAnswer answer = { warm_programs.size(), smr_units.size(), response.size() };
+		if (!write_all(results, &answer, sizeof(answer)) || !write_all(results, response.data(), response.size())) {
+			break;
+		}
+	}
+	_exit(0);
+}
+
+static std::string describe_exit(int status) {
+	if (WIFSIGNALED(status)) {
+		return "by signal " + std::to_string(WTERMSIG(status)) + " (" + strsignal(WTERMSIG(status)) + ")";
+	}
+	return "with status " + std::to_string(WEXITSTATUS(status));
+}
+
+static void serve() {
+	// requests are answered one after the other by a forked worker holding the warm state; later ones wait in the socket's backlog
+	LeapConfig base = config;
+	prtypes::set_cave_result_cache(true);
+	signal(SIGPIPE, SIG_IGN); // clients may hang up before receiving the result
+
+	int other = connect_socket(base.serve_path);
+	if (other >= 0) {
+		close(other);
+		throw std::runtime_error("Another instance is serving on '" + base.serve_path + "'.");
+	}
+	struct stat info;
+	if (lstat(base.serve_path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+		unlink(base.serve_path.c_str()); // left behind by a dead instance
+	}
+	auto address = make_socket_address(base.serve_path);
+	int server = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (server < 0 || bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(server, 16) != 0) {
+		throw std::runtime_error("Could not serve on '" + base.serve_path + "': " + std::string(strerror(errno)) + ".");
+	}
+	std::cout << "# Serving requests on '" << base.serve_path << "'" << std::endl;
+	flush_output();
+	std::vector<BatchWorker> workers(1);
+	auto spawn = [&]() {
+		spawn_worker(workers, 0, [&](int requests, int results) {
+			close(server);
+			run_serve_worker(base, requests, results);
+		});
+	};
+	spawn();
+
+	std::size_t served = 0;
+	while (true) {
+		int client = accept(server, nullptr, nullptr);
+		if (client < 0) {
+			if (errno == EINTR) continue;
+			throw std::runtime_error("Could not accept request: " + std::string(strerror(errno)) + ".");
+		}
+		auto received = read_request(client);
+		if (!received) {
+			std::string response = "error: No request received within " + std::to_string(REQUEST_TIMEOUT.count()) + "s.\n";
+			write_all(client, response.data(), response.size());
+			close(client);
+			if (!base.quiet) {
+				std::cout << "# Dropped a client that sent no request within " << REQUEST_TIMEOUT.count() << "s" << std::endl;
+				flush_output();
+			}
+			continue;
+		}
+		std::string request = *received;
+		if (request.empty()) {
+			close(client); // e.g., another instance checking whether this one is alive
+			continue;
+		}
+		if (request == "shutdown") {
+			close(client);
+			break;
+		}
+		auto begin = get_time();
+		auto& worker = workers.front();
+		std::size_t number = ++served, length = request.size();
+		ServeAnswer answer;
+		std::string response;
+		bool answered = write_all(worker.requests, &number, sizeof(number)) && write_all(worker.requests, &length, sizeof(length))
+		                && write_all(worker.requests, request.data(), length) && read_all(worker.results, &answer, sizeof(answer));
+		if (answered) {
+			response.resize(answer.length);
+			answered = read_all(worker.results, response.data(), answer.length);
+		}
+		if (!answered) {
+			// e.g., a failed assertion; the warm state is lost with the worker
+			int status = stop_batch_worker(worker, true);
+			response = "\nRequest aborted: worker terminated unexpectedly " + describe_exit(status) + ".\n";
+			answer = ServeAnswer();
+		}
+		write_all(client, response.data(), response.size());
+		close(client); // before spawning a new worker, which would keep the client waiting otherwise
+		if (!answered) {
+			spawn();
+		}
+		if (!base.quiet) {
+			std::cout << "# Request " << served << " '" << request << "' " << (answered ? "answered" : "aborted") << " after " << to_s(get_elapsed(begin));
+			std::cout << " (" << answer.programs << " programs, " << answer.automata << " SMR automata warm)" << std::endl;
+			flush_output();
+		}
+	}
+	stop_batch_worker(workers.front(), false);
+	close(server);
+	unlink(base.serve_path.c_str());
+}
+
+static void send_request(const std::string& request) {
+	int server = connect_socket(config.client_path);
+	if (server < 0) {
+		throw std::runtime_error("Could not connect to '" + config.client_path + "': " + std::string(strerror(errno)) + ".");
+	}
+	std::string line = request + "\n";
+	if (!write_all(server, line.data(), line.size())) {
+		throw std::runtime_error("Could not send request to '" + config.client_path + "'.");
+	}
+	std::array<char, 4096> buffer;
+	while (true) {
+		ssize_t count = read(server, buffer.data(), buffer.size());
+		if (count < 0 && errno == EINTR) continue;
+		if (count <= 0) break;
+		std::cout.write(buffer.data(), count);
+	}
+	close(server);
 }
 
 int main(int argc, char** argv) {
+	std::vector<BatchJob> batch;
+	std::string request;
 
 	// parse command line arguments
 	try {
 		CmdLine cmd("SEAL verification tool for lock-free data structures with safe memory reclamation", ' ', "0.9");
-		auto is_program_constraint = std::make_unique<IsRegularFileConstraint>("_to_program");
-		auto is_observer_constraint = std::make_unique<IsRegularFileConstraint>("_to_smr");
 
 		// path to file containing observer definition
 		// static const std::string NO_OBSERVER_PATH = "<none>";
@@ -349,80 +1807,172 @@ int main(int argc, char** argv) {
 		SwitchArg linearizability_switch("l", "checklinearizability", "Perform linearizability check", cmd, false);
 		// SwitchArg interactive_switch("i", "interactive", "Interactive mode to control type check", cmd, false);
 		SwitchArg eager_switch("e", "eager", "Eagerly checks annotations before adding them", cmd, false);
-		// SwitchArg quiet_switch("q", "quiet", "Disables most output", cmd, false);
-		// SwitchArg verbose_switch("v", "verbose", "Verbose output", cmd, false);
+		SwitchArg quiet_switch("q", "quiet", "Disables most output", cmd, false);
+		SwitchArg verbose_switch("v", "verbose", "Verbose output", cmd, false);
+		SwitchArg json_switch("", "json", "Print the result as JSON object instead of the summary; implies quiet", cmd, false);
 		SwitchArg gist_switch("g", "gist", "Print machine readable gist at the very end", cmd, false);
-		// ValueArg<std::string> output_arg("o", "output", "Output file for transformed program", false , "", "path", cmd);
-		UnlabeledValueArg<std::string> program_arg("program", "Input program file to analyze", true, "", is_program_constraint.get(), cmd);
-		UnlabeledValueArg<std::string> observer_arg("observer", "Input observer file for SMR specification", true, "", is_observer_constraint.get(), cmd);
+		ValueArg<std::size_t> jobs_arg("j", "jobs", "Maximal number of CAVE instances running in parallel", false, 2, "number", cmd);
+		std::vector<std::string> split_values = { "none", "function", "assertion" };
+		ValuesConstraint<std::string> split_constraint(split_values);
+		ValueArg<std::string> split_arg("", "split", "Split annotation check into parallel CAVE queries per function or per group of assertions", false, "none", &split_constraint, cmd);
+		ValueArg<std::size_t> split_size_arg("", "splitsize", "Number of assertions per CAVE query when splitting per assertion", false, 1, "number", cmd);
+		SwitchArg noslice_switch("", "noslice", "Do not slice away assignments irrelevant for the annotation check", cmd, false);
+		SwitchArg nolocal_switch("", "nolocal", "Send all active assertions to CAVE, including trivially valid ones", cmd, false);
+		ValueArg<std::size_t> annotation_timeout_arg("", "annotationtimeout", "Wall-clock limit per CAVE query of the annotation check; 0 for no limit", false, 0, "seconds", cmd);
+		ValueArg<std::size_t> linearizability_timeout_arg("", "linearizabilitytimeout", "Wall-clock limit for the CAVE linearizability check; 0 for no limit", false, 0, "seconds", cmd);
+		ValueArg<std::size_t> type_timeout_arg("", "typetimeout", "Wall-clock limit per type check run; 0 for no limit", false, 0, "seconds", cmd);
+		ValueArg<std::size_t> rewrite_timeout_arg("", "rewritetimeout", "Wall-clock limit for all type check runs and rewrites together; 0 for no limit", false, 0, "seconds", cmd);
+		ValueArg<std::size_t> annotation_budget_arg("", "annotationbudget", "Wall-clock limit for the annotation check as a whole; 0 for no limit", false, 0, "seconds", cmd);
+		ValueArg<std::size_t> linearizability_budget_arg("", "linearizabilitybudget", "Wall-clock limit for the linearizability check as a whole, including its translation for CAVE; 0 for no limit", false, 0, "seconds", cmd);
+		ValueArg<std::string> cache_arg("", "cache", "Directory for caching preprocessed programs; skips parsing and preprocessing on a hit", false, "", "path", cmd);
+		std::vector<std::string> parser_values = { "antlr", "native", "crosscheck" };
+		ValuesConstraint<std::string> parser_constraint(parser_values);
+		ValueArg<std::string> parser_arg("", "parser", "Parser front end; 'crosscheck' parses with the native one and fails if ANTLR disagrees", false, "antlr", &parser_constraint, cmd);
+		std::vector<std::string> macro_values = { "inline", "summarize", "crosscheck" };
+		ValuesConstraint<std::string> macro_constraint(macro_values);
+		ValueArg<std::string> macro_arg("", "macros", "Type check calls to 'inline' functions by inlining them or by summaries per call; 'crosscheck' inlines and fails if summaries disagree", false, "inline", &macro_constraint, cmd);
+		ValueArg<std::size_t> cave_memory_arg("", "cavememory", "Address space limit per CAVE instance; 0 for no limit", false, 0, "MB", cmd);
+		ValueArg<std::size_t> memory_arg("", "memory", "Memory budget (resident set) of seal itself; a phase exceeding it is reported as out of memory; 0 for no limit", false, 0, "MB", cmd);
+		ValueArg<std::string> batch_arg("", "batch", "Manifest of jobs '<program> <observer> [flags]' to run in one process; jobs with the same observer share the SMR automaton", false, "", "path", cmd);
+		ValueArg<std::size_t> batch_workers_arg("", "batchworkers", "Number of forked worker processes running batch jobs in parallel", false, 1, "number", cmd);
+		ValueArg<std::size_t> batch_timeout_arg("", "batchtimeout", "Wall-clock limit per batch job; 0 for no limit", false, 0, "seconds", cmd);
+		ValueArg<std::string> batch_report_arg("", "batchreport", "JSON report of the batch; timings of an existing report order the jobs longest first", false, "", "path", cmd);
+		ValueArg<std::string> serve_arg("", "serve", "Serve verification requests '<program> <observer> [flags]' on a Unix socket, keeping parsed programs, SMR automata and CAVE verdicts warm", false, "", "socket", cmd);
+		ValueArg<std::string> client_arg("", "client", "Send program, observer and check flags as request to a serving instance and print its answer", false, "", "socket", cmd);
+		ValueArg<std::string> trace_arg("", "trace", "Timeline of the verification phases in Chrome trace format (chrome://tracing, Perfetto)", false, "", "path", cmd);
+		ValueArg<std::string> output_arg("o", "output", "Output file for transformed program", false , "", "path", cmd);
+		// TCLAP allows no unlabeled argument after an optional one; program and observer are optional for batches and serving
+		UnlabeledMultiArg<std::string> input_arg("input", "Input program file to analyze, followed by input observer file for SMR specification", false, "program observer", cmd);
 
 		cmd.parse( argc, argv );
-		config.program_path = program_arg.getValue();
-		config.observer_path = observer_arg.getValue();
+		const auto& input = input_arg.getValue();
+		fail_if(input.size() != 0 && input.size() != 2, cmd, "Expecting a program file followed by an observer file.", "input");
+		if (input.size() == 2) {
+			fail_if(!IsRegularFileConstraint().check(input.at(0)), cmd, "Program must be a regular file.", "program");
+			fail_if(!IsRegularFileConstraint().check(input.at(1)), cmd, "Observer must be a regular file.", "observer");
+			config.program_path = input.at(0);
+			config.observer_path = input.at(1);
+		}
 		config.check_types = type_switch.getValue();
 		config.rewrite_and_retry = !keep_switch.getValue();
 		config.check_annotations = annotation_switch.getValue();
 		config.check_linearizability = linearizability_switch.getValue();
 		config.eager = eager_switch.getValue();
 		config.print_gist = gist_switch.getValue();
+		config.cave_jobs = jobs_arg.getValue();
+		config.cave_split = split_arg.getValue() == "function" ? CaveSplit::FUNCTION : (split_arg.getValue() == "assertion" ? CaveSplit::ASSERTION : CaveSplit::NONE);
+		config.cave_split_size = split_size_arg.getValue();
+		config.cave_slicing = !noslice_switch.getValue();
+		config.cave_local_discharge = !nolocal_switch.getValue();
+		config.annotation_timeout = annotation_timeout_arg.getValue();
+		config.linearizability_timeout = linearizability_timeout_arg.getValue();
+		config.type_timeout = type_timeout_arg.getValue();
+		config.rewrite_timeout = rewrite_timeout_arg.getValue();
+		config.annotation_budget = annotation_budget_arg.getValue();
+		config.linearizability_budget = linearizability_budget_arg.getValue();
+		config.cave_memory = cave_memory_arg.getValue();
+		config.memory_budget = memory_arg.getValue();
+		config.cache_path = cache_arg.getValue();
+		config.parser = parser_arg.getValue() == "antlr" ? ParserFrontend::ANTLR : ParserFrontend::NATIVE;
+		config.parser_crosscheck = parser_arg.getValue() == "crosscheck";
+		config.summarize_macros = macro_arg.getValue() == "summarize";
+		config.macro_crosscheck = macro_arg.getValue() == "crosscheck";
+		config.batch_path = batch_arg.getValue();
+		config.batch_workers = batch_workers_arg.getValue();
+		config.batch_timeout = batch_timeout_arg.getValue();
+		config.batch_report_path = batch_report_arg.getValue();
+		config.serve_path = serve_arg.getValue();
+		config.client_path = client_arg.getValue();
+		config.trace_path = trace_arg.getValue();
 		config.interactive = false;
-		config.quiet = false;
-		config.verbose = false;
-		config.output = false;
-		config.output_path = "";
 		// config.interactive = interactive_switch.getValue();
-		// config.quiet = quiet_switch.getValue();
-		// config.verbose = verbose_switch.getValue();
-		// config.output = output_arg.isSet();
-		// config.output_path = output_arg.getValue();
+		config.json = json_switch.getValue();
+		config.quiet = quiet_switch.getValue() || config.json;
+		config.verbose = verbose_switch.getValue();
+		config.output = output_arg.isSet();
+		config.output_path = output_arg.getValue();
 
-		if (!config.check_types && !config.check_annotations && !config.check_linearizability) {
-			config.check_types = config.check_annotations = config.check_linearizability = true;
+		// sanity checks
+		bool has_input = !input.empty();
+		bool serving = !config.serve_path.empty();
+		fail_if(config.batch_path.empty() && !serving && !has_input, cmd, "Program and observer are required unless running a batch or serving.", "program");
+		fail_if(!config.batch_path.empty() && has_input, cmd, "Program and observer cannot be given together with a batch.", "batch");
+		fail_if(serving && has_input, cmd, "Program and observer are given by the requests when serving.", "serve");
+		fail_if(serving && (!config.batch_path.empty() || !config.client_path.empty()), cmd, "Serving cannot be combined with a batch or a request.", "serve");
+		fail_if(!config.client_path.empty() && !config.batch_path.empty(), cmd, "Requests cannot be combined with a batch.", "client");
+		fail_if(config.batch_path.empty() && (batch_workers_arg.isSet() || batch_timeout_arg.isSet() || batch_report_arg.isSet()), cmd, "Batch options require a batch.", "batch");
+		fail_if(config.batch_workers == 0, cmd, "Number of batch workers must be positive.", "batchworkers");
+		if (!config.batch_path.empty()) {
+			fail_if(!IsRegularFileConstraint().check(config.batch_path), cmd, "Batch manifest must be a regular file.", "batch");
+			batch = read_batch(cmd);
+			fail_if(batch.empty(), cmd, "Batch manifest contains no jobs.", "batch");
+		} else if (!config.client_path.empty()) {
+			// the serving instance applies its own options; only the job itself is forwarded
+			request = quote_path(std::filesystem::absolute(config.program_path).string()) + " " + quote_path(std::filesystem::absolute(config.observer_path).string());
+			std::vector<std::pair<SwitchArg*, std::string>> forwarded = {
+				{ &keep_switch, "-s" }, { &type_switch, "-t" }, { &annotation_switch, "-a" }, { &linearizability_switch, "-l" },
+				{ &eager_switch, "-e" }, { &gist_switch, "-g" }, { &quiet_switch, "-q" }, { &verbose_switch, "-v" }, { &json_switch, "--json" }
+			};
+			for (const auto& [arg, flag] : forwarded) {
+				if (arg->getValue()) request += " " + flag;
+			}
+		} else if (!serving) {
+			complete_config(config); // when serving, every request is completed on its own
 		}
 
-		// sanity checks
 		fail_if(config.quiet && config.verbose, cmd, "Quiet and verbose mode cannot be used together.");
+		fail_if(config.output && (!config.batch_path.empty() || !config.serve_path.empty()), cmd, "Output file cannot be used together with a batch or when serving.", "output");
 		fail_if(!config.check_types && config.interactive, cmd, "Interactive mode requires enabled type check.");
 		// fail_if(!config.check_types && config.rewrite_and_retry, cmd, "Rewriting requires enabled type check.");
 		fail_if(!config.rewrite_and_retry && config.eager, cmd, "Eager mode requires enabled rewriting.", "eager");
 		fail_if(config.interactive && config.eager, cmd, "Eager and interactive mode cannot be used together.", "interactive");
+		fail_if(config.cave_jobs == 0, cmd, "Number of parallel CAVE jobs must be positive.", "jobs");
+		fail_if(config.cave_split_size == 0, cmd, "Number of assertions per CAVE query must be positive.", "splitsize");
+		bool macros_summarized = config.summarize_macros || config.macro_crosscheck;
+		fail_if(macros_summarized && config.rewrite_and_retry, cmd, "Summarizing inline functions requires a simple type check; rewriting needs them inlined.", "macros");
+		fail_if(config.summarize_macros && (config.check_annotations || config.check_linearizability), cmd, "Annotation and linearizability check need inline functions inlined.", "macros");
+		fail_if(config.summarize_macros && (!config.batch_path.empty() || serving), cmd, "Summarizing inline functions cannot be used with a batch or when serving.", "macros");
 
 	} catch (ArgException &e) {
 		std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+		return 1;
 	}
 	// end: parse command line arguments
 
 
-	// TODO: implement proper output facade respecting the flags
-	if (config.verbose) { throw std::logic_error("Verbose mode not yet implemented"); }
-	if (config.quiet) { throw std::logic_error("Quiet mode not yet implemented"); }
-
 	// TODO: implement interactive mode
 	if (config.interactive) { throw std::logic_error("Interactive mode not yet implemented"); }
 
-	// TODO: implement output mode
-	if (config.output) { throw std::logic_error("Output not yet implemented"); }
+	install_output();
 
 
-	// parse program, observer
-	read_input();
-
-	// do type check
-	if (config.check_types) {
-		do_type_check();
+	prtypes::set_cave_job_limit(config.cave_jobs);
+	prtypes::set_cave_slicing(config.cave_slicing);
+	prtypes::set_cave_local_discharge(config.cave_local_discharge);
+	prtypes::set_cave_limits(CavePhase::ANNOTATIONS, { std::chrono::seconds(config.annotation_timeout), config.cave_memory });
+	prtypes::set_cave_limits(CavePhase::LINEARIZABILITY, { std::chrono::seconds(config.linearizability_timeout), config.cave_memory });
+	if (!config.trace_path.empty()) {
+		Trace::enable();
 	}
 
-	// check annotations
-	if (config.check_annotations && output.type_safe != FAIL) {
-		do_annotation_check();
+	if (!config.client_path.empty()) {
+		try {
+			send_request(request);
+		} catch (const std::runtime_error& err) {
+			std::cerr << "error: " << err.what() << std::endl;
+			return 1;
+		}
+	} else if (!config.serve_path.empty()) {
+		serve();
+	} else if (batch.empty()) {
+		run_job();
+	} else {
+		run_batch(batch);
 	}
 
-	// check linearizability
-	if (config.check_linearizability && output.type_safe != FAIL && output.annotations_hold != FAIL) {
-		do_linearizability_check();
+	if (!config.trace_path.empty()) {
+		std::ofstream file(config.trace_path);
+		Trace::write(file);
 	}
-
-	print_summary();
-	print_gist();
 	return 0;
 }
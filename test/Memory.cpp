@@ -0,0 +1,184 @@
+#include "Memory.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace accounting;
+
+
+// constant initialized; usable by allocations that happen before 'main'
+static std::atomic<std::size_t> heap_in_use(0);
+static std::atomic<std::size_t> heap_peak(0);
+static std::atomic<std::size_t> heap_allocations(0);
+static std::atomic<std::size_t> memory_limit(0);
+
+static const std::size_t RSS_SAMPLE_INTERVAL = 1024;
+
+static inline std::size_t block_size(void* ptr) {
+#if defined(__GLIBC__)
+	return malloc_usable_size(ptr);
+#else
+	(void) ptr;
+	return 0; // allocations are counted, sizes are not
+#endif
+}
+
+// reading '/proc' must not allocate: it is done from within 'operator new' and from destructors while unwinding 'std::bad_alloc'
+template<std::size_t N>
+static bool read_proc(const char* path, char (&buffer)[N]) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	ssize_t count = read(fd, buffer, N - 1);
+	close(fd);
+	if (count <= 0) {
+		return false;
+	}
+	buffer[count] = '\0';
+	return true;
+}
+
+static std::size_t get_current_rss() {
+	char buffer[128];
+	if (!read_proc("/proc/self/statm", buffer)) {
+		return 0;
+	}
+	char* resident;
+	std::strtoull(buffer, &resident, 10); // skip total program size
+	return std::strtoull(resident, nullptr, 10) * sysconf(_SC_PAGESIZE);
+}
+
+static bool exceeds_limit(std::size_t size) {
+	std::size_t limit = memory_limit.load(std::memory_order_relaxed);
+	if (limit == 0) {
+		return false;
+	}
+	if (heap_in_use.load(std::memory_order_relaxed) + size > limit) {
+		return true;
+	}
+	// the resident set includes what z3 allocates; sampled since reading it takes system calls
+	return heap_allocations.load(std::memory_order_relaxed) % RSS_SAMPLE_INTERVAL == 0 && get_current_rss() > limit;
+}
+
+static void* allocate(std::size_t size, std::size_t alignment) {
+	if (exceeds_limit(size)) {
+		return nullptr;
+	}
+	size = size == 0 ? 1 : size;
+	void* result;
+	if (alignment <= alignof(std::max_align_t)) {
+		result = std::malloc(size);
+	} else {
+		result = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+	}
+	if (result) {
+		std::size_t block = block_size(result);
+		std::size_t now = heap_in_use.fetch_add(block, std::memory_order_relaxed) + block;
+		std::size_t peak = heap_peak.load(std::memory_order_relaxed);
+		while (now > peak && !heap_peak.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {}
+		heap_allocations.fetch_add(1, std::memory_order_relaxed);
+	}
+	return result;
+}
+
+static void* allocate_or_throw(std::size_t size, std::size_t alignment) {
+	while (true) {
+		void* result = allocate(size, alignment);
+		if (result) {
+			return result;
+		}
+		std::new_handler handler = std::get_new_handler();
+		if (!handler) {
+			throw std::bad_alloc();
+		}
+		handler(); // may free memory, throw, or terminate
+	}
+}
+
+static void* allocate_or_null(std::size_t size, std::size_t alignment) noexcept {
+	try {
+		return allocate_or_throw(size, alignment);
+	} catch (const std::bad_alloc& /*err*/) {
+		return nullptr;
+	}
+}
+
+static void deallocate(void* ptr) noexcept {
+	if (ptr) {
+		heap_in_use.fetch_sub(block_size(ptr), std::memory_order_relaxed);
+		std::free(ptr);
+	}
+}
+
+
+void* operator new(std::size_t size) { return allocate_or_throw(size, 0); }
+void* operator new[](std::size_t size) { return allocate_or_throw(size, 0); }
+void* operator new(std::size_t size, const std::nothrow_t& /*tag*/) noexcept { return allocate_or_null(size, 0); }
+void* operator new[](std::size_t size, const std::nothrow_t& /*tag*/) noexcept { return allocate_or_null(size, 0); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocate_or_throw(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocate_or_throw(size, static_cast<std::size_t>(alignment)); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t& /*tag*/) noexcept { return allocate_or_null(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t& /*tag*/) noexcept { return allocate_or_null(size, static_cast<std::size_t>(alignment)); }
+
+void operator delete(void* ptr) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr) noexcept { deallocate(ptr); }
+void operator delete(void* ptr, std::size_t /*size*/) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr, std::size_t /*size*/) noexcept { deallocate(ptr); }
+void operator delete(void* ptr, const std::nothrow_t& /*tag*/) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t& /*tag*/) noexcept { deallocate(ptr); }
+void operator delete(void* ptr, std::align_val_t /*alignment*/) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr, std::align_val_t /*alignment*/) noexcept { deallocate(ptr); }
+void operator delete(void* ptr, std::size_t /*size*/, std::align_val_t /*alignment*/) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr, std::size_t /*size*/, std::align_val_t /*alignment*/) noexcept { deallocate(ptr); }
+void operator delete(void* ptr, std::align_val_t /*alignment*/, const std::nothrow_t& /*tag*/) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr, std::align_val_t /*alignment*/, const std::nothrow_t& /*tag*/) noexcept { deallocate(ptr); }
+
+
+HeapStatistics accounting::get_heap_statistics() {
+	HeapStatistics result;
+	result.in_use = heap_in_use.load(std::memory_order_relaxed);
+	result.peak = heap_peak.load(std::memory_order_relaxed);
+	result.allocations = heap_allocations.load(std::memory_order_relaxed);
+	return result;
+}
+
+void accounting::reset_heap_peak() {
+	heap_peak.store(heap_in_use.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void accounting::set_memory_limit(std::size_t bytes) {
+	memory_limit.store(bytes, std::memory_order_relaxed);
+}
+
+std::size_t accounting::get_peak_rss() {
+	char buffer[4096];
+	if (read_proc("/proc/self/status", buffer)) {
+		if (const char* entry = std::strstr(buffer, "VmHWM:")) {
+			return std::strtoull(entry + std::strlen("VmHWM:"), nullptr, 10) * 1024;
+		}
+	}
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+		return usage.ru_maxrss * 1024;
+	}
+	return 0;
+}
+
+void accounting::reset_peak_rss() {
+	// resets the high water mark 'VmHWM' to the current resident set size
+	int fd = open("/proc/self/clear_refs", O_WRONLY);
+	if (fd >= 0) {
+		ssize_t count = write(fd, "5", 1);
+		(void) count;
+		close(fd);
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#ifndef SEAL_MEMORY
+#define SEAL_MEMORY
+
+#include <cstddef>
+
+
+namespace accounting {
+
+	/** Heap memory allocated through 'new' by all threads of the process, measured in sizes of the underlying 'malloc' blocks.
+	  * Memory that z3 or the C library allocate directly is not included.
+	  * Accounting replaces the global 'operator new' and 'operator delete'; only executables compiling 'Memory.cpp' pay for it.
+	  */
+	struct HeapStatistics {
+		std::size_t in_use = 0;
+		std::size_t peak = 0; // since the last 'reset_heap_peak'
+		std::size_t allocations = 0; // since program start
+	};
+
+	HeapStatistics get_heap_statistics();
+
+	/** Lets the peak start over from the memory currently in use.
+	  */
+	void reset_heap_peak();
+
+	/** Allocations through 'new' fail if they would bring the heap in use above 'bytes', or if the resident set size
+	  * exceeds 'bytes'. The latter covers memory allocated by z3 and is checked only every 1024 allocations. As usual,
+	  * a failing allocation calls the 'std::new_handler' until it succeeds, or throws 'std::bad_alloc' if there is none
+	  * ('nullptr' for the 'nothrow' variants). Zero disables the limit (default).
+	  */
+	void set_memory_limit(std::size_t bytes);
+
+	/** Peak resident set size of the process in bytes since program start or the last 'reset_peak_rss'; 0 if unavailable.
+	  */
+	std::size_t get_peak_rss();
+
+	/** Lets the peak resident set size start over from the current one. Linux only; elsewhere, the peak never restarts.
+	  */
+	void reset_peak_rss();
+
+} // namespace accounting
+
+#endif